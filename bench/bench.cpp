@@ -0,0 +1,315 @@
+/**
+ * @file bench.cpp
+ * @brief Benchmark driver for the scan, classify, token-count and move hot paths.
+ *
+ * Generates a synthetic tree (see `treeGenerator.hpp`), then times each
+ * phase of a clean run separately using the same functions the engines
+ * call. Results are written as one JSON object, to stdout or `--output`.
+ *
+ * The `extension`, `nameFold` and `nameFoldScalar` phases are
+ * microbenchmarks of the file-name kernels (`nameKernel.hpp`) on the
+ * scanned names: extension lookup, and batch lowercasing plus token
+ * splitting against the byte-at-a-time loop they replace.
+ *
+ * Usage:
+ *
+ *     clean-bench [--files N] [--dirs N] [--file-size BYTES] [--seed S]
+ *                 [--threads N] [--move-jobs N] [--repeat N]
+ *                 [--dir PATH] [--keep] [--no-move] [--output FILE]
+ *
+ * Run it from the repository root so the JSON files in `data/` are picked up.
+ */
+
+#include "treeGenerator.hpp"
+
+#include "classifier.hpp"
+#include "fileTypes.hpp"
+#include "ignoreTokens.hpp"
+#include "json.hpp"
+#include "nameKernel.hpp"
+#include "planner.hpp"
+#include "scanner.hpp"
+#include "tokenIndex.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct BenchOptions
+    {
+        TreeSpec tree;
+        unsigned threads = 0;
+        unsigned moveJobs = 1;
+        int repeat = 3;
+        fs::path dir;
+        bool keep = false;
+        bool move = true;
+        std::string output;
+    };
+
+    void printUsage(std::ostream &out)
+    {
+        out << "Usage: clean-bench [options]\n"
+            << "  --files N         Files to generate (default: 10000)\n"
+            << "  --dirs N          Spread files over N subdirectories (default: flat)\n"
+            << "  --file-size BYTES Bytes written to every file (default: 0)\n"
+            << "  --seed S          Random seed (default: 42)\n"
+            << "  --threads N       Scanner threads (default: all cores)\n"
+            << "  --move-jobs N     Concurrent moves in the move phase (default: 1)\n"
+            << "  --repeat N        Runs of each read-only phase; the fastest is reported (default: 3)\n"
+            << "  --dir PATH        Generate the tree here (a new or empty directory) instead of a temporary one\n"
+            << "  --keep            Do not delete the temporary tree afterwards\n"
+            << "  --no-move         Skip the (destructive) move phase\n"
+            << "  --output FILE     Write the JSON results to FILE instead of stdout\n";
+    }
+
+    bool parseNumber(const std::string &text, std::uint64_t &value)
+    {
+        try
+        {
+            std::size_t used = 0;
+            unsigned long long parsed = std::stoull(text, &used);
+            if (used != text.size() || text[0] == '-')
+                return false;
+            value = parsed;
+            return true;
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    /// Fastest of `repeat` runs of `fn`, in seconds.
+    double timeBest(int repeat, const std::function<void()> &fn)
+    {
+        double best = 0;
+        for (int r = 0; r < std::max(1, repeat); ++r)
+        {
+            auto start = Clock::now();
+            fn();
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            if (r == 0 || seconds < best)
+                best = seconds;
+        }
+        return best;
+    }
+
+    json phase(double seconds, std::size_t items)
+    {
+        return {{"seconds", seconds},
+                {"items", items},
+                {"itemsPerSecond", seconds > 0 ? items / seconds : 0.0}};
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions opt;
+    std::vector<std::string> args(argv + 1, argv + argc);
+    for (std::size_t i = 0; i < args.size(); ++i)
+    {
+        const std::string &arg = args[i];
+        auto value = [&](std::uint64_t &out) {
+            return i + 1 < args.size() && parseNumber(args[++i], out);
+        };
+        std::uint64_t n = 0;
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage(std::cout);
+            return 0;
+        }
+        else if (arg == "--keep")
+            opt.keep = true;
+        else if (arg == "--no-move")
+            opt.move = false;
+        else if (arg == "--dir" && i + 1 < args.size())
+            opt.dir = args[++i];
+        else if (arg == "--output" && i + 1 < args.size())
+            opt.output = args[++i];
+        else if (arg == "--files" && value(n))
+            opt.tree.files = n;
+        else if (arg == "--dirs" && value(n))
+            opt.tree.directories = n;
+        else if (arg == "--file-size" && value(n))
+            opt.tree.fileSize = n;
+        else if (arg == "--seed" && value(n))
+            opt.tree.seed = n;
+        else if (arg == "--threads" && value(n))
+            opt.threads = static_cast<unsigned>(n);
+        else if (arg == "--move-jobs" && value(n))
+            opt.moveJobs = std::max<unsigned>(1, static_cast<unsigned>(n));
+        else if (arg == "--repeat" && value(n))
+            opt.repeat = static_cast<int>(n);
+        else
+        {
+            std::cerr << "Error: bad argument '" << arg << "'\n\n";
+            printUsage(std::cerr);
+            return 1;
+        }
+    }
+
+    bool tempDir = opt.dir.empty();
+    if (tempDir)
+        opt.dir = fs::temp_directory_path() / ("clean-bench-" + std::to_string(std::random_device{}()));
+    else
+    {
+        // The move phase reorganizes everything under --dir, so never run on existing files
+        std::error_code ec;
+        if (fs::exists(opt.dir, ec) && !(fs::is_directory(opt.dir, ec) && fs::is_empty(opt.dir, ec)))
+        {
+            std::cerr << "Error: --dir " << opt.dir.string() << " exists and is not an empty directory\n";
+            return 1;
+        }
+    }
+
+    // The data loaders print notices to stdout; keep stdout clean for the JSON
+    std::streambuf *savedOut = std::cout.rdbuf(std::cerr.rdbuf());
+    const auto &fileTypes = getFileTypes();
+    const auto &ignoreTokens = getIgnoreTokens();
+    const ExtClassifier &classifier = getClassifier();
+    std::cout.rdbuf(savedOut);
+
+    json results;
+    results["config"] = {{"files", opt.tree.files},
+                         {"directories", opt.tree.directories},
+                         {"fileSize", opt.tree.fileSize},
+                         {"seed", opt.tree.seed},
+                         {"threads", opt.threads},
+                         {"moveJobs", opt.moveJobs},
+                         {"repeat", opt.repeat},
+                         {"dir", opt.dir.string()}};
+
+    // Generate
+    std::size_t created = 0;
+    double seconds = timeBest(1, [&] {
+        created = generateTree(opt.dir, opt.tree, fileTypes, ignoreTokens);
+    });
+    json phases;
+    phases["generate"] = phase(seconds, created);
+
+    // Scan
+    ScanOptions scan;
+    scan.recursive = opt.tree.directories > 0;
+    scan.threads = opt.threads;
+    FileTable files;
+    seconds = timeBest(opt.repeat, [&] { files = scanDirectory(opt.dir, scan); });
+    phases["scan"] = phase(seconds, files.size());
+    results["scanMemoryBytes"] = files.memoryUsage();
+
+    // Classify
+    std::size_t dangerous = 0;
+    seconds = timeBest(opt.repeat, [&] {
+        dangerous = 0;
+        for (std::size_t i = 0; i < files.size(); ++i)
+            dangerous += classifier.classify(files.extension(i)).dangerous;
+    });
+    phases["classify"] = phase(seconds, files.size());
+
+    // Name kernels: extension lookup, then folding and splitting every stem
+    std::size_t checksum = 0;
+    seconds = timeBest(opt.repeat, [&] {
+        checksum = 0;
+        for (std::size_t i = 0; i < files.size(); ++i)
+            checksum += extensionLength(files.name(i));
+    });
+    phases["extension"] = phase(seconds, files.size());
+
+    std::size_t nameTokens = 0;
+    seconds = timeBest(opt.repeat, [&] {
+        NameBatch batch;
+        nameTokens = 0;
+        for (std::size_t first = 0; first < files.size(); first += NameBatchSize)
+        {
+            foldStems(files, first, std::min(files.size(), first + NameBatchSize), false, batch);
+            nameTokens += batch.tokens.size();
+        }
+    });
+    phases["nameFold"] = phase(seconds, files.size());
+
+    std::size_t scalarTokens = 0;
+    seconds = timeBest(opt.repeat, [&] {
+        std::string lower;
+        scalarTokens = 0;
+        for (std::size_t i = 0; i < files.size(); ++i)
+        {
+            std::string_view stem = files.stem(i);
+            lower.resize(stem.size());
+            std::size_t run = 0;
+            for (std::size_t k = 0; k < stem.size(); ++k)
+            {
+                auto c = static_cast<unsigned char>(stem[k]);
+                lower[k] = static_cast<char>((c >= 'A' && c <= 'Z') ? c | 0x20 : c);
+                bool token = (lower[k] >= '0' && lower[k] <= '9') || (lower[k] >= 'a' && lower[k] <= 'z');
+                scalarTokens += !token && run > 0;
+                run = token ? run + 1 : 0;
+            }
+            scalarTokens += run > 0;
+        }
+    });
+    phases["nameFoldScalar"] = phase(seconds, files.size());
+    results["nameKernel"] = {{"isa", nameKernelIsa()}, {"tokens", nameTokens}, {"scalarTokens", scalarTokens},
+                             {"extensionBytes", checksum}};
+
+    // Plan (classify plus conflict resolution and destination listing)
+    MovePlan plan;
+    seconds = timeBest(opt.repeat, [&] { plan = planByType(opt.dir, files); });
+    phases["plan"] = phase(seconds, plan.moves.size());
+
+    // Token count (auto-detect of cleanFilesByName)
+    std::unordered_set<std::string> ignore(ignoreTokens.begin(), ignoreTokens.end());
+    std::size_t tokens = 0;
+    std::size_t common = 0;
+    seconds = timeBest(opt.repeat, [&] {
+        TokenIndex index = buildTokenIndex(files, ignore);
+        tokens = index.size();
+        common = commonTokens(index).size();
+    });
+    phases["tokenCount"] = phase(seconds, files.size());
+    results["tokens"] = {{"distinct", tokens}, {"common", common}};
+
+    // Move (destructive, run once)
+    if (opt.move)
+    {
+        MoveResult moved;
+        seconds = timeBest(1, [&] { moved = executePlan(plan, opt.moveJobs); });
+        phases["move"] = phase(seconds, moved.moved);
+        results["moveSkipped"] = moved.skipped;
+    }
+
+    results["phases"] = phases;
+    results["dangerous"] = dangerous;
+
+    // A tree generated into a user-supplied --dir is never deleted
+    if (tempDir && !opt.keep)
+    {
+        std::error_code ec;
+        fs::remove_all(opt.dir, ec);
+    }
+
+    if (opt.output.empty())
+    {
+        std::cout << results.dump(2) << "\n";
+        return 0;
+    }
+    std::ofstream out(opt.output);
+    out << results.dump(2) << "\n";
+    if (!out)
+    {
+        std::cerr << "Error: could not write " << opt.output << "\n";
+        return 1;
+    }
+    return 0;
+}
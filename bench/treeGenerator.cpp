@@ -0,0 +1,131 @@
+/**
+ * @file treeGenerator.cpp
+ * @brief Implementation of the synthetic tree generator.
+ *
+ * @see treeGenerator.hpp
+ */
+
+#include "treeGenerator.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    /// Relative share of each category; unlisted categories get 1.
+    int categoryWeight(const std::string &category)
+    {
+        if (category == "Images")
+            return 30;
+        if (category == "Documents")
+            return 20;
+        if (category == "Audio")
+            return 12;
+        if (category == "Videos")
+            return 10;
+        if (category == "Code")
+            return 8;
+        if (category == "Archives")
+            return 6;
+        return 1;
+    }
+
+    /// A pronounceable lowercase word of 3 to 9 letters.
+    std::string makeWord(std::mt19937_64 &rng)
+    {
+        static const char consonants[] = "bcdfghjklmnprstvwz";
+        static const char vowels[] = "aeiou";
+        std::size_t length = 3 + rng() % 7;
+        std::string word;
+        for (std::size_t i = 0; i < length; ++i)
+            word += (i % 2 == 0) ? consonants[rng() % (sizeof(consonants) - 1)]
+                                 : vowels[rng() % (sizeof(vowels) - 1)];
+        return word;
+    }
+
+    /// Lowercase base-36 rendering of `n`.
+    std::string base36(std::size_t n)
+    {
+        std::string out;
+        do
+        {
+            out.insert(out.begin(), "0123456789abcdefghijklmnopqrstuvwxyz"[n % 36]);
+            n /= 36;
+        } while (n);
+        return out;
+    }
+}
+
+std::size_t generateTree(const fs::path &root, const TreeSpec &spec,
+                         const std::map<std::string, std::vector<std::string>> &fileTypes,
+                         const std::vector<std::string> &noise)
+{
+    std::mt19937_64 rng(spec.seed);
+
+    std::vector<std::string> words;
+    words.reserve(spec.vocabulary);
+    for (std::size_t i = 0; i < spec.vocabulary; ++i)
+        words.push_back(makeWord(rng));
+
+    // Flatten the categories into one weighted extension table
+    std::vector<const std::string *> exts;
+    std::vector<double> weights;
+    for (const auto &[category, list] : fileTypes)
+        for (const auto &ext : list)
+        {
+            exts.push_back(&ext);
+            weights.push_back(static_cast<double>(categoryWeight(category)) / list.size());
+        }
+    std::discrete_distribution<std::size_t> pickExt(weights.begin(), weights.end());
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    std::vector<fs::path> dirs;
+    std::error_code ec;
+    fs::create_directories(root, ec);
+    if (spec.directories == 0)
+        dirs.push_back(root);
+    for (std::size_t d = 0; d < spec.directories; ++d)
+    {
+        std::string name = "d";
+        name += base36(d);
+        dirs.push_back(root / name);
+        fs::create_directory(dirs.back(), ec);
+    }
+
+    static const char separators[] = " _-.";
+    std::string payload(spec.fileSize, 'x');
+    std::size_t created = 0;
+
+    for (std::size_t i = 0; i < spec.files; ++i)
+    {
+        std::string stem;
+        std::size_t parts = 1 + rng() % 3;
+        for (std::size_t p = 0; p < parts; ++p)
+        {
+            if (p)
+                stem += separators[rng() % (sizeof(separators) - 1)];
+            double r = unit(rng);
+            if (!noise.empty() && r < 0.15)
+                stem += noise[rng() % noise.size()];
+            else if (r < 0.25)
+                stem += std::to_string(rng() % 10000);
+            else // cubed uniform: a few words are very common, most are rare
+                stem += words[static_cast<std::size_t>(std::pow(unit(rng), 3.0) * words.size()) % words.size()];
+        }
+        stem += '_';
+        stem += base36(i); // keeps names unique within a directory
+
+        std::string ext = exts.empty() ? std::string(".bin") : *exts[pickExt(rng)];
+        fs::path file = dirs[i % dirs.size()] / (stem + ext);
+
+        if (std::FILE *out = std::fopen(file.string().c_str(), "wb"))
+        {
+            if (!payload.empty())
+                std::fwrite(payload.data(), 1, payload.size(), out);
+            std::fclose(out);
+            ++created;
+        }
+    }
+    return created;
+}
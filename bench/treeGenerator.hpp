@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @file treeGenerator.hpp
+ * @brief Synthetic directory trees for the benchmark target.
+ *
+ * Generated trees mimic a messy downloads folder: extensions are drawn
+ * from the categories in `data/fileTypes.json` with a skewed,
+ * photo/document-heavy weighting, and stems are made of a few words drawn
+ * from a Zipf-like vocabulary mixed with the noise words from
+ * `data/ignoreTokens.json`, numbers and a unique counter. The same seed
+ * always produces the same tree.
+ */
+
+/**
+ * @brief Shape of a synthetic tree.
+ */
+struct TreeSpec
+{
+    std::size_t files = 10000;      ///< Number of files to create.
+    std::size_t directories = 0;    ///< Subdirectories to spread files over (0 = flat).
+    std::size_t fileSize = 0;       ///< Bytes written to every file.
+    std::size_t vocabulary = 2000;  ///< Distinct name words.
+    std::uint64_t seed = 42;        ///< Random seed.
+};
+
+/**
+ * @brief Create a synthetic tree below `root`.
+ *
+ * @param root      Directory to fill; created when missing.
+ * @param spec      Tree shape.
+ * @param fileTypes Category → extensions map (as from `getFileTypes()`).
+ * @param noise     Words mixed into names (as from `getIgnoreTokens()`).
+ * @return std::size_t Number of files actually created.
+ */
+std::size_t generateTree(const fs::path &root, const TreeSpec &spec,
+                         const std::map<std::string, std::vector<std::string>> &fileTypes,
+                         const std::vector<std::string> &noise);
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "routeRules.hpp"
+
+/**
+ * @file classifier.hpp
+ * @brief Precomputed extension → category classifier.
+ *
+ * `ExtClassifier` folds the category → extensions mapping from
+ * `getFileTypes()` and the list from `getDangerousExts()` into one flat,
+ * open-addressing hash table. Extensions are packed into two 64-bit words
+ * (lowercased on the fly), so a lookup is a hash, usually a single probe and
+ * two integer compares: no allocation and no string comparisons.
+ *
+ * The classifier also carries the compiled routing rules (`routes()`),
+ * which can send a file of a category to another folder by size or age.
+ *
+ * The implementation lives in `src/classifier.cpp`.
+ */
+
+/// Index of a category in `ExtClassifier::categoryName()`.
+using CategoryId = std::uint16_t;
+
+/**
+ * @brief Result of classifying one extension.
+ */
+struct Classification
+{
+    CategoryId category; ///< Category the extension belongs to ("Other" when unknown).
+    bool dangerous;      ///< True when the extension is listed in the dangerous set.
+};
+
+/**
+ * @brief Immutable extension classifier built once from the rule data.
+ */
+class ExtClassifier
+{
+public:
+    /// Longest extension (including the leading dot) that can be classified.
+    static constexpr std::size_t MaxExtLength = 16;
+
+    /**
+     * @brief Build the lookup table.
+     *
+     * Categories are numbered in the iteration order of `fileTypes`; an
+     * "Other" category is appended when the mapping does not define one.
+     * When an extension appears in several categories the last one wins,
+     * matching the previous `std::map` based lookup.
+     *
+     * @param fileTypes     Category → extension list (extensions with dot).
+     * @param dangerousExts Extensions (with dot) to flag as dangerous.
+     * @param routes        Routing rules, compiled against the categories.
+     */
+    ExtClassifier(const std::map<std::string, std::vector<std::string>> &fileTypes,
+                  const std::vector<std::string> &dangerousExts,
+                  const std::vector<RouteRule> &routes = {});
+
+    /**
+     * @brief Classify an extension.
+     *
+     * @param ext Extension including the leading dot, in any letter case
+     *            (as returned by `fs::path::extension()`).
+     * @return Classification Category id and dangerous flag. Unknown, empty
+     *         or over-long extensions map to the "Other" category.
+     */
+    Classification classify(std::string_view ext) const;
+
+    /// Name of a category, e.g. "Images".
+    const std::string &categoryName(CategoryId id) const { return names_[id]; }
+
+    /// Number of categories, including "Other".
+    std::size_t categoryCount() const { return names_.size(); }
+
+    /// Id of the fallback "Other" category.
+    CategoryId otherCategory() const { return other_; }
+
+    /**
+     * @brief Look up a category by name.
+     *
+     * @param name Category name.
+     * @return CategoryId Matching id, or `otherCategory()` when not found.
+     */
+    CategoryId findCategory(std::string_view name) const;
+
+    /// ANSI color used when printing files of a category (see `colors.hpp`).
+    const std::string &colorFor(CategoryId id) const { return *colors_[id]; }
+
+    /// Routing rules that override the category folder of some files.
+    const RouteTable &routes() const { return routes_; }
+
+private:
+    /// One open-addressing slot; an all-zero key marks an empty slot.
+    struct Slot
+    {
+        std::uint64_t lo = 0;
+        std::uint64_t hi = 0;
+        CategoryId category = 0;
+        bool dangerous = false;
+    };
+
+    void insert(std::string_view ext, CategoryId category, bool setCategory, bool dangerous);
+
+    std::vector<Slot> slots_;
+    std::size_t mask_ = 0;
+    std::vector<std::string> names_;
+    std::vector<const std::string *> colors_;
+    CategoryId other_ = 0;
+    RouteTable routes_;
+};
+
+/**
+ * @brief Get the process-wide classifier.
+ *
+ * The classifier of the current `RuleSet` (see `ruleSet.hpp`), built on
+ * first use from `getFileTypes()` and `getDangerousExts()`. Later calls
+ * return the same instance until the rules are reloaded; a reference taken
+ * earlier stays valid after a reload.
+ *
+ * @return const ExtClassifier& Reference to the shared classifier.
+ */
+const ExtClassifier &getClassifier();
@@ -3,6 +3,8 @@
 #include <vector>
 #include <string>
 
+#include "../options.hpp"
+
 namespace fs = std::filesystem;
 
 /**
@@ -23,9 +25,17 @@ namespace fs = std::filesystem;
  * files are moved into subdirectories named after the detected token.
  *
  * @param directoryPath Path to the directory to scan and organize.
+ * @param options       Run-time options. In non-interactive mode the
+ *                      search string is taken from `options.token`
+ *                      (empty means auto-detect) instead of being read
+ *                      from `std::cin`. `options.tokens` adds more
+ *                      search strings, all matched in a single pass.
+ * @return bool False when the directory is invalid, the journal could not
+ *              be written or a move failed; true otherwise (also for a dry
+ *              run, a cancelled run or nothing to move).
  *
  * @note The implementation may consult an ignore token list to avoid
  *       grouping by common stop-words. It may also prompt the user
  *       for confirmation before moving files.
  */
-void cleanFilesByName(const fs::path &directoryPath);
+bool cleanFilesByName(const fs::path &directoryPath, const CleanOptions &options = {});
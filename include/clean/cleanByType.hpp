@@ -4,6 +4,8 @@
 #include <vector>
 #include <map>
 
+#include "../options.hpp"
+
 namespace fs = std::filesystem;
 
 /**
@@ -27,8 +29,38 @@ namespace fs = std::filesystem;
  * as needed.
  *
  * @param directoryPath Path to the directory to scan and organize.
+ * @param options       Run-time options; pass `interactive = false` to run
+ *                      without screen clears or the closing pause.
+ * @return bool False when the directory is invalid, the journal could not
+ *              be written or a move failed; true otherwise (also for a dry
+ *              run, a cancelled run or nothing to move).
  *
  * @note The function may output progress or warnings to `std::cout`
  *       / `std::cerr` and uses color constants from `colors.hpp`.
  */
-void cleanFilesByType(const fs::path &directoryPath);
+bool cleanFilesByType(const fs::path &directoryPath, const CleanOptions &options = {});
+
+/**
+ * @brief Stay resident and organize files as they arrive in a directory.
+ *
+ * Subscribes to change notifications (see `DirectoryWatcher`) and, for
+ * every debounced batch of newly written or renamed files, builds and
+ * executes the same type plan as `cleanFilesByType()`. Files already in the
+ * directory are left alone. Idle directories cost no CPU; a file is
+ * normally in place well under a second after it was closed.
+ *
+ * The rules are reloaded before a batch when a JSON file in `data/`
+ * changed (see `reloadRulesIfChanged()`); after SIGHUP the batch also
+ * reports when nothing changed.
+ *
+ * Runs until SIGINT or SIGTERM. Honors `dryRun` (plans are only printed),
+ * `destination`, `moveJobs`, `journalFile` (one journal for the whole
+ * session) and `quarantine`; quarantined files of all batches share one
+ * `QuarantineScanner` queue. The watch is not recursive.
+ *
+ * @param directoryPath Directory to watch.
+ * @param options       Run-time options.
+ * @return bool False when the watch could not start or was lost, or when a
+ *              journal write or a move of any batch failed.
+ */
+bool watchFilesByType(const fs::path &directoryPath, const CleanOptions &options = {});
@@ -0,0 +1,41 @@
+#pragma once
+#include <csignal>
+
+#include "../libclean.hpp"
+
+/**
+ * @file consoleProgress.hpp
+ * @brief Terminal progress line and Ctrl+C cancellation for the interactive engines.
+ *
+ * The TUI runs the organizer through `sharedSession()` like any other
+ * client; a `ConsoleProgress` supplies the `RunControl` of one operation.
+ *
+ * The implementation lives in `src/clean/consoleProgress.cpp`.
+ */
+
+/**
+ * @brief Progress and cancellation of one interactive operation.
+ *
+ * While an active instance is alive, SIGINT cancels the operation (moves
+ * in flight complete, the rest are skipped) instead of ending the program,
+ * and each phase is shown on one line that is rewritten in place
+ * ("Scanning: 1200 files", "Moving: 800/5000"). An inactive instance
+ * gives an empty `RunControl`.
+ */
+class ConsoleProgress
+{
+public:
+    explicit ConsoleProgress(bool active);
+    ~ConsoleProgress();
+
+    ConsoleProgress(const ConsoleProgress &) = delete;
+    ConsoleProgress &operator=(const ConsoleProgress &) = delete;
+
+    /// Control to pass to the session calls.
+    const RunControl &control() const { return control_; }
+
+private:
+    bool active_;
+    RunControl control_;
+    void (*previous_)(int) = SIG_DFL;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+/**
+ * @file cli.hpp
+ * @brief Non-interactive, argv-driven entry point.
+ *
+ * When `clean` is started with arguments it bypasses the menu-driven TUI
+ * and runs a single operation described on the command line, e.g.
+ *
+ *     clean type <dir>
+ *     clean name <dir> --token X
+ *     clean list <dir>
+ *     clean jobs <manifest>
+ *
+ * No prompts are shown and the screen is never cleared, so the tool can be
+ * driven from cron or other batch jobs without a terminal.
+ */
+
+/**
+ * @brief Parse the command line and run the requested operation.
+ *
+ * @param argc Argument count as passed to `main()`.
+ * @param argv Argument vector as passed to `main()`.
+ * @return int Process exit status: 0 on success, 1 on a usage error,
+ *             2 when the target directory is missing or invalid, 3
+ *             when a root of `clean jobs` failed and 4 when a move of
+ *             `type`, `name` or `--watch` failed or the journal could not
+ *             be written.
+ */
+int runCli(int argc, char *argv[]);
@@ -2,9 +2,13 @@
  * @file colors.hpp
  * @brief ANSI terminal color constants used by the CLI.
  *
- * This header defines a small set of ANSI escape sequence string
- * constants for coloring and styling console output. They are
- * intended for use in simple terminal UIs and logging messages.
+ * This header defines a small set of ANSI escape sequence strings for
+ * coloring and styling console output. They are intended for use in
+ * simple terminal UIs and logging messages.
+ *
+ * `initColors()` empties all of them when standard output is not a
+ * terminal or `NO_COLOR` is set, so output that is piped to a file or a
+ * log collector carries no escape codes.
  *
  * @note These codes are standard on most UNIX-like terminal emulators.
  *       On Windows consoles prior to Windows 10 the escape sequences
@@ -14,31 +18,44 @@
 #include <string>
 
 /** Reset all attributes (colors and styles). */
-const std::string RESET   = "\033[0m";
+inline std::string RESET   = "\033[0m";
 
 /** Bold text style. */
-const std::string BOLD    = "\033[1m";
+inline std::string BOLD    = "\033[1m";
 
 /** Dim text style. */
-const std::string DIM     = "\033[2m";
+inline std::string DIM     = "\033[2m";
 
 /** Red foreground color. */
-const std::string RED     = "\033[31m";
+inline std::string RED     = "\033[31m";
 
 /** Green foreground color. */
-const std::string GREEN   = "\033[32m";
+inline std::string GREEN   = "\033[32m";
 
 /** Yellow foreground color. */
-const std::string YELLOW  = "\033[33m";
+inline std::string YELLOW  = "\033[33m";
 
 /** Blue foreground color. */
-const std::string BLUE    = "\033[34m";
+inline std::string BLUE    = "\033[34m";
 
 /** Magenta foreground color. */
-const std::string MAGENTA = "\033[35m";
+inline std::string MAGENTA = "\033[35m";
 
 /** Cyan foreground color. */
-const std::string CYAN    = "\033[36m";
+inline std::string CYAN    = "\033[36m";
 
 /** White foreground color. */
-const std::string WHITE   = "\033[37m";
+inline std::string WHITE   = "\033[37m";
+
+/**
+ * @brief Turn colors off unless standard output is a terminal.
+ *
+ * Colors are also turned off when the `NO_COLOR` environment variable is
+ * set. Call once at startup, before any output.
+ */
+void initColors();
+
+/**
+ * @brief Empty every color constant, so they print nothing.
+ */
+void disableColors();
@@ -5,6 +5,8 @@
 #include <iostream>
 #include "json.hpp"
 #include "colors.hpp"
+#include "ruleSet.hpp"
+#include "defaultRules.hpp"
 
 using json = nlohmann::json;
 
@@ -16,7 +18,8 @@ using json = nlohmann::json;
  * content that may be risky to move or execute automatically. This
  * header exposes a helper to load a project-local JSON override
  * (`data/dangerousExts.json`) and falls back to a built-in list when
- * the file is absent or cannot be parsed.
+ * the file is absent or cannot be parsed. The loaded list is part of the
+ * shared `RuleSet`.
  */
 
 /**
@@ -24,15 +27,10 @@ using json = nlohmann::json;
  *
  * Extensions include common executable, script, and macro-enabled
  * document formats. Each entry contains the leading dot (e.g. ".exe").
+ * Generated into `defaultRules.hpp` from `data/dangerousExts.json`.
  */
-static const std::vector<std::string> DEFAULT_DANGEROUS_EXTS = {
-    ".exe", ".dll", ".com", ".msi", ".bin", ".sys",
-    ".bat", ".cmd", ".vbs", ".js", ".jse", ".wsf", ".wsh",
-    ".ps1", ".psm1", ".sh", ".bash", ".zsh",
-    ".lnk", ".inf", ".msu", ".msp",
-    ".docm", ".xlsm", ".pptm",
-    ".scr", ".pif", ".jar", ".reg"
-};
+static const std::vector<std::string> DEFAULT_DANGEROUS_EXTS(defaultRules::dangerousExts.begin(),
+                                                             defaultRules::dangerousExts.end());
 
 /**
  * @brief Load the dangerous-extension list.
@@ -45,10 +43,10 @@ static const std::vector<std::string> DEFAULT_DANGEROUS_EXTS = {
  * @return A vector of extensions (each including the leading dot).
  *
  * @note The function prints warnings using color constants from
- *       `colors.hpp`. This helper is inline and intended for simple
- *       use in the CLI flow.
+ *       `colors.hpp`. It reads the file on every call; use
+ *       `getDangerousExts()` for the cached list.
  */
-inline std::vector<std::string> getDangerousExts()
+inline std::vector<std::string> loadDangerousExts()
 {
     try
     {
@@ -75,3 +73,13 @@ inline std::vector<std::string> getDangerousExts()
         return DEFAULT_DANGEROUS_EXTS;
     }
 }
+
+/**
+ * @brief The dangerous-extension list of the current `RuleSet`.
+ *
+ * Loaded once by `loadDangerousExts()`; lock-free afterwards.
+ */
+inline const std::vector<std::string> &getDangerousExts()
+{
+    return currentRules().dangerousExts;
+}
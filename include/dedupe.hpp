@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "planner.hpp"
+
+/**
+ * @file dedupe.hpp
+ * @brief Detection of files whose content already exists at the destination.
+ *
+ * Re-downloads such as `song (1).mp3` used to be moved as separate files,
+ * and same-name copies were only reported as conflicts. `findDuplicates()`
+ * compares the files of a plan with each other and with the files already
+ * present in the destination directories, and marks every file whose
+ * content is already kept elsewhere as `MoveStatus::Identical`.
+ *
+ * Work is done in widening stages so most files are never read:
+ * 1. files are bucketed by size (one `stat()` each), and unique sizes are dropped;
+ * 2. the first and last `HeadTailBytes` of each remaining file are hashed;
+ * 3. only files that still collide and are larger than both ends are
+ *    hashed in full;
+ * 4. each remaining file is compared byte for byte with the copy that is
+ *    kept, so a hash collision never marks two different files.
+ *
+ * Hashing uses XXH64 (chained over fixed blocks) and runs on a
+ * `ThreadPool`, one file per task.
+ *
+ * The implementation lives in `src/dedupe.cpp`.
+ */
+
+/**
+ * @brief What to do with files found to be identical.
+ */
+enum class DedupeMode
+{
+    Off,  ///< No content comparison (conflicts are decided by name only).
+    Skip, ///< Leave identical files where they are and report them.
+    Link  ///< Replace each identical file with a hard link to the copy that is kept.
+};
+
+/// Bytes hashed at each end of a file before deciding whether to read it in full.
+constexpr std::size_t HeadTailBytes = 64 * 1024;
+
+/**
+ * @brief Totals of one `findDuplicates()` pass.
+ */
+struct DedupeSummary
+{
+    std::size_t files = 0;        ///< Moves marked `MoveStatus::Identical`.
+    std::uint64_t bytes = 0;      ///< Their combined size.
+    std::size_t fullyHashed = 0;  ///< Files that had to be read in full.
+};
+
+/**
+ * @brief Mark the moves whose content is already present.
+ *
+ * Candidates are the ready and conflicting (`DestinationExists`,
+ * `DuplicateInPlan`) moves, plus the files already in the plan's
+ * destination directories. Within each group of identical files the kept
+ * copy is an existing destination file when there is one, otherwise the
+ * first ready move; every other move of the group becomes `Identical` with
+ * `duplicateOf` set to where the kept copy will be, and the size and
+ * modification times of both files recorded just before their bytes were
+ * compared (`executePlan()` links only if they still match). Empty files are never
+ * considered identical. Destination directories only needed by moves that
+ * became identical are dropped from `plan.directories`.
+ *
+ * @param plan    Finalized plan (see `finalizePlan()`), updated in place.
+ * @param mode    `Skip` or `Link`; recorded in `plan.linkDuplicates`.
+ * @param threads Hashing threads; 0 selects the hardware concurrency.
+ * @return DedupeSummary Number and size of the identical files.
+ */
+DedupeSummary findDuplicates(MovePlan &plan, DedupeMode mode, unsigned threads = 0);
@@ -0,0 +1,97 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @file defaultRules.hpp
+ * @brief Built-in rules as constexpr tables.
+ *
+ * Generated from the JSON files in `data/` by `clean compile-rules
+ * --header`; do not edit by hand. These tables are the fallback when a data
+ * file is missing and, with `CLEAN_EMBED_RULES`, the rules used without any
+ * file I/O.
+ */
+
+namespace defaultRules
+{
+
+/// One category: its name and a range of `extensions`.
+struct Category
+{
+    std::string_view name;
+    std::size_t first;
+    std::size_t count;
+};
+
+/// One routing rule: a range of `routeCategories` and its size and age bounds.
+struct Route
+{
+    std::string_view to;
+    std::size_t first;
+    std::size_t count;
+    std::uint64_t minSize;
+    std::uint64_t maxSize;
+    std::int64_t minAge;
+    std::int64_t maxAge;
+};
+
+inline constexpr std::array<std::string_view, 140> extensions = {
+    ".obj", ".fbx", ".stl", ".blend", ".3ds", ".dae", ".ply", ".gltf",
+    ".glb", ".zip", ".rar", ".7z", ".tar", ".gz", ".bz2", ".xz",
+    ".iso", ".dmg", ".tgz", ".cab", ".mp3", ".wav", ".flac", ".aac",
+    ".ogg", ".wma", ".m4a", ".opus", ".aiff", ".mid", ".midi", ".py",
+    ".js", ".html", ".css", ".c", ".cpp", ".h", ".hpp", ".java",
+    ".sh", ".ts", ".php", ".rb", ".go", ".swift", ".kt", ".rs",
+    ".lua", ".sql", ".json", ".xml", ".yml", ".yaml", ".cs", ".vb",
+    ".pl", ".asm", ".bat", ".cmd", ".ini", ".cfg", ".conf", ".jsonc",
+    ".toml", ".env", ".properties", ".iso", ".img", ".vhd", ".vhdx", ".vdi",
+    ".vmdk", ".pdf", ".doc", ".docx", ".txt", ".rtf", ".odt", ".csv",
+    ".xlsx", ".xls", ".ppt", ".pptx", ".epub", ".md", ".tex", ".pages",
+    ".numbers", ".key", ".ttf", ".otf", ".woff", ".woff2", ".eot", ".fon",
+    ".jpg", ".jpeg", ".png", ".gif", ".bmp", ".tiff", ".webp", ".heic",
+    ".heif", ".svg", ".ico", ".jfif", ".raw", ".arw", ".cr2", ".nef",
+    ".orf", ".dng", ".deb", ".rpm", ".apk", ".jar", ".whl", ".gem",
+    ".msi", ".srt", ".vtt", ".ass", ".ssa", ".sub", ".mp4", ".mov",
+    ".avi", ".mkv", ".wmv", ".flv", ".webm", ".mpeg", ".mpg", ".3gp",
+    ".m4v", ".ts", ".mts", ".vob",
+};
+
+inline constexpr std::array<Category, 13> fileTypes = {{
+    {"3D_Models", 0, 9},
+    {"Archives", 9, 11},
+    {"Audio", 20, 11},
+    {"Code", 31, 29},
+    {"Configs", 60, 7},
+    {"DiskImages", 67, 6},
+    {"Documents", 73, 17},
+    {"Fonts", 90, 6},
+    {"Images", 96, 18},
+    {"Other", 114, 0},
+    {"Packages", 114, 7},
+    {"Subtitles", 121, 5},
+    {"Videos", 126, 14},
+}};
+
+inline constexpr std::array<std::string_view, 29> dangerousExts = {
+    ".exe", ".dll", ".com", ".msi", ".bin", ".sys", ".bat", ".cmd",
+    ".vbs", ".js", ".jse", ".wsf", ".wsh", ".ps1", ".psm1", ".sh",
+    ".bash", ".zsh", ".lnk", ".inf", ".msu", ".msp", ".docm", ".xlsm",
+    ".pptm", ".scr", ".pif", ".jar", ".reg",
+};
+
+inline constexpr std::array<std::string_view, 30> ignoreTokens = {
+    "official", "lyrics", "video", "audio", "hd", "remix", "mv", "live",
+    "youtube", "ft", "feat", "2025", "720p", "1080", "1080p", "best",
+    "song", "songs", "360p", "featuring", "www", "com", "net", "org",
+    "sample", "256k", "season", "episode", "lyric", "music",
+};
+
+inline constexpr std::array<std::string_view, 0> routeCategories = {
+};
+
+inline constexpr std::array<Route, 0> routes = {{
+}};
+
+} // namespace defaultRules
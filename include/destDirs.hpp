@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+/**
+ * @file destDirs.hpp
+ * @brief Destination directories created, verified and opened once per run.
+ *
+ * `DestinationDirs` resolves every target directory of a plan exactly once.
+ * An existing directory costs one `openat()`; a missing one is created
+ * lazily together with its missing ancestors, each with one `mkdirat()`
+ * relative to its parent's handle, so a nested layout such as
+ * `Images/2026/10` creates (and checks) `Images` only the first time it is
+ * needed. The open handles are kept for the rest of the run so moves can
+ * target `renameat(dirFd, name)` without the kernel walking the directory
+ * path again (see `moveFileInto()`).
+ *
+ * At most half of the soft descriptor limit is kept open; directories past
+ * that are still created and verified once but moved into by path. On
+ * Windows directories are created with `fs::create_directories()` and no
+ * handles are kept.
+ *
+ * The implementation lives in `src/destDirs.cpp`.
+ */
+
+/**
+ * @brief Cache of destination directory handles; closed on destruction.
+ *
+ * Not thread-safe: resolve the directories first, then share the handles
+ * with concurrent movers.
+ */
+class DestinationDirs
+{
+public:
+    /// Returned for a directory that exists but is used by path.
+    static constexpr int NoHandle = -1;
+
+    DestinationDirs();
+    ~DestinationDirs();
+
+    DestinationDirs(const DestinationDirs &) = delete;
+    DestinationDirs &operator=(const DestinationDirs &) = delete;
+
+    /**
+     * @brief Make sure `dir` exists and return a handle to it.
+     *
+     * The first call for a directory creates what is missing; later calls,
+     * including ones that failed, are answered from the cache.
+     *
+     * @param dir Directory to resolve.
+     * @param ec  Set when the directory cannot be created or is not a directory.
+     * @return int Open directory descriptor, or `NoHandle` (also on failure).
+     */
+    int open(const fs::path &dir, std::error_code &ec);
+
+    /// Directories created by this instance.
+    std::size_t created() const { return created_; }
+
+private:
+    struct Entry
+    {
+        int fd = NoHandle;
+        std::error_code error;
+    };
+
+    const Entry &resolve(const fs::path &dir);
+
+    std::unordered_map<std::string, Entry> entries_;
+    std::size_t handles_ = 0;
+    std::size_t maxHandles_ = 0;
+    std::size_t created_ = 0;
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @file fileMove.hpp
+ * @brief Single-file move that also works across filesystems.
+ *
+ * A plain rename fails with `EXDEV` when source and destination live on
+ * different mounts. `moveFile()` detects that case and falls back to a
+ * kernel-side copy (`copy_file_range()` or `sendfile()` on Linux,
+ * `copyfile()` on macOS, `MoveFileEx()` with copy allowed on Windows),
+ * flushes the copy to disk and only then removes the source. File data is
+ * never streamed through a userspace buffer unless every kernel path is
+ * unavailable.
+ *
+ * The implementation lives in `src/fileMove.cpp`.
+ */
+
+/**
+ * @brief Move one regular file.
+ *
+ * Tries a rename first; it never replaces an existing destination (an
+ * `EEXIST` error is returned instead), so a file that appeared since the
+ * plan was made is not clobbered. When the destination is on another device the file
+ * is copied (preserving permission bits and modification time), synced,
+ * and the source is unlinked. A partially written destination is removed
+ * if the copy fails.
+ *
+ * @param source      File to move.
+ * @param destination Target path, including the file name; an existing
+ *                    file there is never overwritten.
+ * @return std::error_code Empty on success, otherwise the failure reason.
+ */
+std::error_code moveFile(const fs::path &source, const fs::path &destination);
+
+/**
+ * @brief `moveFile()` into a directory that is already open.
+ *
+ * The rename (or the cross-device copy) targets `destination`'s file name
+ * relative to `destDir`, so the kernel does not resolve the directory path
+ * again for every file. Handles come from `DestinationDirs` (see
+ * `destDirs.hpp`); they are ignored on Windows.
+ *
+ * @param source      File to move.
+ * @param destDir     Open descriptor of `destination`'s directory, or a
+ *                    negative value to move by path like `moveFile()`.
+ * @param destination Full target path, including the file name.
+ * @return std::error_code Empty on success, otherwise the failure reason.
+ */
+std::error_code moveFileInto(const fs::path &source, int destDir, const fs::path &destination);
+
+/**
+ * @brief Move many files, submitting the renames in batches.
+ *
+ * On Linux with io_uring the renames are queued in an `IoRing` with
+ * `RENAME_NOREPLACE` and sent to the kernel a ring at a time, one system
+ * call per batch. Moves across devices, filesystems without
+ * `RENAME_NOREPLACE`, and every other platform use `moveFile()` per file.
+ * When a submission fails the ring is dropped: renames the kernel never
+ * took, and all later moves, run through `moveFileInto()`; a rename it
+ * took but never reported counts as moved when its source is gone and its
+ * destination is in place.
+ *
+ * @param moves    Source and destination of each file; the paths must stay
+ *                 valid until the call returns.
+ * @param onDone   Called once per move, on the calling thread and in
+ *                 completion order, with the move's index and result.
+ * @param destDirs Optional open handle of each move's destination directory
+ *                 (negative = by path), as for `moveFileInto()`.
+ */
+void moveFilesBatched(const std::vector<std::pair<const fs::path *, const fs::path *>> &moves,
+                      const std::function<void(std::size_t, std::error_code)> &onDone,
+                      const std::vector<int> &destDirs = {});
@@ -14,6 +14,9 @@
 #include <vector>
 #include <string>
 
+#include "json.hpp"
+#include "routeRules.hpp"
+
 /**
  * @brief Load file type mappings from disk (or fallback).
  *
@@ -22,13 +25,30 @@
  * expected without a leading dot). If the JSON file cannot be read or
  * parsed, the function returns a sensible built-in fallback mapping.
  *
+ * @param routes When non-null, receives the routing rules of the file
+ *               (none with the fallback).
  * @return A map from file type name to a vector of extensions.
  *
  * @note The returned map is by-value to allow callers to take ownership
  *       if needed; the library also provides `getFileTypes()` which
  *       returns a cached reference for cheap lookups.
  */
-std::map<std::string, std::vector<std::string>> loadFileTypes();
+std::map<std::string, std::vector<std::string>> loadFileTypes(std::vector<RouteRule> *routes = nullptr);
+
+/**
+ * @brief Read a file types document: categories and routing rules.
+ *
+ * Every key maps a category to its extensions, except `"$routes"`, which
+ * holds the routing rules (see `routeRules.hpp`).
+ *
+ * @param j      Parsed document.
+ * @param types  Receives the category → extensions map.
+ * @param routes Receives the routing rules, in order.
+ * @param error  Receives a description of the first problem.
+ * @return bool False when the document is malformed.
+ */
+bool parseFileTypes(const nlohmann::json &j, std::map<std::string, std::vector<std::string>> &types,
+                    std::vector<RouteRule> &routes, std::string &error);
 
 /**
  * @brief Get the (cached) file type mapping.
@@ -39,8 +59,8 @@ std::map<std::string, std::vector<std::string>> loadFileTypes();
  *
  * @return Const reference to the file type → extensions map.
  *
- * @warning This function is not synchronized for multi-threaded use.
- *          If your program uses threads, protect access or modify the
- *          implementation to add locking.
+ * @note Thread-safe: the map belongs to the current `RuleSet` (see
+ *       `ruleSet.hpp`), which is loaded exactly once and never modified.
+ *       After `reloadRules()` the reference still points to the old set.
  */
 const std::map<std::string, std::vector<std::string>>& getFileTypes();
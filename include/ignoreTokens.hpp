@@ -6,6 +6,9 @@
 #include <iostream>
 #include <algorithm>
 #include "json.hpp"
+#include "colors.hpp"
+#include "ruleSet.hpp"
+#include "defaultRules.hpp"
 
 using json = nlohmann::json;
 using namespace std;
@@ -18,7 +21,7 @@ using namespace std;
  * - `getIgnoreTokens()` attempts to load additional tokens from
  *   `data/ignoreTokens.json` (key `ignoreTokens`) and falls back to the
  *   built-in list when the file is missing or invalid. Tokens are
- *   normalized to lowercase and cached on first access.
+ *   normalized to lowercase and cached in the shared `RuleSet`.
  */
 
 // -------------------------
@@ -28,17 +31,15 @@ using namespace std;
  * @brief Returns the built-in default list of ignore tokens.
  *
  * The returned reference points to a function-local static vector and is
- * safe to use for the lifetime of the program.
+ * safe to use for the lifetime of the program. The tokens come from the
+ * generated `defaultRules.hpp`.
  *
  * @return const std::vector<std::string>& Reference to the built-in ignore tokens.
  */
 inline const std::vector<std::string>& defaultIgnoreTokens()
 {
-    static const std::vector<std::string> TOKENS = {
-        "official", "lyrics", "video", "audio", "hd", "remix", "mv", "live", "youtube",
-        "ft", "feat", "2025", "720p", "1080", "1080p", "best", "song", "songs", "360p", "featuring",
-        "www", "com", "net", "org", "sample", "256k", "season", "episode", "lyric", "music"
-    };
+    static const std::vector<std::string> TOKENS(defaultRules::ignoreTokens.begin(),
+                                                 defaultRules::ignoreTokens.end());
     return TOKENS;
 }
 
@@ -48,63 +49,67 @@ inline const std::vector<std::string>& defaultIgnoreTokens()
 /**
  * @brief Returns the ignore tokens loaded from `data/ignoreTokens.json` or a fallback.
  *
- * On first call this function attempts to open `data/ignoreTokens.json` and
- * read an array at key `ignoreTokens`. If the file is missing, malformed, or
- * does not contain the expected array, the function falls back to
- * `defaultIgnoreTokens()`.
+ * This function attempts to open `data/ignoreTokens.json` and read an array
+ * at key `ignoreTokens`. If the file is missing, malformed, or does not
+ * contain the expected array, the function falls back to
+ * `defaultIgnoreTokens()`. The loaded list is normalized to lowercase.
  *
- * The loaded list is normalized to lowercase and cached for subsequent calls.
- * The function is not synchronized for multi-threaded access; if the program
- * uses threads it should ensure external synchronization when calling this
- * function during startup.
+ * It reads the file on every call; `getIgnoreTokens()` returns the cached
+ * list of the current `RuleSet`.
  *
- * @return const std::vector<std::string>& Reference to the cached ignore tokens.
+ * @return std::vector<std::string> The ignore tokens.
  */
-inline const std::vector<std::string>& getIgnoreTokens()
+inline std::vector<std::string> loadIgnoreTokens()
 {
-    static bool loaded = false;
-    static std::vector<std::string> tokens;
+    std::vector<std::string> tokens;
+
+    std::ifstream file("data/ignoreTokens.json");
+    if (!file.is_open())
+    {
+        // JSON file missing → fallback silently
+        tokens = defaultIgnoreTokens();
+        cout <<DIM<< "[INFO] ignoreTokens.json not found, using default ignore tokens.\n"<< RESET;
+        return tokens;
+    }
 
-    if (!loaded)
+    try
     {
-        loaded = true; // prevent reloading
+        json j;
+        file >> j;
 
-        std::ifstream file("data/ignoreTokens.json");
-        if (!file.is_open())
+        if (!j.contains("ignoreTokens") || !j["ignoreTokens"].is_array())
         {
-            // JSON file missing → fallback silently
+            // JSON structure wrong → fallback
             tokens = defaultIgnoreTokens();
-            cout <<DIM<< "[INFO] ignoreTokens.json not found, using default ignore tokens.\n"<< RESET;
+            cout <<DIM<< "[INFO] ignoreTokens.json invalid format, using default ignore tokens.\n"<< RESET;
             return tokens;
         }
 
-        try
-        {
-            json j;
-            file >> j;
-
-            if (!j.contains("ignoreTokens") || !j["ignoreTokens"].is_array())
-            {
-                // JSON structure wrong → fallback
-                tokens = defaultIgnoreTokens();
-                cout <<DIM<< "[INFO] ignoreTokens.json invalid format, using default ignore tokens.\n"<< RESET;
-                return tokens;
-            }
-
-            for (const auto& t : j["ignoreTokens"])
-                tokens.push_back(t.get<std::string>());
+        for (const auto& t : j["ignoreTokens"])
+            tokens.push_back(t.get<std::string>());
 
-            // normalize to lowercase for safety
-            for (auto& t : tokens)
-                std::transform(t.begin(), t.end(), t.begin(), ::tolower);
-        }
-        catch (...)
-        {
-            // Invalid JSON → fallback
-            cout <<DIM<< "[INFO] ignoreTokens.json invalid JSON, using default ignore tokens.\n"<< RESET;
-            tokens = defaultIgnoreTokens();
-        }
+        // normalize to lowercase for safety
+        for (auto& t : tokens)
+            std::transform(t.begin(), t.end(), t.begin(), ::tolower);
+    }
+    catch (...)
+    {
+        // Invalid JSON → fallback
+        cout <<DIM<< "[INFO] ignoreTokens.json invalid JSON, using default ignore tokens.\n"<< RESET;
+        tokens = defaultIgnoreTokens();
     }
 
     return tokens;
 }
+
+/**
+ * @brief The ignore tokens of the current `RuleSet`.
+ *
+ * Loaded once by `loadIgnoreTokens()`; lock-free and thread-safe afterwards.
+ *
+ * @return const std::vector<std::string>& Reference to the cached ignore tokens.
+ */
+inline const std::vector<std::string>& getIgnoreTokens()
+{
+    return currentRules().ignoreTokens;
+}
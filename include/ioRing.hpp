@@ -0,0 +1,102 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * @file ioRing.hpp
+ * @brief Minimal io_uring submission ring for batched renames.
+ *
+ * `IoRing` queues `renameat2` requests and hands a whole batch to the
+ * kernel with a single `io_uring_enter()` call, which also waits for the
+ * completions. It talks to the kernel directly (no liburing dependency)
+ * and is only functional on Linux 5.11+; elsewhere, or when io_uring is
+ * disabled, `ok()` is false and callers use the ordinary syscalls.
+ *
+ * Paths passed to `prepRename()` must stay valid until
+ * `submitAndWait()` returns.
+ *
+ * The implementation lives in `src/ioRing.cpp`.
+ */
+
+/**
+ * @brief One io_uring instance owned by the calling thread.
+ */
+class IoRing
+{
+public:
+    /**
+     * @brief Set up a ring with room for `entries` queued operations.
+     *
+     * @param entries Submission queue size (rounded up to a power of two by the kernel).
+     */
+    explicit IoRing(unsigned entries = 256);
+    ~IoRing();
+
+    IoRing(const IoRing &) = delete;
+    IoRing &operator=(const IoRing &) = delete;
+
+    /// How long a failed `submitAndWait()` keeps collecting completions of submitted operations.
+    static constexpr std::chrono::milliseconds DrainTimeout{1000};
+
+    /// True when the ring was set up, supports renames and no submission has failed.
+    bool ok() const { return fd_ >= 0 && renameSupported_ && !broken_; }
+
+    /// Operations that can still be queued before the next `submitAndWait()`.
+    std::size_t space() const;
+
+    /**
+     * @brief Queue `renameat2(oldDir, oldPath, newDir, newPath, flags)`.
+     *
+     * @return bool False when the queue is full.
+     */
+    bool prepRename(int oldDir, const char *oldPath, int newDir, const char *newPath, unsigned flags,
+                    std::uint64_t tag);
+
+    /**
+     * @brief Submit every queued operation and wait until all have completed.
+     *
+     * When `io_uring_enter()` fails, operations the kernel already consumed
+     * may still run: their completions are collected for up to
+     * `DrainTimeout`, then the ring is retired (`ok()` becomes false), so
+     * late completions are never taken for those of a later batch.
+     *
+     * @param onComplete Called once per operation with its tag and result
+     *                   (0 or a positive value on success, `-errno` on failure).
+     * @param consumed   Set to how many of the queued operations the kernel
+     *                   took from the submission queue, in queue order.
+     * @return bool False when a submission or wait failed. Operations beyond
+     *         `consumed` never ran and can be retried with the ordinary
+     *         syscalls; the unreported ones before it may or may not have run.
+     */
+    bool submitAndWait(const std::function<void(std::uint64_t tag, int result)> &onComplete,
+                       unsigned &consumed);
+
+private:
+    struct io_uring_sqe *nextSqe();
+
+    int fd_ = -1;
+    bool renameSupported_ = false;
+    bool broken_ = false; ///< A submission failed; the ring is not used again.
+
+    void *sqRing_ = nullptr;
+    void *cqRing_ = nullptr;
+    std::size_t sqRingSize_ = 0;
+    std::size_t cqRingSize_ = 0;
+    struct io_uring_sqe *sqes_ = nullptr;
+    std::size_t sqesSize_ = 0;
+
+    unsigned *sqHead_ = nullptr;
+    unsigned *sqTail_ = nullptr;
+    unsigned *sqArray_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned sqEntries_ = 0;
+    unsigned *cqHead_ = nullptr;
+    unsigned *cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    struct io_uring_cqe *cqes_ = nullptr;
+
+    unsigned localTail_ = 0; ///< Tail including operations not yet published.
+    unsigned queued_ = 0;    ///< Operations queued since the last submit.
+};
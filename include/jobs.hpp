@@ -0,0 +1,138 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "options.hpp"
+#include "ruleSet.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+ * @file jobs.hpp
+ * @brief Batch mode: organize many root directories on one worker pool.
+ *
+ * A manifest lists root directories, each with optional overrides of the
+ * run options and of the type rules. `runJobs()` schedules the roots
+ * across a fixed number of workers, with at most `perDevice` roots of the
+ * same filesystem device in progress at once, so a slow network mount
+ * only ever occupies a few workers while local disks keep the rest busy.
+ * Devices are served round-robin.
+ *
+ * Each root is organized like `clean type` (scan, optional sniffing,
+ * plan, optional dedupe, execute), without per-file output; the results
+ * are collected per root and summarized at the end. With
+ * `OutputFormat::Jsonl` every root writes its per-file records and a
+ * `summary` record to the shared `resultLog()`, and a failed root a
+ * `jobFailed` record.
+ *
+ * Manifest format (JSON) — either an array of jobs or an object with a
+ * `jobs` array and shared `defaults`. A job is a path string or an object:
+ *
+ * @code{.json}
+ * {
+ *   "defaults": {"recursive": true, "dedupe": "skip"},
+ *   "jobs": [
+ *     "/srv/home/alice/Downloads",
+ *     {"root": "/srv/home/bob/Downloads", "dest": "/srv/sorted/bob", "maxDepth": 2,
+ *      "fileTypes": {"Images": [".jpg", ".png"], "Other": []}, "dangerousExts": [".exe"]}
+ *   ]
+ * }
+ * @endcode
+ *
+ * Option keys: `recursive`, `maxDepth`, `dest`, `dryRun`, `dedupe`
+ * (`"off"`, `"skip"`, `"link"`), `sniff`, `byDate`, `quarantine`, `incremental` and `index`. Rule
+ * keys `fileTypes` (with its own `"$routes"`, see `routeRules.hpp`) and
+ * `dangerousExts` replace the corresponding rule files for that job. A plain list of paths, one per line (`#` starts a
+ * comment), is accepted too.
+ *
+ * The implementation lives in `src/jobs.cpp`.
+ */
+
+/**
+ * @brief One root directory to organize.
+ */
+struct CleanJob
+{
+    fs::path root;
+    CleanOptions options;                 ///< Non-interactive options for this root.
+    std::shared_ptr<const RuleSet> rules; ///< Rule overrides, or null for the current rules.
+};
+
+/**
+ * @brief Outcome of one job.
+ */
+struct JobResult
+{
+    fs::path root;
+    std::uint64_t device = 0;  ///< Filesystem device of the root (`st_dev`).
+    bool ok = false;           ///< False when the root could not be organized at all.
+    std::string error;         ///< Why, when `ok` is false.
+    std::size_t files = 0;     ///< Files scanned.
+    std::size_t planned = 0;   ///< Moves that were ready (the moves of a dry run).
+    std::size_t moved = 0;
+    std::size_t skipped = 0;   ///< Conflicts, dangerous and identical files, failed moves.
+    std::size_t failed = 0;    ///< Ready moves that failed (included in `skipped`).
+    std::size_t linked = 0;    ///< Identical files replaced with hard links.
+    std::size_t dangerous = 0;
+    std::size_t quarantined = 0; ///< Dangerous files moved into quarantine (included in `moved`).
+    std::size_t identical = 0;
+    double seconds = 0;        ///< Wall time of this job.
+};
+
+/**
+ * @brief Read a manifest (JSON, or one path per line).
+ *
+ * @param in          Manifest text.
+ * @param defaults    Options every job starts from (typically the command line ones).
+ * @param incremental Default of the `incremental` key: keep a scan index per root.
+ * @param jobs        Receives the jobs, in manifest order.
+ * @param error       Receives a description of the first problem.
+ * @return bool False when the manifest is malformed.
+ */
+bool readJobManifest(std::istream &in, const CleanOptions &defaults, bool incremental, std::vector<CleanJob> &jobs,
+                     std::string &error);
+
+/**
+ * @brief Organize every job on a shared pool.
+ *
+ * @param jobs      Jobs to run.
+ * @param workers   Jobs in progress at once; 0 selects the hardware concurrency.
+ * @param perDevice Jobs in progress at once on one filesystem device (at least 1).
+ * @return std::vector<JobResult> One result per job, in job order.
+ */
+std::vector<JobResult> runJobs(const std::vector<CleanJob> &jobs, unsigned workers, unsigned perDevice);
+
+/**
+ * @brief Print the failed jobs and the totals of a batch.
+ *
+ * A job counts as failed when its root could not be organized or when
+ * any of its moves failed.
+ *
+ * @param results Results from `runJobs()`.
+ * @param seconds Wall time of the whole batch.
+ * @param out     Destination stream.
+ */
+void printJobSummary(const std::vector<JobResult> &results, double seconds, std::ostream &out);
+
+/**
+ * @brief Write the totals of a batch as a `jobs` record to `resultLog()`.
+ *
+ * Used instead of `printJobSummary()` with `OutputFormat::Jsonl`; the
+ * per-file and per-root records were written by the jobs themselves.
+ *
+ * @param results Results from `runJobs()`.
+ * @param seconds Wall time of the whole batch.
+ */
+void logJobSummary(const std::vector<JobResult> &results, double seconds);
+
+/**
+ * @brief Save per-job results and totals as JSON.
+ *
+ * @return bool False when the file could not be written.
+ */
+bool saveJobReport(const std::vector<JobResult> &results, double seconds, const fs::path &file);
@@ -0,0 +1,149 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "planner.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+ * @file journal.hpp
+ * @brief Write-ahead journal of planned and completed moves.
+ *
+ * Before a plan is executed every ready move is appended to the journal and
+ * flushed to disk in one batch. Each completed move then appends a short
+ * "done" record; those are synced in batches of `MoveJournal::SyncBatch`
+ * rather than once per file. If a run is interrupted, `resumeJournal()`
+ * finishes exactly the moves that were planned but not completed, and
+ * `undoJournal()` moves completed files back to where they came from—both
+ * without rescanning the tree.
+ *
+ * The journal is a plain text file, one record per line:
+ *
+ *     P <id>\t<source>\t<destination>   planned move
+ *     D <id>                               move completed
+ *     U <id>                               move undone
+ *
+ * Tabs, newlines and backslashes inside paths are escaped with a backslash.
+ * The implementation lives in `src/journal.cpp`.
+ */
+
+/**
+ * @brief One planned move reconstructed from a journal.
+ */
+struct JournalEntry
+{
+    std::uint64_t id = 0;
+    fs::path source;
+    fs::path destination;
+    bool done = false;   ///< A completion record was found.
+    bool undone = false; ///< The move has since been reverted.
+};
+
+/**
+ * @brief Append-only writer for the move journal.
+ *
+ * All methods are safe to call from several executor threads at once.
+ */
+class MoveJournal
+{
+public:
+    /// Completion records written between two `fsync()` calls.
+    static constexpr std::size_t SyncBatch = 4096;
+
+    MoveJournal() = default;
+    ~MoveJournal();
+
+    MoveJournal(const MoveJournal &) = delete;
+    MoveJournal &operator=(const MoveJournal &) = delete;
+
+    /**
+     * @brief Open (or create) a journal for appending.
+     *
+     * Existing records are kept; new planned moves continue the id sequence.
+     *
+     * @param file Journal path.
+     * @return bool False when the file cannot be opened or read.
+     */
+    bool open(const fs::path &file);
+
+    /**
+     * @brief Record every ready move of a plan and sync the journal.
+     *
+     * Assigns `PlannedMove::journalId` for each recorded move.
+     *
+     * @param plan Plan about to be executed.
+     * @return bool False when the records could not be made durable, or when
+     *              any earlier write to the journal failed; the plan must
+     *              then not be executed.
+     */
+    bool recordPlan(MovePlan &plan);
+
+    /// Record a completed move; synced in batches. Dropped once a write has failed.
+    void recordDone(std::uint64_t id);
+
+    /// Record a reverted move; synced in batches. Dropped once a write has failed.
+    void recordUndone(std::uint64_t id);
+
+    /// Write out buffered records and `fsync()` the journal.
+    /// @return bool False when this or any earlier write failed.
+    bool sync();
+
+private:
+    void append(const std::string &record);
+    bool flushLocked();
+
+    std::mutex mutex_;
+    int fd_ = -1;
+    std::string buffer_;
+    std::size_t unsynced_ = 0;
+    std::uint64_t nextId_ = 1;
+    bool failed_ = false; ///< A write or sync failed; the journal is no longer complete.
+};
+
+/**
+ * @brief Read all planned moves and their status from a journal.
+ *
+ * @param file Journal path.
+ * @param ok   Set to false when the file cannot be opened.
+ * @return std::vector<JournalEntry> Entries in the order they were planned.
+ */
+std::vector<JournalEntry> readJournal(const fs::path &file, bool &ok);
+
+/**
+ * @brief Remove one file (typically the journal itself) from a scan result.
+ *
+ * @param files Scan result to filter in place.
+ * @param file  Path to drop; compared after making both paths absolute.
+ */
+void excludePath(FileTable &files, const fs::path &file);
+
+/**
+ * @brief Finish the moves of an interrupted run.
+ *
+ * Only entries without a completion record are looked at. An entry whose
+ * source is gone and whose destination exists was completed just before
+ * the crash and is simply marked done.
+ *
+ * @param file Journal path.
+ * @param jobs Maximum number of concurrent moves.
+ * @param ok   Set to false when the journal cannot be opened.
+ * @return MoveResult Totals for the remaining moves.
+ */
+MoveResult resumeJournal(const fs::path &file, unsigned jobs, bool &ok);
+
+/**
+ * @brief Move every completed file in the journal back to its source.
+ *
+ * Entries are reverted newest first. Files whose original location is
+ * occupied again are skipped. Destination folders left empty are removed.
+ *
+ * @param file Journal path.
+ * @param ok   Set to false when the journal cannot be opened.
+ * @return MoveResult `moved` counts restored files.
+ */
+MoveResult undoJournal(const fs::path &file, bool &ok);
@@ -0,0 +1,215 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dedupe.hpp"
+#include "fileTable.hpp"
+#include "options.hpp"
+#include "planner.hpp"
+#include "progress.hpp"
+#include "ruleSet.hpp"
+#include "threadPool.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+ * @file libclean.hpp
+ * @brief Embeddable C++ API of the organizer (the `libclean` library).
+ *
+ * The terminal front ends (`cleanFilesByType()`, `cleanFilesByName()`,
+ * `runCli()` and the TUI in `main.cpp`) prompt and print. A service that
+ * organizes directories on request needs the same work as plain calls
+ * that return their results, without spawning the tool and parsing its
+ * output. A `CleanSession` offers the stages of a run:
+ *
+ * - `scan()` lists a tree into a `FileTable`;
+ * - `planType()` and `planName()` scan and build a finalized `MovePlan`;
+ * - `execute()` applies a plan (journal and quarantine scanner included);
+ * - `list()` returns per-category file counts and sizes.
+ *
+ * None of them reads standard input or writes standard output; failures
+ * come back in the result. Warnings about single files (an unreadable
+ * directory, a failed rename) are still printed to `std::cerr`, and
+ * failed moves are also listed in `MoveResult::failures`; the data file
+ * loaders still print their fallback notices when a file is missing.
+ *
+ * Every call takes a `RunControl`: an optional `CancelToken`, checked
+ * between directories and between moves, and a progress callback that is
+ * called at most once per interval (see `ProgressReporter`).
+ *
+ * A session pins the rule set current when it was created, so all its
+ * calls classify with the same rules until `reloadRules()`, and keeps a
+ * `ThreadPool` whose workers stay warm for the recursive scans of every
+ * call. Calls on one session run one at a time; use one session per
+ * thread to organize several roots at once.
+ *
+ * @code
+ * CleanSession session;
+ * CancelToken cancel; // cancel.cancel() from any thread stops the run
+ * RunControl control{&cancel, [](const Progress &p) { report(p.done, p.total); }};
+ *
+ * CleanOptions options;
+ * options.scan.recursive = true;
+ * PlanResult planned = session.planType("/srv/inbox", options, control);
+ * if (planned.ok())
+ * {
+ *     ExecuteResult done = session.execute(planned.plan, options, control);
+ *     // done.moves.moved, done.moves.failures, ...
+ * }
+ * @endcode
+ *
+ * The implementation lives in `src/libclean.cpp`; the library target is
+ * `libclean` (`libclean.a`), which the command line tool links against.
+ */
+
+/**
+ * @brief Cancellation and progress settings of one call.
+ */
+struct RunControl
+{
+    const CancelToken *cancel = nullptr; ///< Stops the call early when cancelled; may be null.
+    ProgressCallback progress;           ///< Receives throttled reports; may be empty.
+    std::chrono::milliseconds interval = ProgressReporter::DefaultInterval; ///< Minimum time between reports.
+};
+
+/**
+ * @brief Outcome shared by every session call.
+ */
+struct CallStatus
+{
+    std::string error;      ///< Why the call failed (nothing was done); empty on success.
+    bool cancelled = false; ///< Stopped by the `CancelToken`; the results are partial.
+
+    bool ok() const { return error.empty() && !cancelled; }
+};
+
+/// Result of `CleanSession::scan()`.
+struct ScanResult : CallStatus
+{
+    FileTable files; ///< Files found (all of them, or those found before the cancellation).
+};
+
+/// Result of `CleanSession::planType()` and `CleanSession::planName()`.
+struct PlanResult : CallStatus
+{
+    MovePlan plan;         ///< Finalized plan; empty when cancelled.
+    std::size_t files = 0; ///< Files scanned.
+    DedupeSummary dedupe;  ///< What `options.dedupe` found.
+};
+
+/// Result of `CleanSession::execute()`.
+struct ExecuteResult : CallStatus
+{
+    MoveResult moves;          ///< Per-move outcomes and totals.
+    bool journalFailed = false; ///< The completion records could not be made durable.
+};
+
+/// Files and bytes of one category in a `ListResult`.
+struct CategoryTotal
+{
+    std::string name;
+    std::size_t files = 0;
+    std::uint64_t bytes = 0;
+};
+
+/// Result of `CleanSession::list()`.
+struct ListResult : CallStatus
+{
+    FileTable files;                       ///< Files found, with sizes and times.
+    std::vector<CategoryTotal> categories; ///< Categories holding files, in classifier order.
+    std::uint64_t bytes = 0;               ///< Size of all files.
+};
+
+/**
+ * @brief A long-lived, non-interactive handle on the organizer.
+ *
+ * `options.interactive` is ignored by every call, and `options.output`,
+ * `options.planFile` and `options.listMode` are left to the caller.
+ */
+class CleanSession
+{
+public:
+    /**
+     * @param threads Workers kept for recursive scans; 0 selects all cores. A
+     *                call whose `options.scan.threads` asks for a different
+     *                non-zero count scans on a pool of its own.
+     */
+    explicit CleanSession(unsigned threads = 0);
+
+    CleanSession(const CleanSession &) = delete;
+    CleanSession &operator=(const CleanSession &) = delete;
+
+    /**
+     * @brief Scan `root` with `options.scan` (and `options.indexFile`).
+     *
+     * The journal file, when set, is left out of the table.
+     */
+    ScanResult scan(const fs::path &root, const CleanOptions &options, const RunControl &control = {});
+
+    /**
+     * @brief Scan `root` and plan it by type, like `clean type`.
+     *
+     * Honors `sniff`, `byDate`, `destination`, `quarantine` and `dedupe`;
+     * sizes and times are collected when routing rules need them.
+     */
+    PlanResult planType(const fs::path &root, const CleanOptions &options, const RunControl &control = {});
+
+    /**
+     * @brief Scan `root` and plan it by name, like `clean name` (see `planByName()`).
+     *
+     * Matches `options.token` and `options.tokens`, or auto-detects common
+     * names when both are empty.
+     */
+    PlanResult planName(const fs::path &root, const CleanOptions &options, const RunControl &control = {});
+
+    /**
+     * @brief Execute a plan with `options.moveJobs` and `options.ioUring`.
+     *
+     * With `options.journalFile` the plan is journaled first (the call fails
+     * without moving anything when the journal cannot be written); with
+     * `options.quarantineScan` the quarantined files are scanned before it
+     * returns. `options.dryRun` is the caller's decision and is not checked.
+     *
+     * @param plan Plan from `planType()` or `planName()`; receives the journal ids.
+     */
+    ExecuteResult execute(MovePlan &plan, const CleanOptions &options, const RunControl &control = {});
+
+    /**
+     * @brief Scan `root` with sizes and count files and bytes per category.
+     */
+    ListResult list(const fs::path &root, const CleanOptions &options, const RunControl &control = {});
+
+    /// Rule set the calls classify with.
+    const RuleSet &rules() const;
+
+    /**
+     * @brief Use the data files as they are now on disk.
+     *
+     * @return bool True when the rules changed (see `reloadRulesIfChanged()`).
+     */
+    bool reloadRules();
+
+    /// Workers of the session's pool.
+    unsigned threads() const { return pool_.size(); }
+
+private:
+    ScanResult scanLocked(const fs::path &root, const CleanOptions &options, ScanOptions scan,
+                          ProgressReporter &progress);
+
+    mutable std::mutex mutex_; ///< Held for the whole of every call.
+    const RuleSet *rules_;
+    ThreadPool pool_;
+};
+
+/**
+ * @brief Session used by the terminal front ends, created on first use.
+ *
+ * Kept for the lifetime of the process, so the menus of `main.cpp` reuse
+ * its rules and workers from one operation to the next.
+ */
+CleanSession &sharedSession();
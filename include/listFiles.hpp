@@ -7,7 +7,13 @@
  * This header defines an inline function listFilesInDirectory() which
  * displays files from a directory in a formatted, type-grouped output
  * with color coding by file extension. Files are grouped by type
- * (Images, Videos, Audio, etc.) using the mappings from getFileTypes().
+ * (Images, Videos, Audio, etc.) using the shared ExtClassifier.
+ *
+ * Two further presentations keep memory flat on huge directories:
+ * `ListMode::Stream` prints every row as soon as the file is listed, and
+ * `ListMode::Summary` prints only per-type counts and sizes. All modes
+ * render through one reusable `OutputBuffer` instead of per-row
+ * `std::cout` formatting.
  */
 
 #include <iostream>
@@ -17,40 +23,164 @@
 #include <algorithm>
 #include <filesystem>
 #include <limits>
+#include <string>
+#include <string_view>
+#include <cstdio>
+#include <iterator>
 
 #include "colors.hpp"       ///< ANSI color code macros
 #include "header.hpp"       ///< Header display utilities
-#include "fileTypes.hpp"    ///< File type mappings
-#include "getColor.hpp"     ///< Color selection by file extension
+#include "nameKernel.hpp"   ///< Extension lookup on names
+#include "classifier.hpp"   ///< Extension → category classifier
+#include "options.hpp"      ///< Interactive / batch run options
+#include "outputBuffer.hpp" ///< Buffered row output
+#include "scanner.hpp"      ///< Shared directory scanner
+#include "scanIndex.hpp"    ///< Incremental scan index
+#include "stats.hpp"        ///< Per-phase run statistics
 
 namespace fs = std::filesystem;
 
+/// Width of the file name column.
+constexpr std::size_t ListNameWidth = 60;
+
+/**
+ * @brief Category display order: the common types first, then the
+ *        remaining categories in classifier order, then "Other".
+ */
+inline std::vector<CategoryId> listTypeOrder(const ExtClassifier &classifier)
+{
+    std::vector<CategoryId> typeOrder;
+    for (const char *name : {"Images", "Videos", "Audio", "Documents", "Archives", "Code"})
+    {
+        CategoryId id = classifier.findCategory(name);
+        if (id != classifier.otherCategory())
+            typeOrder.push_back(id);
+    }
+    for (CategoryId id = 0; id < classifier.categoryCount(); ++id)
+        if (id != classifier.otherCategory() &&
+            std::find(typeOrder.begin(), typeOrder.end(), id) == typeOrder.end())
+            typeOrder.push_back(id);
+    typeOrder.push_back(classifier.otherCategory());
+    return typeOrder;
+}
+
+/**
+ * @brief Cuts display names out of scanned paths without allocating.
+ *
+ * Scanned paths are always `root / relative`, so the relative part starts
+ * at a fixed offset of the path's native string.
+ */
+class ListNames
+{
+public:
+    ListNames(const fs::path &root, bool relative)
+        : relative_(relative), prefix_((root / "x").string().size() - 1) {}
+
+    /// Shown name: path below the root when listing recursively, else the file name.
+    std::string_view shown(const fs::path &p)
+    {
+        std::string_view full = view(p);
+        if (relative_ && full.size() > prefix_)
+            return full.substr(prefix_);
+        std::size_t slash = full.find_last_of(separators());
+        return slash == std::string_view::npos ? full : full.substr(slash + 1);
+    }
+
+    /// Extension (with the dot) of the last shown name, like `fs::path::extension()`.
+    static std::string_view extension(std::string_view shown)
+    {
+        std::size_t slash = shown.find_last_of(separators());
+        std::string_view name = slash == std::string_view::npos ? shown : shown.substr(slash + 1);
+        return name.substr(name.size() - extensionLength(name));
+    }
+
+private:
+    static const char *separators()
+    {
+#ifdef _WIN32
+        return "/\\";
+#else
+        return "/";
+#endif
+    }
+
+    std::string_view view(const fs::path &p)
+    {
+#ifdef _WIN32
+        scratch_ = p.string(); // native strings are wide on Windows
+        return scratch_;
+#else
+        return p.native();
+#endif
+    }
+
+    bool relative_;
+    std::size_t prefix_;
+    std::string scratch_;
+};
+
+/**
+ * @brief Append one listing row: colored, padded name and dim extension.
+ */
+inline void appendListRow(OutputBuffer &out, const std::string &color,
+                          std::string_view shown, std::string_view ext)
+{
+    out.append(color).append(shown);
+    if (shown.size() < ListNameWidth)
+        out.pad(ListNameWidth - shown.size());
+    out.append(RESET).append(DIM).append(" (").append(ext).append(")\n").append(RESET);
+}
+
+/**
+ * @brief Human-readable byte count (B, KiB, MiB, ...).
+ */
+inline std::string formatSize(unsigned long long bytes)
+{
+    static const char *units[] = {"B", "KiB", "MiB", "GiB", "TiB", "PiB"};
+    double value = static_cast<double>(bytes);
+    std::size_t unit = 0;
+    while (value >= 1024.0 && unit + 1 < std::size(units))
+    {
+        value /= 1024.0;
+        ++unit;
+    }
+    char text[32];
+    std::snprintf(text, sizeof text, unit ? "%.1f %s" : "%.0f %s", value, units[unit]);
+    return text;
+}
 
 /**
  * @brief Display all files in a directory, grouped by file type.
  *
  * Lists all regular files in the given directory, organizes them by type
- * (using the mapping from getFileTypes()), and prints them with:
- * - Color-coded filenames (via getColorForExtension())
+ * (using the shared classifier from getClassifier()), and prints them with:
+ * - Color-coded filenames (one color per file type group)
  * - File extensions displayed in parentheses
  * - Files grouped under type headers (Images, Videos, Audio, etc.)
  * - A total file count at the end
  *
+ * With `options.listMode` set to `ListMode::Stream` rows are printed in
+ * scan order as files are found, followed by per-type totals; with
+ * `ListMode::Summary` only the per-type counts and sizes are shown. Both
+ * walk the tree with `scanEach()` and keep no per-file state.
+ *
  * If the directory does not exist or is empty, appropriate messages are displayed.
  * The function pauses and waits for user input (Enter) before returning,
- * making it suitable for interactive TUI use.
+ * making it suitable for interactive TUI use. With `options.interactive`
+ * set to false the screen is not cleared and no pause is performed.
  *
  * @param directoryPath The filesystem path to the directory to list.
+ * @param options       Run-time options (see `CleanOptions`).
  *
  * @note The function uses inline implementation; it can be included in
  *       multiple translation units without linker issues.
  *
- * @see getFileTypes() for the typeextension mappings
- * @see getColorForExtension() for color selection by file extension
+ * @see getClassifier() for the extension → type classification
  */
-inline void listFilesInDirectory(const fs::path &directoryPath)
+inline void listFilesInDirectory(const fs::path &directoryPath, const CleanOptions &options = {})
 {
-    Header::display();
+    if (options.interactive)
+        Header::display();
     
     // Validate input directory
     if (!fs::exists(directoryPath))
@@ -70,45 +200,113 @@ inline void listFilesInDirectory(const fs::path &directoryPath)
     std::cout << DIM << "------------------------------------------------------------------\n"
               << RESET;
 
-    // Build extension  type lookup table (case-insensitive)
-    std::map<std::string, std::string> extToType;
-    for (const auto &[type, exts] : getFileTypes())
-    {
-        for (const auto &e : exts)
-        {
-            std::string lowerExt = e;
-            std::transform(lowerExt.begin(), lowerExt.end(), lowerExt.begin(),
-                           [](unsigned char c){ return std::tolower(c); });
-            extToType[lowerExt] = type;
-        }
-    }
+    // Shared, precomputed extension classifier
+    const ExtClassifier &classifier = getClassifier();
 
     // Define the order in which file types should be displayed
-    std::vector<std::string> typeOrder =
-        {"Images", "Videos", "Audio", "Documents", "Archives", "Code", "Other"};
+    const std::vector<CategoryId> typeOrder = listTypeOrder(classifier);
 
-    // Group files by type for organized display
-    std::map<std::string, std::vector<fs::path>> groupedFiles;
+    ListNames names(directoryPath, options.scan.recursive);
     size_t fileCount = 0;// Total file counter
 
-    // Iterate over directory entries and categorize each file
-    for (const auto &entry : fs::directory_iterator(directoryPath))
+    // Per-type totals for the streaming and summary modes
+    std::vector<unsigned long long> typeCount(classifier.categoryCount(), 0);
+    std::vector<unsigned long long> typeBytes(classifier.categoryCount(), 0);
+    unsigned long long totalBytes = 0;
+
     {
-        if (!entry.is_regular_file())
-            continue;
+        OutputBuffer out;
+
+        if (options.listMode == ListMode::Grouped)
+        {
+            // Group record indices by type (indexed by category id) for organized display
+            std::vector<std::vector<std::uint32_t>> groupedFiles(classifier.categoryCount());
+
+            // Files were classified by extension during the scan; unknown ones are "Other"
+            const FileTable scanned = scanDirectoryIndexed(directoryPath, options.scan, options.indexFile);
+            {
+                PhaseTimer timer(Phase::Classify);
+                for (std::size_t i = 0; i < scanned.size(); ++i)
+                    groupedFiles[scanned[i].category].push_back(static_cast<std::uint32_t>(i));
+                fileCount = scanned.size();
+                runStats().addItems(Phase::Classify, fileCount);
+            }
+            std::string shown; // reused for every row
+
+            // Display files grouped by type in predefined order
+            for (CategoryId type : typeOrder)
+            {
+                const auto &files = groupedFiles[type];
+                if (files.empty())
+                    continue;
 
-        std::string ext = entry.path().extension().string();
-        std::string lowerExt = ext;
-        std::transform(lowerExt.begin(), lowerExt.end(), lowerExt.begin(),
-                       [](unsigned char c){ return std::tolower(c); });
+                // Print type header
+                out.append(BOLD).append(WHITE).append("-- ").append(classifier.categoryName(type))
+                    .append(" --").append(RESET).append("\n");
+                const std::string &color = classifier.colorFor(type);
 
-        // Classify file by extension; default to "Other"
-        if (!lowerExt.empty() && extToType.find(lowerExt) != extToType.end())
-            groupedFiles[extToType[lowerExt]].push_back(entry.path());
+                // Print each file with color coding and extension
+                for (std::uint32_t i : files)
+                {
+                    // Recursive listings show the path below the listed directory
+                    shown.clear();
+                    if (options.scan.recursive)
+                        scanned.appendRelativePath(i, shown);
+                    else
+                        shown.append(scanned.name(i));
+                    appendListRow(out, color, shown, scanned.extension(i));
+                }
+                out.append("\n");
+            }
+        }
         else
-            groupedFiles["Other"].push_back(entry.path());
+        {
+            const bool summary = options.listMode == ListMode::Summary;
+            scanEach(directoryPath, options.scan, [&](const fs::directory_entry &entry) {
+                std::string_view shown = names.shown(entry.path());
+                std::string_view ext = ListNames::extension(shown);
+                CategoryId type = classifier.classify(ext).category;
+                ++fileCount;
+                ++typeCount[type];
 
-        ++fileCount;
+                if (summary)
+                {
+                    std::error_code ec;
+                    auto size = entry.file_size(ec); // one stat() per file
+                    if (!ec)
+                    {
+                        typeBytes[type] += size;
+                        totalBytes += size;
+                    }
+                }
+                else
+                {
+                    appendListRow(out, classifier.colorFor(type), shown, ext);
+                }
+            });
+            runStats().addItems(Phase::Classify, fileCount);
+
+            // Per-type totals
+            if (fileCount != 0)
+            {
+                if (!summary)
+                    out.append("\n");
+                for (CategoryId type : typeOrder)
+                {
+                    if (typeCount[type] == 0)
+                        continue;
+                    const std::string &name = classifier.categoryName(type);
+                    out.append(classifier.colorFor(type)).append(name);
+                    out.pad(name.size() < 16 ? 16 - name.size() : 1).append(RESET);
+                    std::string count = std::to_string(typeCount[type]);
+                    out.pad(count.size() < 10 ? 10 - count.size() : 1).append(count).append(" files");
+                    if (summary)
+                        out.append(DIM).append("  ").append(formatSize(typeBytes[type])).append(RESET);
+                    out.append("\n");
+                }
+                out.append("\n");
+            }
+        }
     }
 
     // Display results
@@ -118,34 +316,17 @@ inline void listFilesInDirectory(const fs::path &directoryPath)
     }
     else
     {
-        // Display files grouped by type in predefined order
-        for (const auto &type : typeOrder)
-        {
-            auto it = groupedFiles.find(type);
-            if (it == groupedFiles.end() || it->second.empty())
-                continue;
-
-            // Print type header
-            std::cout << BOLD << WHITE << "-- " << type << " --" << RESET << "\n";
-            
-            // Print each file with color coding and extension
-            for (const auto &p : it->second)
-            {
-                std::string ext = p.extension().string();
-                std::string color = getColorForExtension(ext);
-                std::cout << color
-                          << std::left << std::setw(60) << p.filename().string()
-                          << RESET << DIM << " (" << ext << ")\n" << RESET;
-            }
-            std::cout << "\n";
-        }
-
         // Display footer with total count
         std::cout << DIM << "------------------------------------------------------------------\n" << RESET;
-        std::cout << GREEN << "Total files: " << WHITE << fileCount << RESET << "\n\n";
+        std::cout << GREEN << "Total files: " << WHITE << fileCount << RESET;
+        if (options.listMode == ListMode::Summary)
+            std::cout << DIM << "  (" << formatSize(totalBytes) << ")" << RESET;
+        std::cout << "\n\n";
     }
 
     // Pause for user acknowledgment
+    if (!options.interactive)
+        return;
     std::cout << YELLOW << "Press Enter to return to the menu..." << RESET;
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     std::cin.get();
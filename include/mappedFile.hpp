@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+/**
+ * @file mappedFile.hpp
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * Used for the binary files the tool writes for itself (the scan index and
+ * the compiled rule bundle): mapping them costs one `open()` and one
+ * `mmap()` (`CreateFileMapping` / `MapViewOfFile` on Windows), and only the
+ * pages that are actually read are loaded.
+ *
+ * The implementation lives in `src/mappedFile.cpp`.
+ */
+
+/**
+ * @brief Owns one read-only mapping; unmapped on destruction.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @brief Map `file`, replacing any previous mapping.
+     *
+     * @return bool False when the file is missing, empty or cannot be mapped.
+     */
+    bool open(const fs::path &file);
+
+    /// Drop the mapping.
+    void close();
+
+    const char *data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+#ifdef _WIN32
+    void *mapping_ = nullptr;
+#endif
+};
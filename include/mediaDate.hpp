@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+#include "fileTable.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+ * @file mediaDate.hpp
+ * @brief Capture dates of photos and videos, for the `Images/YYYY/MM` layout.
+ *
+ * `readCaptureTime()` reads only the header region of a file: the first
+ * `HeadSize` bytes for JPEG (EXIF in APP1), TIFF-based raw formats and PNG
+ * (`eXIf`), and for MP4 / QuickTime the top-level box headers plus the
+ * start of the `moov` box (`mvhd` creation time), one positioned read per
+ * box. The media data itself is never read.
+ *
+ * `readCaptureDates()` does this for every photo and video of a scan on a
+ * bounded reader pool. The results, including "no date in this file", are
+ * kept in the scan index (see `scanIndex.hpp`), so unchanged files are not
+ * parsed again on later runs.
+ *
+ * The implementation lives in `src/mediaDate.cpp`.
+ */
+
+/// Bytes read from the start of a photo (covers the 64 KiB APP1 segment of a JPEG).
+constexpr std::size_t CaptureHeadSize = 64 * 1024;
+
+/// Files open at once in `readCaptureDates()`, whatever the thread count.
+constexpr unsigned MaxCaptureReaders = 16;
+
+/**
+ * @brief Whether files of a category are laid out by capture date.
+ *
+ * @param category Category name.
+ * @return bool True for "Images" and "Videos".
+ */
+bool isDateCategory(std::string_view category);
+
+/**
+ * @brief Read the capture time recorded in a photo or video.
+ *
+ * EXIF `DateTimeOriginal` is preferred over `DateTimeDigitized` and
+ * `DateTime`; EXIF times are local times. MP4 / QuickTime creation times
+ * are UTC.
+ *
+ * @param file File to read.
+ * @return std::int64_t Unix seconds, or `FileTable::DateNone` when the
+ *         file holds no capture time or cannot be read.
+ */
+std::int64_t readCaptureTime(const fs::path &file);
+
+/**
+ * @brief Read the capture times of the photos and videos of a table.
+ *
+ * Every record in a date category whose `captured()` is still
+ * `DateUnread` is read with `readCaptureTime()`. Large batches are spread
+ * over a `ThreadPool` of at most `MaxCaptureReaders` workers.
+ *
+ * @param files   Scanned files, classified by `files.classifier()`.
+ * @param threads Worker threads; 0 selects the hardware concurrency.
+ * @return std::size_t Number of records that were read.
+ */
+std::size_t readCaptureDates(FileTable &files, unsigned threads = 0);
+
+/**
+ * @brief Year and month of a capture date, or of a file's modification time.
+ *
+ * Uses `files.captured(i)` when the record has a capture time, otherwise
+ * its modification time when it has one (`FileRecord::HasStat`).
+ *
+ * @param files Scanned files.
+ * @param i     Record index.
+ * @param year  Receives the local year.
+ * @param month Receives the local month, 1 to 12.
+ * @return bool False when the record has neither.
+ */
+bool captureMonth(const FileTable &files, std::size_t i, int &year, int &month);
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fileTable.hpp"
+
+/**
+ * @file nameKernel.hpp
+ * @brief Vectorized case folding, extension lookup and token splitting of file names.
+ *
+ * The name hot paths (extension of every scanned file, lowercased stems
+ * and their tokens for `buildTokenIndex()`) work on bytes that are already
+ * in the `FileTable` pool, so they need neither `fs::path` nor a copied
+ * `std::string` per name. The kernels here process 16 bytes at a time with
+ * SSE2 (x86-64) or NEON (AArch64), 32 with AVX2 when the build targets it
+ * (`-DCLEAN_NATIVE=ON` on a CPU that has it), and fall back to a byte loop
+ * elsewhere and for the last bytes of every name. All variants give the
+ * same results; `nameKernelIsa()` tells which one was compiled in.
+ *
+ * Only ASCII is folded: bytes from 0x80 up are copied unchanged and, when
+ * `highIsToken` is set (the `--fuzzy` path, after `foldName()`), count as
+ * token characters.
+ *
+ * The implementation lives in `src/nameKernel.cpp`.
+ */
+
+/// Instruction set of the compiled kernels: "avx2", "sse2", "neon" or "scalar".
+const char *nameKernelIsa();
+
+/**
+ * @brief Lowercase the ASCII letters of `n` bytes.
+ *
+ * @param src Bytes to fold.
+ * @param n   Number of bytes.
+ * @param dst Receives `n` bytes; may be `src` itself.
+ */
+void foldAscii(const char *src, std::size_t n, char *dst);
+
+/**
+ * @brief Position of the last '.' of a name.
+ *
+ * @return std::size_t Index of the dot, or `std::string_view::npos`.
+ */
+std::size_t findLastDot(std::string_view name);
+
+/**
+ * @brief Length of the extension at the end of `name`, including the dot.
+ *
+ * Follows `fs::path::extension()`: a leading dot (".bashrc") and the names
+ * "." and ".." have no extension.
+ */
+std::uint16_t extensionLength(std::string_view name);
+
+/**
+ * @brief A token of a `NameBatch`: a run of letters and digits of one stem.
+ */
+struct NameToken
+{
+    std::uint32_t offset = 0; ///< Start in `NameBatch::text`.
+    std::uint32_t length = 0; ///< Length in bytes, never 0.
+};
+
+/**
+ * @brief Lowercased stems of consecutive records and their tokens.
+ *
+ * Filled by `foldStems()`; stem `k` belongs to record `begin + k`. The
+ * buffers are reused from one call to the next.
+ */
+struct NameBatch
+{
+    std::string text;                      ///< Folded stems, back to back.
+    std::vector<std::uint32_t> nameStart;  ///< Start of stem `k` in `text`; one extra entry marks the end.
+    std::vector<NameToken> tokens;         ///< Tokens of all stems, in order.
+    std::vector<std::uint32_t> tokenStart; ///< First token of stem `k`; one extra entry marks the end.
+    std::vector<std::uint8_t> split;       ///< 1 when stem `k` contains a separator byte.
+
+    /// Number of stems in the batch.
+    std::size_t size() const { return split.size(); }
+
+    /// Folded stem `k`.
+    std::string_view stem(std::size_t k) const
+    {
+        return std::string_view(text).substr(nameStart[k], nameStart[k + 1] - nameStart[k]);
+    }
+
+    /// Text of token `t`.
+    std::string_view token(std::size_t t) const
+    {
+        return std::string_view(text).substr(tokens[t].offset, tokens[t].length);
+    }
+};
+
+/// Records folded per `foldStems()` call by the batch users.
+constexpr std::size_t NameBatchSize = 1024;
+
+/**
+ * @brief Fold the stems of records [begin, end) and split them into tokens.
+ *
+ * Each stem is lowercased (with `fold`, folded by `foldName()` first) and
+ * cut at every byte that is not an ASCII letter or digit (or, with `fold`,
+ * a byte from 0x80 up), in one pass over the names in the pool.
+ *
+ * @param files Scanned files.
+ * @param begin First record.
+ * @param end   One past the last record.
+ * @param fold  Fold accents and Unicode forms as for `--fuzzy`.
+ * @param batch Receives the stems and tokens.
+ */
+void foldStems(const FileTable &files, std::size_t begin, std::size_t end, bool fold, NameBatch &batch);
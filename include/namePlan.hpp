@@ -0,0 +1,47 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "fileTable.hpp"
+#include "planner.hpp"
+#include "tokenMatcher.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+ * @file namePlan.hpp
+ * @brief Move planning by file name, shared by `cleanFilesByName()` and `CleanSession`.
+ *
+ * The implementation lives in `src/namePlan.cpp`.
+ */
+
+/**
+ * @brief Build a finalized plan that groups files into name folders.
+ *
+ * With `tokens`, every file whose name contains one of them
+ * (case-insensitive, one pass per name through a `TokenMatcher`) is
+ * planned into a folder named after the token chosen by `policy`; slashes
+ * in a token become underscores.
+ *
+ * Without tokens, the ten most common stem tokens (seen at least twice and
+ * not in `ignoreTokens`) are detected from an inverted index
+ * (`buildTokenIndex()`), or with `fuzzy` the ten largest groups of
+ * similarly spelled tokens (`clusterTokens()`). Each file goes to the first,
+ * most frequent group it belongs to; groups left with fewer than two files
+ * are dropped.
+ *
+ * @param root     Directory being organized.
+ * @param files    Scanned files.
+ * @param tokens   Names to match, in priority order; empty auto-detects.
+ * @param ignoreTokens Lowercase tokens never detected (`RuleSet::ignoreTokens`
+ *                 of the rules the files were classified with).
+ * @param destRoot Directory receiving the name folders; empty means `root`.
+ * @param policy   Which token wins when a name contains several.
+ * @param fuzzy    Fold accents and group similar tokens when auto-detecting.
+ * @param threads  Worker threads for the token index; 0 selects all cores.
+ * @return MovePlan Finalized plan; no moves when nothing matched.
+ */
+MovePlan planByName(const fs::path &root, const FileTable &files, const std::vector<std::string> &tokens,
+                    const std::vector<std::string> &ignoreTokens, const fs::path &destRoot = {}, MatchPolicy policy = MatchPolicy::Longest,
+                    bool fuzzy = false, unsigned threads = 0);
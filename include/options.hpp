@@ -0,0 +1,176 @@
+#pragma once
+#include <string>
+
+#include <vector>
+
+#include "dedupe.hpp"
+#include "scanner.hpp"
+#include "tokenMatcher.hpp"
+
+/**
+ * @file options.hpp
+ * @brief Run-time options shared by the cleaning and listing operations.
+ *
+ * The interactive TUI in `main.cpp` and the argv-driven command line mode
+ * in `cli.cpp` both drive the same engines (`cleanFilesByType()`,
+ * `cleanFilesByName()` and `listFilesInDirectory()`). This header defines
+ * the small options structure those engines accept so that the same code
+ * path can run either with prompts and screen clears or fully unattended.
+ */
+
+/**
+ * @brief How `listFilesInDirectory()` presents the files it finds.
+ */
+enum class ListMode
+{
+    Grouped, ///< Collect all files, then print them grouped by type (default).
+    Stream,  ///< Print each file as soon as it is listed; memory stays flat.
+    Summary  ///< Print only per-type file counts and total sizes.
+};
+
+/**
+ * @brief How the clean engines report their results.
+ */
+enum class OutputFormat
+{
+    Text, ///< Colored, human-readable lines (default).
+    Jsonl ///< One JSON object per file plus a summary (see `resultLog.hpp`).
+};
+
+/**
+ * @brief Options controlling a single clean or list operation.
+ *
+ * A default-constructed instance reproduces the original interactive
+ * behaviour, so existing TUI call sites do not need to pass anything.
+ */
+struct CleanOptions
+{
+    /**
+     * @brief Whether the operation may prompt, pause and clear the screen.
+     *
+     * When `false` the engines never read from `std::cin` and never call
+     * `Header::display()`, which makes them safe to run from cron or other
+     * batch jobs without a terminal attached.
+     */
+    bool interactive = true;
+
+    /**
+     * @brief Substring used by `cleanFilesByName()` in non-interactive mode.
+     *
+     * An empty token selects the auto-detection of common name tokens,
+     * matching the behaviour of pressing Enter at the interactive prompt.
+     */
+    std::string token;
+
+    /**
+     * @brief Additional tokens for `cleanFilesByName()`, in priority order.
+     *
+     * All tokens (including `token`, which comes first) are matched in one
+     * pass per file name; each file goes to one token folder chosen by
+     * `matchPolicy`.
+     */
+    std::vector<std::string> tokens;
+
+    /// Which token wins when a name contains several.
+    MatchPolicy matchPolicy = MatchPolicy::Longest;
+
+    /**
+     * @brief Group similar names in the auto-detect mode of `cleanFilesByName()`.
+     *
+     * Stems are folded (accents removed) and tokens spelled almost alike
+     * share a folder (see `clusterTokens()`).
+     */
+    bool fuzzy = false;
+
+    /// How the target directory is walked (recursion, depth limit, threads).
+    ScanOptions scan;
+
+    /// Build and report the move plan without moving anything.
+    bool dryRun = false;
+
+    /// When non-empty, the move plan is also saved to this JSON file.
+    std::string planFile;
+
+    /// Maximum number of file moves in flight at once (1 = sequential).
+    unsigned moveJobs = 1;
+
+    /**
+     * @brief Submit the renames in batches through io_uring (Linux).
+     *
+     * Falls back to one rename at a time where io_uring is unavailable
+     * (see `moveFilesBatched()`); `moveJobs` is ignored when set.
+     */
+    bool ioUring = false;
+
+    /**
+     * @brief Directory that receives the category/token folders.
+     *
+     * Empty means the organized directory itself. It may be on another
+     * volume; moves then fall back to a kernel-side copy (see `moveFile()`).
+     */
+    std::string destination;
+
+    /**
+     * @brief Write-ahead journal file; empty disables journaling.
+     *
+     * Ready moves are recorded before execution and completions as they
+     * happen, so `resume` and `undo` can replay the run later.
+     */
+    std::string journalFile;
+
+    /**
+     * @brief Persistent scan index; empty scans the whole tree every time.
+     *
+     * Unchanged directories are taken from the index instead of being
+     * listed again (see `scanDirectoryIndexed()`).
+     */
+    std::string indexFile;
+
+    /**
+     * @brief Also recognize files by content.
+     *
+     * Files whose extension is unknown are sniffed for magic numbers before
+     * the type plan is built (see `sniffTypes()`).
+     */
+    bool sniff = false;
+
+    /**
+     * @brief Lay out photos and videos by capture date.
+     *
+     * Files in "Images" and "Videos" go to `<Category>/YYYY/MM` by the
+     * date in their EXIF or MP4 / QuickTime header, falling back to their
+     * modification time (see `mediaDate.hpp`).
+     */
+    bool byDate = false;
+
+    /**
+     * @brief Compare file contents before moving.
+     *
+     * Files whose content already exists at the destination (or earlier in
+     * the plan) are left alone or hard-linked (see `findDuplicates()`).
+     */
+    DedupeMode dedupe = DedupeMode::Off;
+
+    /**
+     * @brief Move dangerous files into a restricted quarantine folder.
+     *
+     * Instead of being left in place and reported on every run, they go to
+     * `<destination>/Quarantine/` (owner-only access, execute permissions
+     * removed), which later recursive scans skip (see `quarantine.hpp`).
+     */
+    bool quarantine = false;
+
+    /**
+     * @brief Command run on newly quarantined files; empty runs none.
+     *
+     * The paths are appended as arguments, many per process (see
+     * `QuarantineScanner`).
+     */
+    std::string quarantineScan;
+
+    /// Presentation used by `listFilesInDirectory()`.
+    ListMode listMode = ListMode::Grouped;
+
+    /// Report format of `clean type`, `clean name` and `clean jobs`.
+    OutputFormat output = OutputFormat::Text;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+/**
+ * @file outputBuffer.hpp
+ * @brief Large reusable buffer for writing many short lines to a `FILE*`.
+ *
+ * Formatting a row through several `std::cout <<` calls and `std::setw`
+ * costs far more than the row itself when millions of lines are printed.
+ * `OutputBuffer` appends rows to one preallocated string and hands it to
+ * `fwrite()` whenever it fills up, so output starts right away and the
+ * amount of memory used never depends on the number of rows.
+ */
+
+/**
+ * @brief Append-only output buffer flushed in large blocks.
+ */
+class OutputBuffer
+{
+public:
+    /// Default buffer size: large enough to amortize the write call.
+    static constexpr std::size_t DefaultCapacity = 1 << 20;
+
+    /**
+     * @param out      Stream receiving the output (usually `stdout`).
+     * @param capacity Bytes buffered before a flush.
+     */
+    explicit OutputBuffer(std::FILE *out = stdout, std::size_t capacity = DefaultCapacity)
+        : out_(out), capacity_(capacity)
+    {
+        // Anything already queued on std::cout must come first
+        std::cout.flush();
+        buffer_.reserve(capacity_);
+    }
+
+    ~OutputBuffer() { flush(); }
+
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    /// Append raw text.
+    OutputBuffer &append(std::string_view text)
+    {
+        if (buffer_.size() + text.size() > capacity_)
+            flush();
+        buffer_.append(text);
+        return *this;
+    }
+
+    /// Append `count` copies of `c` (used for column padding).
+    OutputBuffer &pad(std::size_t count, char c = ' ')
+    {
+        if (buffer_.size() + count > capacity_)
+            flush();
+        buffer_.append(count, c);
+        return *this;
+    }
+
+    /// Append a decimal number.
+    OutputBuffer &number(unsigned long long value)
+    {
+        char digits[24];
+        int n = std::snprintf(digits, sizeof digits, "%llu", value);
+        return append(std::string_view(digits, static_cast<std::size_t>(n)));
+    }
+
+    /// Write out everything buffered so far.
+    void flush()
+    {
+        if (!buffer_.empty())
+        {
+            std::fwrite(buffer_.data(), 1, buffer_.size(), out_);
+            buffer_.clear();
+        }
+        std::fflush(out_);
+    }
+
+private:
+    std::FILE *out_;
+    std::size_t capacity_;
+    std::string buffer_;
+};
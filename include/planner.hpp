@@ -0,0 +1,232 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "fileTable.hpp"
+
+namespace fs = std::filesystem;
+
+class MoveJournal;
+class ProgressReporter;
+
+/**
+ * @file planner.hpp
+ * @brief Move planning and plan execution shared by the cleaning engines.
+ *
+ * Cleaning is split into two stages. The planning stage decides, for every
+ * candidate file, where it should go and whether the move can happen
+ * (conflicts, dangerous files) without touching the filesystem beyond one
+ * listing per destination directory. The execution stage then creates each
+ * destination directory once and performs the renames.
+ *
+ * A plan can be printed or saved as JSON instead of being executed, which
+ * gives a dry-run preview of a reorganization.
+ *
+ * The implementation lives in `src/planner.cpp`.
+ */
+
+/**
+ * @brief Outcome decided for a planned move.
+ */
+enum class MoveStatus
+{
+    Ready,             ///< The file will be moved.
+    DestinationExists, ///< A file with the same name already exists at the destination.
+    DuplicateInPlan,   ///< An earlier move in the plan targets the same destination.
+    Dangerous,         ///< The extension is flagged as dangerous; the file is left alone.
+    Identical          ///< The same content is already kept at `duplicateOf` (see `findDuplicates()`).
+};
+
+/**
+ * @brief One file's entry in a move plan.
+ */
+struct PlannedMove
+{
+    fs::path source;      ///< Current location of the file.
+    fs::path destination; ///< Full target path, including the file name.
+    std::string category; ///< Type category or name token the file is grouped under.
+    MoveStatus status = MoveStatus::Ready;
+    std::uint64_t journalId = 0;        ///< Id assigned by `MoveJournal::recordPlan()`, 0 if unjournaled.
+    fs::path duplicateOf;               ///< Kept copy of an `Identical` file (after the plan has run).
+    std::uint64_t duplicateSize = 0;    ///< Size of both files when their bytes were compared.
+    fs::file_time_type sourceTime{};    ///< Modification time of `source` when compared.
+    fs::file_time_type duplicateTime{}; ///< Modification time of the kept copy when compared.
+    bool quarantined = false;           ///< A dangerous file planned into `MovePlan::quarantineDir`.
+};
+
+/**
+ * @brief An in-memory move plan for one directory.
+ */
+struct MovePlan
+{
+    fs::path root;                    ///< Directory being organized.
+    fs::path destRoot;                ///< Where category/token folders are created (usually `root`).
+    std::vector<PlannedMove> moves;   ///< Planned moves in scan order.
+    std::vector<fs::path> directories; ///< Destination directories needed by ready moves.
+    bool linkDuplicates = false;      ///< Replace `Identical` files with hard links when executed.
+    fs::path quarantineDir;           ///< Folder of the quarantined moves; empty without quarantine.
+
+    /**
+     * @brief Count the moves with a given status.
+     */
+    std::size_t count(MoveStatus status) const;
+};
+
+/**
+ * @brief What happened to one move of an executed plan.
+ */
+enum class MoveOutcome : std::uint8_t
+{
+    Skipped, ///< Not attempted: the move was not ready.
+    Moved,   ///< The file is at its destination.
+    Linked,  ///< The identical file was replaced with a hard link.
+    Failed   ///< The move was ready but its directory or the rename failed (see `failures`).
+};
+
+/**
+ * @brief Totals reported after executing a plan.
+ */
+struct MoveResult
+{
+    std::size_t moved = 0;             ///< Files successfully moved.
+    std::size_t skipped = 0;           ///< Files not moved (conflicts, dangerous, errors).
+    std::size_t linked = 0;            ///< Identical files replaced with hard links.
+    std::size_t quarantined = 0;       ///< Moved files that went into quarantine (included in `moved`).
+    std::vector<fs::path> skippedFiles; ///< File names of the skipped files.
+    std::vector<MoveOutcome> outcomes; ///< One entry per move, in plan order.
+    std::vector<std::pair<std::size_t, std::error_code>> failures; ///< Failed moves (plan index, error), in plan order.
+    bool cancelled = false;            ///< The run was cancelled; moves not attempted count as skipped.
+};
+
+/**
+ * @brief Human-readable name of a status (also used in JSON output).
+ */
+const char *moveStatusName(MoveStatus status);
+
+/**
+ * @brief Append a move to a plan.
+ *
+ * Files that already sit in `destDir` are not added. Conflict status is
+ * decided later by `finalizePlan()`.
+ *
+ * @param plan     Plan to extend.
+ * @param source   File to move.
+ * @param destDir  Directory the file should end up in.
+ * @param category Category or token recorded for reporting.
+ * @param status   Initial status (use `MoveStatus::Dangerous` to record a
+ *                 file that must not be moved).
+ */
+void addMove(MovePlan &plan, const fs::path &source, const fs::path &destDir,
+             const std::string &category, MoveStatus status = MoveStatus::Ready);
+
+/**
+ * @brief Resolve conflicts and collect the destination directories.
+ *
+ * Each existing destination directory is listed once; a ready move whose
+ * file name is already present becomes `DestinationExists`, and every move
+ * after the first one targeting the same path becomes `DuplicateInPlan`.
+ *
+ * @param plan Plan to finalize in place.
+ */
+void finalizePlan(MovePlan &plan);
+
+/**
+ * @brief Build a finalized plan that sorts files into type directories.
+ *
+ * Uses the shared `ExtClassifier`: dangerous files are recorded with
+ * `MoveStatus::Dangerous` and every other file is planned into
+ * `destRoot/<Category>/`, or into the folder of the first routing rule
+ * of the classifier that matches its record (see `routeRules.hpp`).
+ *
+ * With `byDate`, photos and videos that no rule routes go to
+ * `destRoot/<Category>/YYYY/MM/` by capture date (`captureMonth()`): the
+ * date read by `readCaptureDates()`, else the modification time when the
+ * scan collected it.
+ *
+ * With `quarantine`, dangerous files are planned as ready moves into
+ * `destRoot/Quarantine/` instead (see `quarantine.hpp`).
+ *
+ * @param root     Directory being organized.
+ * @param files    Candidate files, as returned by `scanDirectory()`; the
+ *                 categories recorded during the scan are used.
+ * @param destRoot Directory receiving the category folders; empty means
+ *                 `root`. It may live on another filesystem.
+ * @param byDate   Partition photos and videos by year and month.
+ * @param quarantine Move dangerous files into the quarantine folder.
+ * @return MovePlan Finalized plan.
+ */
+MovePlan planByType(const fs::path &root, const FileTable &files,
+                    const fs::path &destRoot = {}, bool byDate = false, bool quarantine = false);
+
+/**
+ * @brief Print a plan, one line per move, followed by per-status totals.
+ *
+ * @param plan Plan to print.
+ * @param out  Destination stream.
+ */
+void printPlan(const MovePlan &plan, std::ostream &out);
+
+/**
+ * @brief Save a plan as JSON.
+ *
+ * The file contains `root`, `destRoot`, `directories` and a `moves` array whose
+ * entries hold `source`, `destination`, `category` and `status`. Moves are
+ * streamed one by one, so large plans do not need a full JSON DOM.
+ *
+ * @param plan Plan to save.
+ * @param file Output file path.
+ * @return bool False when the file could not be written.
+ */
+bool savePlanJson(const MovePlan &plan, const fs::path &file);
+
+/**
+ * @brief Apply a plan.
+ *
+ * Creates and opens every directory in `plan.directories` once through a
+ * `DestinationDirs` cache, creating missing parents of nested folders only
+ * the first time, then moves every ready file with `moveFileInto()`
+ * relative to its directory's handle, which falls back to a kernel-side copy when
+ * the destination is on another filesystem. Moves whose directory could not be created, and renames that
+ * fail, are reported to `std::cerr` and counted as skipped, as are all
+ * moves that were not ready.
+ *
+ * With `jobs > 1` up to `jobs` renames are in flight at once on a
+ * `ThreadPool`, which hides per-operation latency on network filesystems.
+ * Moves are sharded by destination path, so moves that compete for the same
+ * destination always run on one shard in plan order and conflict handling
+ * is identical to a sequential run.
+ *
+ * With `plan.linkDuplicates`, each `Identical` file whose kept copy is in
+ * place once the moves are done is then replaced by a hard link to it
+ * (same path, same content, one copy on disk).
+ *
+ * The quarantine folder of a plan is restricted to its owner before the
+ * first move, and each quarantined file loses every permission but the
+ * owner's read and write once it is in place.
+ *
+ * With `batched` the renames are submitted through `moveFilesBatched()`
+ * (io_uring on Linux, one system call per batch) and `jobs` is ignored;
+ * per-move timings are not recorded in that mode.
+ *
+ * When a journal is given, each completed move with a `journalId` is
+ * recorded in it so an interrupted run can be resumed or undone.
+ *
+ * With `progress`, every attempted move is counted in a
+ * `ProgressPhase::Move` phase, and once its token is cancelled no further
+ * move is started (batched renames already submitted still complete).
+ *
+ * @param plan    Finalized plan to execute.
+ * @param jobs    Maximum number of concurrent move operations (1 = sequential).
+ * @param journal Optional journal receiving completion records.
+ * @param batched Submit renames in batches instead of one at a time.
+ * @param progress Optional progress reporter and cancellation check.
+ * @return MoveResult Moved/skipped totals; `skippedFiles` is in plan order.
+ */
+MoveResult executePlan(const MovePlan &plan, unsigned jobs = 1, MoveJournal *journal = nullptr,
+                       bool batched = false, ProgressReporter *progress = nullptr);
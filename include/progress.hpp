@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+/**
+ * @file progress.hpp
+ * @brief Cancellation and throttled progress reports for long operations.
+ *
+ * A `CancelToken` is a flag the caller sets, from any thread or a signal
+ * handler, to stop a scan or a plan execution early; the engines check it
+ * between directories and between moves, so in-flight operations always
+ * finish and nothing is left half-moved.
+ *
+ * A `ProgressReporter` counts the work done by the scanner workers or the
+ * movers and calls a callback at most once per interval (and once at the
+ * end of each phase), so a million-file run costs a handful of callbacks
+ * rather than one per file. Counting is a relaxed atomic add.
+ *
+ * The implementation lives in `src/progress.cpp`.
+ */
+
+/**
+ * @brief Cooperative cancellation flag.
+ */
+class CancelToken
+{
+public:
+    /// Ask the operations watching this token to stop; async-signal-safe.
+    void cancel() noexcept { cancelled_.store(true, std::memory_order_relaxed); }
+
+    /// Clear the flag so the token can be used again.
+    void reset() noexcept { cancelled_.store(false, std::memory_order_relaxed); }
+
+    bool cancelled() const noexcept { return cancelled_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> cancelled_{false};
+};
+
+/**
+ * @brief Stage a progress report belongs to.
+ */
+enum class ProgressPhase : std::uint8_t
+{
+    Scan, ///< Files found so far; the total is not known in advance.
+    Plan, ///< Files classified and planned.
+    Move  ///< Ready moves attempted, out of all ready moves.
+};
+
+/**
+ * @brief One progress report.
+ */
+struct Progress
+{
+    ProgressPhase phase = ProgressPhase::Scan;
+    std::uint64_t done = 0;  ///< Items finished in this phase.
+    std::uint64_t total = 0; ///< Items in this phase, or 0 when unknown.
+    bool finished = false;   ///< Last report of the phase.
+};
+
+/// Receives progress reports; called from worker threads, never concurrently.
+using ProgressCallback = std::function<void(const Progress &)>;
+
+/**
+ * @brief Counts progress from many threads and reports it at a bounded rate.
+ */
+class ProgressReporter
+{
+public:
+    /// Default time between two reports of one phase.
+    static constexpr std::chrono::milliseconds DefaultInterval{100};
+
+    /**
+     * @param callback Receives the reports; may be empty.
+     * @param cancel   Token checked by `cancelled()`; may be null.
+     * @param interval Minimum time between two reports of a phase.
+     */
+    explicit ProgressReporter(ProgressCallback callback = {}, const CancelToken *cancel = nullptr,
+                              std::chrono::milliseconds interval = DefaultInterval);
+
+    ProgressReporter(const ProgressReporter &) = delete;
+    ProgressReporter &operator=(const ProgressReporter &) = delete;
+
+    /// Whether the operation should stop.
+    bool cancelled() const noexcept { return cancel_ && cancel_->cancelled(); }
+
+    /**
+     * @brief Begin a phase; resets the count and reports it once.
+     *
+     * @param phase Phase that starts.
+     * @param total Items it will process, or 0 when unknown.
+     */
+    void start(ProgressPhase phase, std::uint64_t total = 0);
+
+    /**
+     * @brief Count `n` finished items; reports when the interval has passed.
+     *
+     * Safe to call from any thread.
+     */
+    void advance(std::uint64_t n = 1);
+
+    /// End the current phase with a final report.
+    void finish();
+
+private:
+    void report(bool finished);
+
+    ProgressCallback callback_;
+    const CancelToken *cancel_;
+    std::int64_t interval_; ///< Nanoseconds.
+    ProgressPhase phase_ = ProgressPhase::Scan;
+    std::uint64_t total_ = 0;
+    std::atomic<std::uint64_t> done_{0};
+    std::atomic<std::int64_t> next_{0}; ///< Steady-clock time of the next report, in nanoseconds.
+    std::mutex mutex_;                  ///< Serializes the callback.
+};
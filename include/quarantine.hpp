@@ -0,0 +1,131 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "planner.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+ * @file quarantine.hpp
+ * @brief Quarantine of dangerous files (`--quarantine`).
+ *
+ * Without quarantine, files flagged dangerous are reported and left where
+ * they are, so every later run lists, classifies and reports them again.
+ * In quarantine mode `planByType()` plans them into
+ * `<destRoot>/Quarantine/` instead. `executePlan()` makes that folder
+ * accessible to its owner only before the first move and removes every
+ * permission but the owner's read and write from each file it moves there.
+ * Recursive scans of a quarantining run never enter the folder (see
+ * `ScanOptions::exclude`), and the scan index keeps it as a subdirectory
+ * that is not visited, so quarantined files cost nothing on later runs.
+ *
+ * Quarantined files can also be handed to an external scanner: a
+ * `QuarantineScanner` queues their paths and runs the command on a
+ * background thread with up to `BatchSize` paths per process.
+ *
+ * The implementation lives in `src/quarantine.cpp`.
+ */
+
+/// Name of the quarantine folder below the destination root.
+constexpr const char *QuarantineFolder = "Quarantine";
+
+/**
+ * @brief Path of the quarantine folder relative to `root`, for `ScanOptions::exclude`.
+ *
+ * @param root     Directory being organized.
+ * @param destRoot Directory receiving the sorted folders; empty means `root`.
+ * @return std::string The folder with '/' separators, or empty when it is
+ *         not below `root` (a `--dest` elsewhere).
+ */
+std::string quarantineExclude(const fs::path &root, const fs::path &destRoot);
+
+/**
+ * @brief Restrict the quarantine folder to its owner (mode 0700).
+ *
+ * @param dir Folder, which must exist.
+ * @param ec  Set when the permissions could not be changed.
+ */
+void restrictQuarantineDir(const fs::path &dir, std::error_code &ec);
+
+/**
+ * @brief Strip a quarantined file to owner read and write (mode 0600).
+ *
+ * Removes every execute bit along with group and other access.
+ *
+ * @param file File in the quarantine folder.
+ * @param ec   Set when the permissions could not be changed.
+ */
+void restrictQuarantinedFile(const fs::path &file, std::error_code &ec);
+
+/**
+ * @brief Runs an external command on quarantined files, many at a time.
+ *
+ * Paths are queued by `submit()` and handed to the command by a
+ * background thread as extra arguments, up to `BatchSize` paths (and
+ * `MaxArgBytes` bytes of them) per process, so a burst of quarantined
+ * files in a watched inbox starts a few processes rather than one per
+ * file and never holds up the moves. The command is split at spaces and
+ * run without a shell. A non-zero exit status (for most virus scanners:
+ * something was found) is reported to `std::cerr`, or as a
+ * `quarantineScan` record in JSON Lines mode.
+ *
+ * External scans need `posix_spawnp()`; on Windows `submit()` only warns.
+ */
+class QuarantineScanner
+{
+public:
+    /// Most paths passed to one process.
+    static constexpr std::size_t BatchSize = 256;
+
+    /// Most bytes of paths passed to one process (well below `ARG_MAX`).
+    static constexpr std::size_t MaxArgBytes = 128 * 1024;
+
+    /**
+     * @param command Scanner command line, e.g. "clamscan --no-summary".
+     * @param jsonl   Report results as JSON Lines records.
+     */
+    QuarantineScanner(const std::string &command, bool jsonl);
+
+    /// Waits for every queued path to be scanned.
+    ~QuarantineScanner();
+
+    QuarantineScanner(const QuarantineScanner &) = delete;
+    QuarantineScanner &operator=(const QuarantineScanner &) = delete;
+
+    /**
+     * @brief Queue the files of an executed plan that were moved into quarantine.
+     *
+     * @param plan   Executed plan.
+     * @param result Its outcome.
+     */
+    void submit(const MovePlan &plan, const MoveResult &result);
+
+    /**
+     * @brief Wait until every queued path has been scanned.
+     *
+     * @return std::size_t Batches whose command failed or exited non-zero so far.
+     */
+    std::size_t drain();
+
+private:
+    void run();
+    void scanBatch(const std::vector<std::string> &paths);
+
+    std::vector<std::string> argv_; ///< Command words, before the paths.
+    bool jsonl_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<std::string> queue_;
+    bool busy_ = false; ///< A batch is being scanned.
+    bool stop_ = false;
+    std::size_t failures_ = 0;
+    std::thread thread_;
+};
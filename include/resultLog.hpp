@@ -0,0 +1,140 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "planner.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+ * @file resultLog.hpp
+ * @brief Machine-readable results (`--output jsonl`): one JSON object per line.
+ *
+ * In JSON Lines mode the engines write one record per file of the plan
+ * (`moved`, `quarantined`, `linked`, `skipped`, `failed`, `dangerous`, or
+ * `planned` in a dry run) followed by a `summary` record, instead of the colored text
+ * report. Every record is a flat object whose `event` key comes first:
+ *
+ * @code{.json}
+ * {"event":"moved","source":"/d/a.jpg","destination":"/d/Images/a.jpg","category":"Images"}
+ * {"event":"skipped","source":"/d/b.jpg","destination":"/d/Images/b.jpg","category":"Images","reason":"exists"}
+ * {"event":"summary","root":"/d","dryRun":false,"planned":2,"moved":1,"skipped":1,"linked":0,"failed":0,"dangerous":0}
+ * @endcode
+ *
+ * Records are formatted into a local buffer and handed to the process-wide
+ * `resultLog()` writer in large chunks. The writer double-buffers: while a
+ * background thread writes one megabyte-sized block to standard output,
+ * the engines fill the next one, so a million-file run costs a few hundred
+ * `fwrite()` calls and the moves never wait on a slow reader.
+ *
+ * Strings are escaped as JSON; bytes that are not valid UTF-8 (possible
+ * in file names) are written as U+FFFD.
+ *
+ * The implementation lives in `src/resultLog.cpp`.
+ */
+
+/**
+ * @brief Thread-safe, double-buffered writer of complete lines.
+ */
+class JsonlWriter
+{
+public:
+    /// Bytes collected before a block is handed to the writer thread.
+    static constexpr std::size_t DefaultCapacity = 1 << 20;
+
+    /**
+     * @param out        Stream receiving the lines (usually `stdout`).
+     * @param capacity   Size of each of the two blocks.
+     * @param background Write blocks from a background thread.
+     */
+    explicit JsonlWriter(std::FILE *out = stdout, std::size_t capacity = DefaultCapacity, bool background = true);
+    ~JsonlWriter();
+
+    JsonlWriter(const JsonlWriter &) = delete;
+    JsonlWriter &operator=(const JsonlWriter &) = delete;
+
+    /**
+     * @brief Queue one or more complete lines.
+     *
+     * Lines from one call are never interleaved with another thread's.
+     */
+    void write(std::string_view lines);
+
+    /// Write out everything queued so far and flush the stream.
+    void flush();
+
+    /// Flush and stop the writer thread; later writes go out synchronously.
+    void close();
+
+private:
+    void handOff(std::unique_lock<std::mutex> &lock);
+    void run();
+
+    std::FILE *out_;
+    std::size_t capacity_;
+    bool background_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::string filling_; ///< Block receiving new lines.
+    std::string writing_; ///< Block owned by the writer thread while `busy_`.
+    bool busy_ = false;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+/// The process-wide writer on standard output.
+JsonlWriter &resultLog();
+
+/**
+ * @brief Builder for one flat JSON object, terminated by a newline.
+ */
+class JsonlRecord
+{
+public:
+    /// Start a record with its `event` key.
+    explicit JsonlRecord(std::string_view event) { text("event", event); }
+
+    JsonlRecord &text(std::string_view key, std::string_view value);
+    JsonlRecord &path(std::string_view key, const fs::path &value);
+    JsonlRecord &number(std::string_view key, std::uint64_t value);
+    JsonlRecord &real(std::string_view key, double value);
+    JsonlRecord &boolean(std::string_view key, bool value);
+
+    /// The finished line, including the closing brace and newline.
+    const std::string &line();
+
+private:
+    void key(std::string_view name);
+
+    std::string line_;
+    bool closed_ = false;
+};
+
+/**
+ * @brief Append `text` to `out` as a quoted JSON string.
+ */
+void appendJsonString(std::string &out, std::string_view text);
+
+/**
+ * @brief Write one record per move of a plan to `resultLog()`.
+ *
+ * @param plan   Finalized plan.
+ * @param result Outcome of `executePlan()`, or null for a dry run (every
+ *               move is reported as `planned` with its `status`).
+ */
+void logMoves(const MovePlan &plan, const MoveResult *result);
+
+/**
+ * @brief Write the `summary` record of a plan to `resultLog()`.
+ *
+ * @param plan   Finalized plan.
+ * @param result Outcome of `executePlan()`, or null for a dry run.
+ */
+void logSummary(const MovePlan &plan, const MoveResult *result);
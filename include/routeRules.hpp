@@ -0,0 +1,152 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct FileRecord;
+
+/**
+ * @file routeRules.hpp
+ * @brief Size- and age-aware routing of files to folders other than their category.
+ *
+ * By default a file goes to the folder of its category. Routing rules,
+ * listed under the `"$routes"` key of `data/fileTypes.json`, send some
+ * files elsewhere based on their category, size and age:
+ *
+ * @code{.json}
+ * "$routes": [
+ *   {"category": "Videos", "minSize": "4 GiB", "to": "Archive/Large"},
+ *   {"olderThan": "90d", "to": "Old/{category}"}
+ * ]
+ * @endcode
+ *
+ * The first matching rule wins. Keys: `category` (a name or a list of
+ * names; any category when absent), `minSize` / `maxSize` (bytes, or
+ * a string such as `"500 MB"` or `"4 GiB"`), `olderThan` / `newerThan`
+ * (seconds, or a string such as `"90d"`, `"12h"`, `"2w"`) and `to`, a
+ * folder relative to the destination root in which `{category}` is
+ * replaced by the category name. The list is read with the categories by `parseFileTypes()`.
+ *
+ * Rules are compiled once per rule set into a `RouteTable`: category names
+ * become per-category flags and every condition a flat predicate on the
+ * fields of a `FileRecord`. Sizes and times are the ones collected by the
+ * scan (`ScanOptions::withStat`), so evaluating the rules costs no system
+ * call; a record without them never matches a size or age condition.
+ *
+ * The implementation lives in `src/routeRules.cpp`.
+ */
+
+/**
+ * @brief One routing rule, as written in the rule data.
+ */
+struct RouteRule
+{
+    static constexpr std::uint64_t NoSizeLimit = std::numeric_limits<std::uint64_t>::max();
+    static constexpr std::int64_t NoAgeLimit = std::numeric_limits<std::int64_t>::max();
+
+    std::vector<std::string> categories; ///< Matching categories; empty matches all.
+    std::uint64_t minSize = 0;           ///< Smallest matching size in bytes.
+    std::uint64_t maxSize = NoSizeLimit; ///< Sizes from here up do not match.
+    std::int64_t minAge = 0;             ///< Youngest matching age in seconds (`olderThan`).
+    std::int64_t maxAge = NoAgeLimit;    ///< Ages from here up do not match (`newerThan`).
+    std::string to;                      ///< Folder below the destination root; may contain `{category}`.
+
+    /// Whether the rule looks at sizes or times.
+    bool needsStat() const
+    {
+        return minSize > 0 || maxSize != NoSizeLimit || minAge > 0 || maxAge != NoAgeLimit;
+    }
+};
+
+/**
+ * @brief Parse a size: a byte count or a string like `"4 GiB"`, `"1.5G"` or `"500 MB"`.
+ *
+ * `K`, `M`, `G` and `T` (with or without a trailing `iB`) are powers of
+ * 1024; `KB`, `MB`, `GB` and `TB` are powers of 1000.
+ */
+bool parseByteSize(std::string_view text, std::uint64_t &bytes);
+
+/**
+ * @brief Parse an age: seconds or a string like `"90d"`, `"12h"`, `"30 min"`.
+ *
+ * Units are `s`, `min`, `h`, `d`, `w` and `y` (365 days).
+ */
+bool parseAge(std::string_view text, std::int64_t &seconds);
+
+/**
+ * @brief Routing rules compiled against the categories of one classifier.
+ */
+class RouteTable
+{
+public:
+    /// Returned by `match()` when no rule applies.
+    static constexpr std::size_t NoRoute = static_cast<std::size_t>(-1);
+
+    RouteTable() = default;
+
+    /**
+     * @brief Compile `rules`.
+     *
+     * Category names that are not in `categories` are reported to
+     * `std::cerr` and ignored.
+     *
+     * @param rules      Rules in priority order.
+     * @param categories Category names, indexed by `CategoryId`.
+     */
+    RouteTable(const std::vector<RouteRule> &rules, const std::vector<std::string> &categories);
+
+    bool empty() const { return routes_.empty(); }
+
+    /// Whether any rule needs sizes or times, i.e. the scan must collect them.
+    bool needsStat() const { return needsStat_; }
+
+    /**
+     * @brief First rule matching a record.
+     *
+     * @param record Scanned file.
+     * @param now    Current time in nanoseconds of the file clock (see `now()`).
+     * @return std::size_t Rule index, or `NoRoute`.
+     */
+    std::size_t match(const FileRecord &record, std::int64_t now) const;
+
+    /// Folder of rule `route` for a file of `category`, relative to the destination root.
+    fs::path folder(std::size_t route, const std::string &category) const;
+
+    /// Current time in nanoseconds of the file clock, comparable with `FileRecord::mtime`.
+    static std::int64_t now();
+
+private:
+    enum class Test : std::uint8_t
+    {
+        Category, ///< `value` is the offset of the rule's flags in `categoryFlags_`.
+        MinSize,
+        MaxSize,
+        MinAge,   ///< `value` in nanoseconds.
+        MaxAge
+    };
+
+    struct Predicate
+    {
+        Test test;
+        std::uint64_t value;
+    };
+
+    struct Route
+    {
+        std::uint32_t first = 0; ///< First predicate.
+        std::uint32_t count = 0;
+        std::string to;
+    };
+
+    std::vector<Predicate> predicates_;
+    std::vector<Route> routes_;
+    std::vector<std::uint8_t> categoryFlags_; ///< One flag per category for each `Category` test.
+    std::size_t categoryCount_ = 0;
+    bool needsStat_ = false;
+};
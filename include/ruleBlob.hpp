@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "routeRules.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+ * @file ruleBlob.hpp
+ * @brief Compiled rule bundle: the JSON files in `data/` turned into one binary file.
+ *
+ * Parsing three JSON documents with `json.hpp` dominates the runtime of
+ * short invocations (cron jobs, hooks). `clean compile-rules` writes the
+ * same rules into `data/rules.bin`, a flat, versioned file that is mapped
+ * with `MappedFile` and decoded in microseconds; when it is present and up
+ * to date the JSON files are not opened at all.
+ *
+ * The bundle records the size and mtime of the JSON files it was compiled
+ * from, so an edited JSON file makes it stale and the JSON is used again
+ * until the bundle is recompiled.
+ *
+ * The same rules can also be emitted as a C++ header of `constexpr` tables
+ * (`include/defaultRules.hpp`), which is what the built-in defaults are
+ * made of; see `CLEAN_EMBED_RULES` in `CMakeLists.txt`.
+ *
+ * The implementation lives in `src/ruleBlob.cpp`.
+ */
+
+/// Default location of the compiled bundle.
+inline constexpr const char *DefaultRuleBlob = "data/rules.bin";
+
+/**
+ * @brief Plain rule data, as read from any rule source.
+ */
+struct RuleData
+{
+    std::map<std::string, std::vector<std::string>> fileTypes; ///< Category → extensions (with dot).
+    std::vector<std::string> dangerousExts;                    ///< Extensions (with dot) never moved.
+    std::vector<std::string> ignoreTokens;                     ///< Lowercase tokens skipped by auto-detect.
+    std::vector<RouteRule> routes;                             ///< Routing rules (`"$routes"` of the file types).
+    std::vector<std::int64_t> stamps;                          ///< Source stamps (see `ruleSourceStamps()`).
+};
+
+/**
+ * @brief Read the rules from the JSON files (with their fallbacks).
+ */
+RuleData loadRuleSources();
+
+/**
+ * @brief The built-in rules from `defaultRules.hpp`.
+ */
+RuleData builtinRules();
+
+/**
+ * @brief Write a compiled bundle.
+ *
+ * Written to a temporary file and renamed over `file`.
+ *
+ * @return bool False when the file could not be written.
+ */
+bool writeRuleBlob(const fs::path &file, const RuleData &rules);
+
+/**
+ * @brief Map and decode a compiled bundle.
+ *
+ * @param file  Bundle path.
+ * @param rules Receives the rules and the stamps recorded at compile time.
+ * @return bool False when the file is missing, corrupt or of another version.
+ */
+bool readRuleBlob(const fs::path &file, RuleData &rules);
+
+/**
+ * @brief Write the rules as a header of `constexpr` tables.
+ *
+ * @return bool False when the file could not be written.
+ */
+bool writeRuleHeader(const fs::path &file, const RuleData &rules);
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "classifier.hpp"
+#include "routeRules.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+ * @file ruleSet.hpp
+ * @brief Immutable, hot-reloadable snapshot of all rule data.
+ *
+ * A `RuleSet` bundles everything loaded from the JSON files in `data/` (the
+ * category → extensions map with its routing rules, the dangerous
+ * extensions and the ignore tokens) together with the `ExtClassifier` built from them. The rules come
+ * from the compiled bundle `data/rules.bin` when it is up to date (see
+ * `ruleBlob.hpp`), otherwise from the JSON files, otherwise from the
+ * built-in tables. A set is
+ * never modified once published. `currentRules()` returns the current set
+ * with a single atomic load, so readers on the hot path (scanner workers,
+ * the watch loop) never take a lock.
+ *
+ * `reloadRules()` builds a fresh set and publishes it atomically;
+ * `reloadRulesIfChanged()` does so only when one of the data files changed
+ * on disk. Superseded sets are retired but kept alive until exit, so
+ * references obtained earlier stay valid and a scan classifies every file
+ * with one consistent set. Reloads are rare and a set is a few KiB.
+ *
+ * The implementation lives in `src/ruleSet.cpp`.
+ */
+
+/**
+ * @brief All rules used by one run, built once and then read-only.
+ */
+struct RuleSet
+{
+    RuleSet(std::map<std::string, std::vector<std::string>> types,
+            std::vector<std::string> dangerous,
+            std::vector<std::string> ignore,
+            std::vector<RouteRule> routeRules = {})
+        : fileTypes(std::move(types)), dangerousExts(std::move(dangerous)),
+          ignoreTokens(std::move(ignore)), routes(std::move(routeRules)),
+          classifier(fileTypes, dangerousExts, routes)
+    {
+    }
+
+    std::map<std::string, std::vector<std::string>> fileTypes; ///< Category → extensions (with dot).
+    std::vector<std::string> dangerousExts;                    ///< Extensions (with dot) never moved.
+    std::vector<std::string> ignoreTokens;                     ///< Lowercase tokens skipped by auto-detect.
+    std::vector<RouteRule> routes;                             ///< Size/age routing rules, in priority order.
+    ExtClassifier classifier;                                  ///< Lookup table built from the above.
+
+    std::uint64_t generation = 0;       ///< 1 for the first set, incremented by every reload.
+    std::vector<std::int64_t> stamps;   ///< Size and mtime of each rule file (JSON and bundle) at load time.
+};
+
+/**
+ * @brief Size and mtime of every JSON rule file in `data/` (-1 when missing).
+ *
+ * Compared against `RuleSet::stamps` to detect edits, and recorded in a
+ * compiled bundle to detect a stale one.
+ */
+std::vector<std::int64_t> ruleSourceStamps();
+
+/**
+ * @brief The current rule set, loaded on first use.
+ *
+ * Lock-free after the first call. The reference stays valid for the rest
+ * of the process, even across reloads.
+ */
+const RuleSet &currentRules();
+
+/**
+ * @brief Load the data files again and publish the result.
+ *
+ * Safe to call from any thread; concurrent reloads are serialized. Every
+ * call keeps one more set alive until exit, so repeated reloads should go
+ * through `reloadRulesIfChanged()`.
+ *
+ * @return const RuleSet& The newly published set.
+ */
+const RuleSet &reloadRules();
+
+/**
+ * @brief Reload when a data file was created, changed or removed.
+ *
+ * Costs one `stat()` per data file when nothing changed.
+ *
+ * @return bool True when a new set was published.
+ */
+bool reloadRulesIfChanged();
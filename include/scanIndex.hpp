@@ -0,0 +1,154 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "fileTable.hpp"
+#include "mappedFile.hpp"
+#include "scanner.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+ * @file scanIndex.hpp
+ * @brief Persistent, memory-mapped scan index for incremental re-runs.
+ *
+ * The index records, for every directory of the last scan, its
+ * modification time, its file names (with size and mtime when they were
+ * collected) and its subdirectory names. On the next run
+ * `scanDirectoryIndexed()` stats each directory once: when the mtime is
+ * unchanged the recorded entries are reused without listing the directory;
+ * only changed or new directories are listed again. A re-run therefore
+ * costs one `stat()` per directory plus a listing of what changed, instead
+ * of a listing of the whole tree.
+ *
+ * A directory modified within two seconds of a scan is stored as dirty,
+ * so changes landing in the same timestamp tick are never missed. Renaming
+ * or adding files changes the directory mtime; rewriting a file in place
+ * does not, so reused records keep the size and mtime seen when their
+ * directory was last listed.
+ *
+ * Capture dates read for the date layout (see `mediaDate.hpp`) are stored
+ * per file as well. They are reused with their directory, and also when a
+ * changed directory is listed again and the file's size and mtime match.
+ *
+ * By default the index lives in the user cache directory
+ * (`$XDG_CACHE_HOME/clean`, `~/.cache/clean` or `%LOCALAPPDATA%\clean`),
+ * one file per scanned root. The file is replaced atomically on save.
+ *
+ * The implementation lives in `src/scanIndex.cpp`.
+ */
+
+/**
+ * @brief Per-directory result of a scan, as needed to write the next index.
+ */
+struct DirState
+{
+    std::uint32_t dir = 0;               ///< Directory index in the scan's `FileTable`.
+    std::int64_t mtime = 0;              ///< Modification time, or `ScanIndex::Dirty`.
+    std::vector<std::string> subdirs;    ///< Names of the subdirectories.
+};
+
+/**
+ * @brief Read-only view of an index file, mapped into memory.
+ */
+class ScanIndex
+{
+public:
+    /// Stored instead of a real mtime for directories that must be listed next time.
+    static constexpr std::int64_t Dirty = std::numeric_limits<std::int64_t>::min();
+
+    /**
+     * @brief Recorded state of one directory.
+     */
+    struct Directory
+    {
+        std::int64_t mtime;
+        std::uint64_t firstFile;
+        std::uint32_t fileCount;
+        std::uint32_t subdirCount;
+        std::uint64_t firstSubdir;
+        bool allStat; ///< Every file has size and mtime recorded.
+    };
+
+    /**
+     * @brief One recorded file.
+     */
+    struct File
+    {
+        std::string_view name;
+        std::uint64_t size;
+        std::int64_t mtime;
+        bool hasStat;
+        std::int64_t captured; ///< `FileTable::captured()` when the index was written.
+    };
+
+    ScanIndex() = default;
+
+    ScanIndex(const ScanIndex &) = delete;
+    ScanIndex &operator=(const ScanIndex &) = delete;
+
+    /**
+     * @brief Map an index file.
+     *
+     * @param file Index path.
+     * @param root Scanned root; an index written for another root is ignored.
+     * @return bool False when the file is missing, corrupt or for another root.
+     */
+    bool load(const fs::path &file, const fs::path &root);
+
+    /// Recorded state of a directory (relative, '/'-separated), or null.
+    const Directory *find(std::string_view relative) const;
+
+    /// Recorded file `i` (`Directory::firstFile` + n).
+    File file(std::uint64_t i) const;
+
+    /// Recorded subdirectory name `i` (`Directory::firstSubdir` + n).
+    std::string_view subdir(std::uint64_t i) const;
+
+    /**
+     * @brief Write an index describing a completed scan.
+     *
+     * @param file  Index path; written to a temporary file and renamed over.
+     * @param table Scan result (before any filtering).
+     * @param dirs  Per-directory state collected during the scan.
+     * @return bool False when the index could not be written, or when its
+     *              names and paths exceed 4 GiB and could not be loaded back.
+     */
+    static bool save(const fs::path &file, const FileTable &table, const std::vector<DirState> &dirs);
+
+private:
+    void unmap();
+
+    MappedFile file_;
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+    std::unordered_map<std::string_view, Directory> dirs_;
+};
+
+/**
+ * @brief Default index location for a root: one file per root in the user cache directory.
+ */
+fs::path defaultIndexPath(const fs::path &root);
+
+/**
+ * @brief Scan `root`, reusing the entries of unchanged directories from an index.
+ *
+ * Loads `indexFile` (when present and valid for `root`), scans with
+ * `scanDirectory()` semantics and writes the refreshed index back. With an
+ * empty `indexFile` this is exactly `scanDirectory()`. The index file
+ * itself is left out of the result when it lives below `root`. With
+ * `options.withDates` the capture dates missing from the index are read
+ * before it is written.
+ *
+ * @param root      Directory to scan.
+ * @param options   Scan options.
+ * @param indexFile Index path, or empty to disable the index.
+ * @return FileTable Same result as a full scan.
+ */
+FileTable scanDirectoryIndexed(const fs::path &root, const ScanOptions &options, const fs::path &indexFile);
@@ -0,0 +1,141 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "fileTable.hpp"
+
+namespace fs = std::filesystem;
+
+class ProgressReporter;
+class ThreadPool;
+
+/**
+ * @file scanner.hpp
+ * @brief Shared directory scanner used by the list, type and name engines.
+ *
+ * `scanDirectory()` is the single place where the tool walks a directory
+ * tree. By default it behaves like a plain `fs::directory_iterator` over
+ * the top-level directory. In recursive mode subdirectories are spread
+ * across a bounded, work-stealing `ThreadPool` so that large nested trees
+ * are scanned on all cores.
+ */
+
+/**
+ * @brief Options controlling how a directory tree is scanned.
+ */
+struct ScanOptions
+{
+    /// Descend into subdirectories instead of scanning only the top level.
+    bool recursive = false;
+
+    /**
+     * @brief Maximum number of directory levels below the root to visit in
+     *        recursive mode; a negative value means unlimited.
+     */
+    int maxDepth = -1;
+
+    /// Worker threads for recursive scans; 0 selects the hardware concurrency.
+    unsigned threads = 0;
+
+    /// Also record each file's size and modification time (one `stat()` per file).
+    bool withStat = false;
+
+    /**
+     * @brief Also read the capture dates of photos and videos.
+     *
+     * Used by `scanDirectoryIndexed()`, which keeps the dates in the index
+     * and only reads the files it has no date for (see `readCaptureDates()`).
+     */
+    bool withDates = false;
+
+    /**
+     * @brief Subdirectories that recursive scans do not enter.
+     *
+     * Paths relative to the root with '/' separators, such as the
+     * quarantine folder (`quarantineExclude()`). They are still recorded as
+     * subdirectories in a scan index, so a later scan without them can
+     * reuse the index.
+     */
+    std::vector<std::string> exclude;
+
+    /// Classifier for the scanned records; null uses `getClassifier()`.
+    const ExtClassifier *classifier = nullptr;
+
+    /**
+     * @brief Pool that recursive scans run on; null starts one of `threads` workers.
+     *
+     * Lets a long-lived caller (see `CleanSession`) keep its workers warm
+     * across scans. The pool must not be running other work during the scan.
+     */
+    ThreadPool *pool = nullptr;
+
+    /**
+     * @brief Receives the number of files found and is checked for cancellation.
+     *
+     * A cancelled scan stops entering directories and returns the files
+     * found so far. May be null.
+     */
+    ProgressReporter *progress = nullptr;
+};
+
+/**
+ * @brief Collect the regular files below `root`.
+ *
+ * Symbolic links to directories are never followed. Directories that cannot
+ * be opened are reported to `std::cerr` and skipped rather than aborting the
+ * scan. Every file is classified as it is added, with `options.classifier`
+ * or else `getClassifier()`.
+ *
+ * @param root    Directory to scan.
+ * @param options Scan options (recursion, depth limit, worker count, stat).
+ * @return FileTable All regular files found, as compact records. The order
+ *         is unspecified in recursive mode.
+ */
+FileTable scanDirectory(const fs::path &root, const ScanOptions &options = {});
+
+/**
+ * @brief Fill in the size and modification time of a record added by hand.
+ *
+ * Costs one `stat()`; scans collect the same data with `withStat`.
+ *
+ * @param file   Path of the file.
+ * @param record Its record; gets `FileRecord::HasStat` on success.
+ * @return bool False when the file cannot be stat()ed.
+ */
+bool statRecord(const fs::path &file, FileRecord &record);
+
+class ScanIndex;
+struct DirState;
+
+/**
+ * @brief `scanDirectory()` that can reuse and record index state.
+ *
+ * Used by `scanDirectoryIndexed()`. With `states` non-null every directory
+ * is stat()ed once; directories whose mtime matches their entry in
+ * `previous` are not listed, and one `DirState` per visited directory is
+ * appended to `states`.
+ *
+ * @param root     Directory to scan.
+ * @param options  Scan options.
+ * @param previous Index of the last scan, or null.
+ * @param states   Receives directory states for the next index, or null.
+ * @return FileTable Files found.
+ */
+FileTable scanDirectory(const fs::path &root, const ScanOptions &options,
+                        const ScanIndex *previous, std::vector<DirState> *states);
+
+/**
+ * @brief Visit the regular files below `root` without collecting them.
+ *
+ * Walks the tree depth-first on the calling thread and calls `onFile` for
+ * every regular file as soon as it is listed, so memory use does not grow
+ * with the number of files. `options.threads` is ignored.
+ *
+ * @param root    Directory to scan.
+ * @param options Scan options (recursion and depth limit).
+ * @param onFile  Called once per regular file, in listing order.
+ */
+void scanEach(const fs::path &root, const ScanOptions &options,
+              const std::function<void(const fs::directory_entry &)> &onFile);
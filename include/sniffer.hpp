@@ -0,0 +1,83 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "classifier.hpp"
+#include "fileTable.hpp"
+
+/**
+ * @file sniffer.hpp
+ * @brief Content-based type detection from the first bytes of a file.
+ *
+ * Extension lookup leaves extensionless and mislabeled files in "Other".
+ * `sniffTypes()` gives those files a second chance: it reads their first
+ * `Sniffer::HeadSize` bytes with one positioned read per file and matches
+ * them against a built-in table of magic numbers (PNG, JPEG, PDF, ZIP,
+ * Matroska, ELF, ...). Files that already have a category are never opened,
+ * so the cost is proportional to the "Other" fraction of a scan.
+ *
+ * Signatures of executables (ELF, PE, Mach-O, `#!` scripts) mark a file
+ * dangerous instead of giving it a category, like the dangerous extensions.
+ *
+ * The implementation lives in `src/sniffer.cpp`.
+ */
+
+/**
+ * @brief Signature table compiled against one classifier's categories.
+ */
+class Sniffer
+{
+public:
+    /// Bytes read from the start of each file (enough for the tar header at 257).
+    static constexpr std::size_t HeadSize = 512;
+
+    /**
+     * @brief Resolve the built-in signatures to category ids.
+     *
+     * Signatures whose category the rules do not define are dropped.
+     *
+     * @param classifier Classifier whose category ids the results use.
+     */
+    explicit Sniffer(const ExtClassifier &classifier);
+
+    /**
+     * @brief Match the first bytes of a file.
+     *
+     * @param head   Up to `HeadSize` bytes from the start of the file.
+     * @param result Receives the category and dangerous flag on a match.
+     * @return bool True when a signature matched.
+     */
+    bool sniff(std::string_view head, Classification &result) const;
+
+private:
+    struct Rule
+    {
+        std::uint16_t offset;
+        std::string_view magic;
+        std::uint16_t offset2;  ///< Second part, checked when `magic2` is not empty.
+        std::string_view magic2;
+        Classification result;
+    };
+
+    static bool matches(const Rule &rule, std::string_view head);
+
+    std::array<std::vector<Rule>, 256> byFirstByte_; ///< Rules at offset 0, keyed by their first byte.
+    std::vector<Rule> atOffset_;                     ///< Rules starting further into the file.
+};
+
+/**
+ * @brief Classify the unrecognized files of a table by content.
+ *
+ * Every record in the "Other" category that is not dangerous (and not
+ * known to be empty) is opened and sniffed; matches update `category` and
+ * the `Dangerous` flag in place. Large batches are spread over a
+ * `ThreadPool` so the reads overlap.
+ *
+ * @param files   Scanned files, classified by `files.classifier()`.
+ * @param threads Worker threads; 0 selects the hardware concurrency.
+ * @return std::size_t Number of records that were recognized.
+ */
+std::size_t sniffTypes(FileTable &files, unsigned threads = 0);
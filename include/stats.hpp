@@ -0,0 +1,177 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <mutex>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @file stats.hpp
+ * @brief Per-phase timing and counters shared by all engines.
+ *
+ * `cleanFilesByType()`, `cleanFilesByName()` and `listFilesInDirectory()`
+ * feed one process-wide `RunStats` instance through the scanner, the
+ * planner and `moveFile()`. For each phase it keeps wall time, items
+ * processed, filesystem calls issued and errors, plus the slowest
+ * individual moves, which is usually enough to tell a slow NFS server
+ * from a slow scan.
+ *
+ * Collection is off until `RunStats::enable()` is called; while disabled
+ * every hook is a single relaxed load. Counters are atomics, so worker
+ * threads report without locking.
+ *
+ * The implementation lives in `src/stats.cpp`.
+ */
+
+/**
+ * @brief The instrumented phases of a run.
+ */
+enum class Phase
+{
+    Scan,     ///< Directory listing (`scanDirectory()`).
+    Classify, ///< Classification, token matching and conflict resolution.
+    Sniff,    ///< Content sniffing of unrecognized files (`sniffTypes()`).
+    Metadata, ///< Capture dates read from photo and video headers (`readCaptureDates()`).
+    Dedupe,   ///< Size bucketing and hashing of possible duplicates (`findDuplicates()`).
+    Mkdir,    ///< Creation of destination directories.
+    Move,     ///< Renames and cross-device copies.
+};
+
+/// Number of values in `Phase`.
+constexpr std::size_t PhaseCount = 7;
+
+/// Lowercase name of a phase, as used in the reports.
+const char *phaseName(Phase phase);
+
+/**
+ * @brief One entry of the slowest-moves list.
+ */
+struct SlowMove
+{
+    fs::path source;
+    fs::path destination;
+    std::uint64_t nanos = 0;
+};
+
+/**
+ * @brief Snapshot of one phase's counters.
+ */
+struct PhaseTotals
+{
+    std::uint64_t nanos = 0;  ///< Wall time spent in the phase.
+    std::uint64_t items = 0;  ///< Files (or directories, for mkdir) processed.
+    std::uint64_t calls = 0;  ///< Filesystem calls issued (listings, stats, mkdir, rename, copy steps).
+    std::uint64_t errors = 0; ///< Failed operations.
+};
+
+/**
+ * @brief Process-wide run statistics.
+ */
+class RunStats
+{
+public:
+    /// Length of the slowest-moves list.
+    static constexpr std::size_t SlowestKept = 10;
+
+    void enable(bool on = true) { enabled_.store(on, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    void addTime(Phase phase, std::uint64_t nanos) { add(phase, &Counters::nanos, nanos); }
+    void addItems(Phase phase, std::uint64_t n = 1) { add(phase, &Counters::items, n); }
+    void addCalls(Phase phase, std::uint64_t n = 1) { add(phase, &Counters::calls, n); }
+    void addErrors(Phase phase, std::uint64_t n = 1) { add(phase, &Counters::errors, n); }
+
+    /**
+     * @brief Offer one move to the slowest-moves list.
+     *
+     * Only takes a lock when the move is slower than the current cut-off.
+     */
+    void recordMove(const fs::path &source, const fs::path &destination, std::uint64_t nanos);
+
+    PhaseTotals totals(Phase phase) const;
+
+    /// Slowest moves, slowest first.
+    std::vector<SlowMove> slowest() const;
+
+    /**
+     * @brief Print a per-phase table followed by the slowest moves.
+     */
+    void print(std::ostream &out) const;
+
+    /**
+     * @brief Save the report as JSON.
+     *
+     * The object has a `phases` map (name → seconds, items, itemsPerSecond,
+     * calls, errors) and a `slowestMoves` array.
+     *
+     * @return bool False when the file could not be written.
+     */
+    bool saveJson(const fs::path &file) const;
+
+private:
+    struct Counters
+    {
+        std::atomic<std::uint64_t> nanos{0};
+        std::atomic<std::uint64_t> items{0};
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> errors{0};
+    };
+
+    void add(Phase phase, std::atomic<std::uint64_t> Counters::*field, std::uint64_t n)
+    {
+        if (enabled())
+            (phases_[static_cast<std::size_t>(phase)].*field).fetch_add(n, std::memory_order_relaxed);
+    }
+
+    std::atomic<bool> enabled_{false};
+    std::array<Counters, PhaseCount> phases_;
+
+    mutable std::mutex slowMutex_;
+    std::vector<SlowMove> slowest_;
+    std::atomic<std::uint64_t> slowCutoff_{0}; ///< Fastest kept time once the list is full.
+};
+
+/// The process-wide statistics instance.
+RunStats &runStats();
+
+/// Nanoseconds elapsed since `start`.
+inline std::uint64_t nanosSince(std::chrono::steady_clock::time_point start)
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+/**
+ * @brief Adds the lifetime of a scope to a phase's wall time.
+ *
+ * Does not read the clock while statistics are disabled.
+ */
+class PhaseTimer
+{
+public:
+    explicit PhaseTimer(Phase phase) : phase_(phase), active_(runStats().enabled())
+    {
+        if (active_)
+            start_ = std::chrono::steady_clock::now();
+    }
+
+    ~PhaseTimer()
+    {
+        if (active_)
+            runStats().addTime(phase_, nanosSince(start_));
+    }
+
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+private:
+    Phase phase_;
+    bool active_;
+    std::chrono::steady_clock::time_point start_;
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file threadPool.hpp
+ * @brief Bounded, work-stealing thread pool shared by the scanning engines.
+ *
+ * Each worker owns a double-ended task queue. Tasks submitted from inside a
+ * worker (for example a subdirectory discovered while scanning) are pushed
+ * onto that worker's own queue and popped LIFO, which keeps a worker busy on
+ * the part of the tree it is already walking. Idle workers steal the oldest
+ * task from another worker's queue, spreading large subtrees across cores.
+ *
+ * The implementation lives in `src/threadPool.cpp`.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Start a pool with the given number of workers.
+     *
+     * @param threads Number of worker threads; 0 selects `defaultThreads()`.
+     */
+    explicit ThreadPool(unsigned threads = 0);
+
+    /**
+     * @brief Wait for outstanding work and join all workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Queue a task for execution.
+     *
+     * May be called from any thread, including from inside a running task.
+     *
+     * @param task Callable to run on one of the workers.
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Block until every submitted task, including tasks submitted by
+     *        other tasks, has finished.
+     *
+     * If a task threw, the first captured exception is rethrown here.
+     *
+     * @warning Must not be called from inside a task of the same pool.
+     */
+    void wait();
+
+    /**
+     * @brief Number of worker threads in the pool.
+     */
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    /**
+     * @brief Index of the calling worker in its pool, or -1 when called from
+     *        a thread that is not a pool worker.
+     */
+    static int currentWorker();
+
+    /**
+     * @brief Default worker count: the hardware concurrency, at least 1.
+     */
+    static unsigned defaultThreads();
+
+private:
+    /// A worker's task queue; the owner pops from the back, thieves from the front.
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void workerLoop(unsigned index);
+    bool popTask(unsigned index, std::function<void()> &task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::atomic<size_t> pending_{0}; ///< Submitted but not yet finished.
+    std::atomic<size_t> queued_{0};  ///< Sitting in a queue, not yet started.
+    std::atomic<unsigned> nextQueue_{0};
+    bool stopping_ = false;
+
+    std::mutex sleepMutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable allDone_;
+
+    std::mutex errorMutex_;
+    std::exception_ptr firstError_;
+};
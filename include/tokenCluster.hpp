@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "tokenIndex.hpp"
+
+/**
+ * @file tokenCluster.hpp
+ * @brief Fuzzy grouping of similar name tokens for `cleanFilesByName()`.
+ *
+ * `clusterTokens()` merges tokens that are spelled almost the same, such as
+ * "beyonce" and "beyonc" or "holiday" and "holidays", into one group. Each
+ * token is described by the set of its letter trigrams (with the word
+ * boundaries as padding); two tokens are similar when the Jaccard
+ * similarity of their trigram sets reaches a threshold and their digits
+ * agree, so "report2019" never joins "report2020".
+ *
+ * Candidates come from a trigram → tokens inverted index rather than from
+ * comparing every pair. Only the rarest trigrams of each token (its
+ * prefix, `|A| - ceil(t·|A|) + 1` of them for threshold `t`) are indexed:
+ * two tokens can only reach the threshold if their prefixes share a
+ * trigram, so no similar pair is missed while common trigrams such as
+ * "ing" rarely take part. Candidates are verified with the exact overlap
+ * and similar pairs are joined with union-find (single linkage). Prefix
+ * trigrams shared by more than `MaxTrigramTokens` tokens are skipped, which
+ * bounds the work per token on pathological inputs.
+ *
+ * Build the index with folding (`buildTokenIndex(..., true)`) so that
+ * accents and letter case are already gone; the ignore list is applied
+ * there, before clustering.
+ *
+ * The implementation lives in `src/tokenCluster.cpp`.
+ */
+
+/// Token prefixes a trigram may occur in and still be used to find similar tokens.
+constexpr std::size_t MaxTrigramTokens = 1000;
+
+/**
+ * @brief A group of similar tokens and the files containing any of them.
+ */
+struct TokenGroup
+{
+    std::string_view name;            ///< Most frequent member; names the folder. Points into the index.
+    std::vector<std::size_t> members; ///< Token ids in the index.
+    std::vector<std::uint32_t> files; ///< Indices into the scanned files, ascending, each listed once.
+};
+
+/**
+ * @brief Group similar tokens and return the largest groups.
+ *
+ * Groups are ordered by file count, most first, ties by name; a group of
+ * one token is returned like any other.
+ *
+ * @param index         Index built by `buildTokenIndex()`.
+ * @param minFiles      Minimum number of files a group must cover.
+ * @param limit         Maximum number of groups returned.
+ * @param minSimilarity Jaccard similarity of the trigram sets at which two
+ *                      tokens are joined, in (0, 1].
+ * @return std::vector<TokenGroup> Groups with their members and files.
+ */
+std::vector<TokenGroup> clusterTokens(const TokenIndex &index, std::size_t minFiles = 2,
+                                      std::size_t limit = static_cast<std::size_t>(-1),
+                                      double minSimilarity = 0.6);
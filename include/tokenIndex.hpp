@@ -0,0 +1,142 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "fileTable.hpp"
+
+/**
+ * @file tokenIndex.hpp
+ * @brief Name-token counting used by the auto-detect mode of `cleanFilesByName()`.
+ *
+ * File stems are lowercased and split on non-alphanumeric characters in
+ * batches by the vectorized `foldStems()` (see `nameKernel.hpp`); tokens of at least
+ * four characters that are not in the ignore set are counted, together with
+ * the whole stem. Counting uses a flat open-addressing hash table whose
+ * token text lives in one arena, so a repeated token costs a hash and a
+ * compare, never an allocation. The same pass builds an inverted index
+ * (token → files) so files can be grouped without a second walk.
+ *
+ * With folding (`foldName()`), accents and other diacritics are removed
+ * and non-Latin letters stay part of tokens, so "Beyoncé" and "beyonce"
+ * count as one token.
+ *
+ * Indices are mergeable: large tables are split into contiguous shards that
+ * are counted on worker threads and merged in order, which gives the same
+ * result as a sequential pass.
+ *
+ * The implementation lives in `src/tokenIndex.cpp`.
+ */
+
+/**
+ * @brief Token frequencies and the files each token occurs in.
+ */
+class TokenIndex
+{
+public:
+    /// Returned by `find()` for unknown tokens.
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    /**
+     * @brief Count one occurrence of `token` in file `file`.
+     *
+     * Files must be added in non-decreasing order; each file is listed once
+     * per token however often the token occurs in it.
+     */
+    void add(std::string_view token, std::uint32_t file);
+
+    /**
+     * @brief Add the counts and file lists of `other`.
+     *
+     * `other` must cover files after the ones in this index (as produced by
+     * splitting a table into consecutive shards).
+     */
+    void merge(TokenIndex &&other);
+
+    /// Number of distinct tokens.
+    std::size_t size() const { return entries_.size(); }
+
+    /// Id of `token`, or `npos`.
+    std::size_t find(std::string_view token) const;
+
+    std::string_view token(std::size_t id) const
+    {
+        return std::string_view(arena_).substr(entries_[id].offset, entries_[id].length);
+    }
+    int count(std::size_t id) const { return entries_[id].count; }
+
+    /// Indices into the scanned files, ascending, each listed once.
+    const std::vector<std::uint32_t> &files(std::size_t id) const { return files_[id]; }
+
+private:
+    struct Entry
+    {
+        std::uint64_t hash;
+        std::uint32_t offset;
+        std::uint32_t length;
+        int count;
+    };
+
+    std::size_t insert(std::string_view token, std::uint64_t hash);
+    void grow();
+
+    std::string arena_;                          ///< Text of every distinct token.
+    std::vector<Entry> entries_;                 ///< By token id.
+    std::vector<std::vector<std::uint32_t>> files_; ///< By token id.
+    std::vector<std::uint32_t> slots_;           ///< Open addressing: token id + 1, 0 = empty.
+};
+
+/**
+ * @brief A frequent token, as returned by `commonTokens()`.
+ */
+struct TokenCount
+{
+    std::string_view token; ///< Points into the index.
+    int count;
+    std::size_t id;         ///< Id in the index (see `TokenIndex::files()`).
+};
+
+/**
+ * @brief Lowercase a UTF-8 name and fold it towards ASCII.
+ *
+ * Latin letters with diacritics lose them ("é" → "e", "ß" → "ss", "Ø" →
+ * "o"), combining marks are dropped, fullwidth forms become ASCII and
+ * Unicode spaces and punctuation (dashes, quotes, ...) become spaces.
+ * Other non-ASCII characters are copied unchanged.
+ *
+ * @param name UTF-8 text, e.g. a file stem.
+ * @param out  Receives the folded text (replaced, not appended).
+ */
+void foldName(std::string_view name, std::string &out);
+
+/**
+ * @brief Count the name tokens of a list of files.
+ *
+ * @param files   Scanned files; the stems are read straight from the table.
+ * @param ignore  Lowercase tokens that are never counted.
+ * @param threads Worker threads for large tables; 0 selects the hardware
+ *                concurrency and 1 counts on the calling thread.
+ * @param fold    Fold stems with `foldName()` before splitting; bytes of
+ *                non-ASCII characters then count as token characters.
+ * @return TokenIndex Counts and inverted index.
+ */
+TokenIndex buildTokenIndex(const FileTable &files,
+                           const std::unordered_set<std::string> &ignore,
+                           unsigned threads = 1, bool fold = false);
+
+/**
+ * @brief The `limit` most frequent tokens seen at least `minCount` times.
+ *
+ * Only the top `limit` entries are ordered (partial selection), most
+ * frequent first; ties are broken alphabetically so the result is stable.
+ *
+ * @param index    Index built by `buildTokenIndex()`.
+ * @param minCount Minimum number of occurrences.
+ * @param limit    Maximum number of tokens returned.
+ * @return std::vector<TokenCount> Tokens, counts and ids.
+ */
+std::vector<TokenCount> commonTokens(const TokenIndex &index, int minCount = 2,
+                                     std::size_t limit = static_cast<std::size_t>(-1));
@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @file tokenMatcher.hpp
+ * @brief Case-insensitive multi-token matcher (Aho–Corasick automaton).
+ *
+ * `TokenMatcher` compiles any number of tokens into one deterministic
+ * automaton over ASCII-case-folded bytes. A file name is matched in a
+ * single left-to-right pass with one table lookup per byte, whatever the
+ * number of tokens: 500 artist names cost the same per byte as one.
+ *
+ * The alphabet is reduced to the bytes that occur in the tokens (plus one
+ * class for every other byte), which keeps the transition table small.
+ * While the automaton sits in its start state, bytes that cannot begin any
+ * token are skipped with a 256-bit lookup instead of a transition; in
+ * typical names most bytes are skipped this way.
+ *
+ * The implementation lives in `src/tokenMatcher.cpp`.
+ */
+
+/**
+ * @brief Which token a name is routed to when several occur in it.
+ */
+enum class MatchPolicy
+{
+    Longest, ///< The longest matching token; ties go to the one listed first.
+    First    ///< The matching token listed first (highest priority).
+};
+
+/**
+ * @brief Compiled set of tokens.
+ */
+class TokenMatcher
+{
+public:
+    /// Returned by `match()` when no token occurs.
+    static constexpr std::uint32_t NoMatch = UINT32_MAX;
+
+    /**
+     * @brief Compile the automaton.
+     *
+     * @param tokens Tokens in priority order; empty tokens are ignored and
+     *               matching ignores ASCII letter case.
+     * @param policy How to choose between several matching tokens.
+     */
+    explicit TokenMatcher(const std::vector<std::string> &tokens, MatchPolicy policy = MatchPolicy::Longest);
+
+    /**
+     * @brief Find the token a name is routed to.
+     *
+     * @param text File name (any case).
+     * @return std::uint32_t Index into the token list, or `NoMatch`.
+     */
+    std::uint32_t match(std::string_view text) const;
+
+    /// Number of automaton states (for statistics).
+    std::size_t stateCount() const { return best_.size(); }
+
+private:
+    bool better(std::uint32_t candidate, std::uint32_t current) const;
+
+    MatchPolicy policy_;
+    std::vector<std::uint32_t> lengths_;  ///< Token lengths, by token index.
+    std::array<std::uint8_t, 256> class_{}; ///< Folded byte → alphabet class (0 = not in any token).
+    std::array<bool, 256> starts_{};      ///< Bytes that can begin a token.
+    std::size_t classes_ = 1;
+    std::vector<std::uint32_t> next_;     ///< Dense DFA: state * classes_ + class → state.
+    std::vector<std::uint32_t> best_;     ///< Best token ending in each state (via suffix links), or NoMatch.
+};
+
+/**
+ * @brief Read a token list from a JSON file.
+ *
+ * Accepts either a plain array of strings or an object with a `tokens`
+ * array, e.g. `{"tokens": ["Daft Punk", "Justice"]}`.
+ *
+ * @param file   JSON file.
+ * @param tokens Receives the tokens, appended in file order.
+ * @return bool False when the file cannot be read or has another shape.
+ */
+bool loadTokenFile(const fs::path &file, std::vector<std::string> &tokens);
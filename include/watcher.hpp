@@ -0,0 +1,85 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @file watcher.hpp
+ * @brief Change notifications for one directory.
+ *
+ * `DirectoryWatcher` subscribes to the operating system's change
+ * notifications for a directory and reports the names of files that were
+ * completely written or renamed into it:
+ *
+ * - Linux: inotify (`IN_CLOSE_WRITE`, `IN_MOVED_TO`).
+ * - Windows: `ReadDirectoryChangesW` (added, renamed and modified files).
+ * - Elsewhere: the directory's modification time is polled and every
+ *   change is reported as an overflow, i.e. "rescan the directory".
+ *
+ * While nothing happens the watcher sleeps in the kernel, so an idle
+ * watch costs no CPU.
+ *
+ * The implementation lives in `src/watcher.cpp`.
+ */
+
+/**
+ * @brief Non-recursive watch of a single directory.
+ */
+class DirectoryWatcher
+{
+public:
+    /**
+     * @brief Start watching `directory`.
+     *
+     * Check `ok()` afterwards; a watcher that could not subscribe reports
+     * nothing.
+     */
+    explicit DirectoryWatcher(const fs::path &directory);
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher &) = delete;
+    DirectoryWatcher &operator=(const DirectoryWatcher &) = delete;
+
+    /// True when the subscription is active.
+    bool ok() const { return ok_; }
+
+    /**
+     * @brief Wait for changes and collect the affected file names.
+     *
+     * Returns as soon as at least one event is available, when
+     * `timeoutMs` elapses, or when a signal interrupts the wait.
+     *
+     * @param names     Receives the names (no directory part) of new or
+     *                  renamed files, in event order; may contain duplicates.
+     * @param timeoutMs Longest time to block, in milliseconds.
+     * @return bool False when the watch failed and must be abandoned.
+     */
+    bool wait(std::vector<std::string> &names, int timeoutMs);
+
+    /**
+     * @brief Whether events were lost since the last call.
+     *
+     * Set when the kernel queue overflowed (or on platforms without
+     * per-file events); the caller must then rescan the whole directory.
+     * Reading the flag clears it.
+     */
+    bool takeOverflow();
+
+private:
+    fs::path directory_;
+    bool ok_ = false;
+    bool overflow_ = false;
+#ifdef _WIN32
+    void *handle_ = nullptr;
+    void *event_ = nullptr;
+    alignas(8) char overlapped_[64] = {};
+    std::vector<char> buffer_;
+    bool arm();
+#elif defined(__linux__)
+    int fd_ = -1;
+#else
+    fs::file_time_type lastWrite_{};
+#endif
+};
@@ -0,0 +1,165 @@
+/**
+ * @file classifier.cpp
+ * @brief Implementation of the flat, hash-based `ExtClassifier`.
+ *
+ * @see classifier.hpp
+ */
+
+#include "classifier.hpp"
+#include "colors.hpp"
+#include "nameKernel.hpp"
+#include "ruleSet.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @brief Pack an extension into two words, folding ASCII upper case.
+ *
+ * @param ext Extension to pack.
+ * @param lo  Receives bytes 0-7 (zero padded).
+ * @param hi  Receives bytes 8-15 (zero padded).
+ * @return bool False when `ext` is empty or longer than `MaxExtLength`.
+ */
+static bool packKey(std::string_view ext, std::uint64_t &lo, std::uint64_t &hi)
+{
+    if (ext.empty() || ext.size() > ExtClassifier::MaxExtLength)
+        return false;
+
+    // Copy into a zero-padded block first, so the fold reads exactly MaxExtLength bytes
+    char buf[ExtClassifier::MaxExtLength] = {};
+    std::memcpy(buf, ext.data(), ext.size());
+    foldAscii(buf, sizeof buf, buf);
+    std::memcpy(&lo, buf, 8);
+    std::memcpy(&hi, buf + 8, 8);
+    return true;
+}
+
+/**
+ * @brief Mix the two key words into a table index seed.
+ */
+static std::size_t hashKey(std::uint64_t lo, std::uint64_t hi)
+{
+    std::uint64_t h = lo * 0x9E3779B97F4A7C15ull ^ (hi + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+    h ^= h >> 29;
+    return static_cast<std::size_t>(h);
+}
+
+/**
+ * @brief Terminal color for a category name, as previously chosen by
+ *        the original `getColorForExtension()` lookup.
+ */
+static const std::string *colorForName(const std::string &type)
+{
+    if (type == "Images")
+        return &GREEN;
+    if (type == "Videos")
+        return &MAGENTA;
+    if (type == "Audio")
+        return &CYAN;
+    if (type == "Documents")
+        return &YELLOW;
+    if (type == "Archives")
+        return &RED;
+    if (type == "Code")
+        return &BLUE;
+    return &WHITE;
+}
+
+ExtClassifier::ExtClassifier(const std::map<std::string, std::vector<std::string>> &fileTypes,
+                             const std::vector<std::string> &dangerousExts,
+                             const std::vector<RouteRule> &routes)
+{
+    std::size_t entries = dangerousExts.size();
+    for (const auto &[type, exts] : fileTypes)
+    {
+        names_.push_back(type);
+        entries += exts.size();
+    }
+
+    auto otherIt = std::find(names_.begin(), names_.end(), "Other");
+    if (otherIt == names_.end())
+    {
+        names_.push_back("Other");
+        otherIt = names_.end() - 1;
+    }
+    other_ = static_cast<CategoryId>(otherIt - names_.begin());
+
+    for (const auto &name : names_)
+        colors_.push_back(colorForName(name));
+
+    // Keep the load factor at or below one half so probe chains stay short
+    std::size_t capacity = 16;
+    while (capacity < entries * 2)
+        capacity <<= 1;
+    slots_.assign(capacity, Slot{});
+    mask_ = capacity - 1;
+
+    CategoryId id = 0;
+    for (const auto &[type, exts] : fileTypes)
+    {
+        for (const auto &e : exts)
+            insert(e, id, true, false);
+        ++id;
+    }
+    for (const auto &e : dangerousExts)
+        insert(e, other_, false, true);
+
+    routes_ = RouteTable(routes, names_);
+}
+
+void ExtClassifier::insert(std::string_view ext, CategoryId category, bool setCategory, bool dangerous)
+{
+    std::uint64_t lo, hi;
+    if (!packKey(ext, lo, hi))
+        return; // empty or longer than MaxExtLength: can never match a lookup
+
+    for (std::size_t i = hashKey(lo, hi) & mask_;; i = (i + 1) & mask_)
+    {
+        Slot &slot = slots_[i];
+        if (slot.lo == 0 && slot.hi == 0)
+        {
+            slot.lo = lo;
+            slot.hi = hi;
+            slot.category = category;
+            slot.dangerous = dangerous;
+            return;
+        }
+        if (slot.lo == lo && slot.hi == hi)
+        {
+            if (setCategory)
+                slot.category = category; // later categories override earlier ones
+            slot.dangerous = slot.dangerous || dangerous;
+            return;
+        }
+    }
+}
+
+Classification ExtClassifier::classify(std::string_view ext) const
+{
+    std::uint64_t lo, hi;
+    if (!packKey(ext, lo, hi))
+        return {other_, false};
+
+    for (std::size_t i = hashKey(lo, hi) & mask_;; i = (i + 1) & mask_)
+    {
+        const Slot &slot = slots_[i];
+        if (slot.lo == lo && slot.hi == hi)
+            return {slot.category, slot.dangerous};
+        if (slot.lo == 0 && slot.hi == 0)
+            return {other_, false};
+    }
+}
+
+CategoryId ExtClassifier::findCategory(std::string_view name) const
+{
+    for (std::size_t i = 0; i < names_.size(); ++i)
+        if (names_[i] == name)
+            return static_cast<CategoryId>(i);
+    return other_;
+}
+
+const ExtClassifier &getClassifier()
+{
+    return currentRules().classifier;
+}
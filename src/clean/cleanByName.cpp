@@ -12,14 +12,14 @@
 #include <string>
 #include <filesystem>
 #include <vector>
-#include <unordered_set>
-#include <map>
-#include <algorithm>
 #include <limits>
-#include <cctype>
 
 #include "../include/colors.hpp"
-#include "../include/ignoreTokens.hpp"
+#include "../include/clean/cleanByName.hpp"
+#include "../include/clean/consoleProgress.hpp"
+#include "../include/libclean.hpp"
+#include "../include/planner.hpp"
+#include "../include/resultLog.hpp"
 
 namespace fs = std::filesystem;
 using namespace std;
@@ -28,257 +28,178 @@ using namespace std;
 // Forward declarations
 void byName(const fs::path &directoryPath);
 
-/**
- * @brief Convert a string to lowercase.
- *
- * Helper lambda used throughout the module to perform case-insensitive
- * comparisons and token extraction. Accepts ASCII/UTF-8 bytes and uses
- * `std::tolower` safely via `unsigned char` conversion.
- *
- * @param s Input string
- * @return std::string Lowercased copy of `s`
- */
-auto toLower = [](const string &s) {
-    string out = s;
-    transform(out.begin(), out.end(), out.begin(), [](unsigned char c) {
-        return tolower(c);
-    });
-    return out;
-};
-
-
 /**
  * @brief Organize files by name.
  *
- * If the user provides a non-empty name, the function finds files whose
- * filenames contain that substring (case-insensitive) and moves them into a
- * directory named after the provided string (slashes are sanitized to
- * underscores).
+ * If the user provides a non-empty name (or `options.tokens` is set), the
+ * function finds files whose filenames contain one of the names
+ * (case-insensitive) and moves them into a directory named after that name
+ * (slashes are sanitized to underscores). All names are compiled into one
+ * `TokenMatcher`, so each filename is scanned once however many names are
+ * given; a name containing several goes to the one chosen by
+ * `options.matchPolicy`.
  *
  * If the user just presses Enter, the function attempts to auto-detect
  * common tokens within file stems (tokens >= 4 characters, excluding
  * tokens from `getIgnoreTokens()`). Tokens that appear at least twice are
  * considered and the top tokens (up to 10) are used to group files into
- * token-named directories.
+ * token-named directories. Token detection is a single pass over the
+ * scanned files that also builds an inverted index (token → files), so the
+ * move phase never walks the directory again. With `options.fuzzy` the
+ * stems are folded first ("Beyoncé" → "beyonce") and similarly spelled
+ * tokens are merged into one group (`clusterTokens()`); the ignore list is
+ * still applied before clustering.
  *
- * The function prints a summary of moved/skipped files and pauses for
- * user acknowledgment before returning (interactive TUI behavior).
+ * The function prints a summary of moved/skipped files (with
+ * `OutputFormat::Jsonl`, one record per file and a summary record) and
+ * pauses for user acknowledgment before returning (interactive TUI behavior). When
+ * `options.interactive` is false the name is taken from `options.token`
+ * and no prompt or pause is shown.
  *
  * @param directoryPath Directory to scan and organize.
+ * @param options       Run-time options (see `CleanOptions`).
+ * @return bool False when the directory is invalid, the journal could not
+ *              be written or a move failed; true otherwise (also for a dry
+ *              run, a cancelled run or nothing to move).
+ *
+ * Both branches only build a move plan (`CleanSession::planName()` on
+ * `sharedSession()`); the plan is then executed by `CleanSession::execute()`,
+ * or just printed when `options.dryRun` is set. In interactive mode each
+ * phase shows a progress line and Ctrl+C cancels the run.
  *
  * @note Files that would overwrite existing files in the destination are
  *       skipped. Any filesystem errors are reported and the offending file
  *       is skipped.
  */
-void cleanFilesByName(const fs::path &directoryPath)
+bool cleanFilesByName(const fs::path &directoryPath, const CleanOptions &options)
 {
-    // Clear any leftover newline from prior input and prompt the user
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-    cout << BOLD << WHITE << "Enter a name to search for in filenames (press Enter to auto-detect common names):\n>>: " << RESET;
-    string name;
-    getline(cin, name);
-
-    vector<fs::path> matches;      // Files matching the name
-    size_t moved = 0;              // Count of moved files
-    size_t skipped = 0;            // Count of skipped files
-    vector<fs::path> skippedFiles; // List of skipped files
+    string name = options.token;
+    if (options.interactive)
+    {
+        // Clear any leftover newline from prior input and prompt the user
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cout << BOLD << WHITE << "Enter a name to search for in filenames (press Enter to auto-detect common names):\n>>: " << RESET;
+        getline(cin, name);
+    }
 
-    // Branch 1: explicit user-supplied name search
-    if (!name.empty())
+    // Scan and plan on the shared session; the prompted name replaces options.token
+    CleanOptions run = options;
+    run.token = name;
+    CleanSession &session = sharedSession();
+    ConsoleProgress progress(options.interactive);
+    PlanResult planned = session.planName(directoryPath, run, progress.control());
+    MovePlan &plan = planned.plan;
+    if (!planned.error.empty())
     {
-        string needle = toLower(name);
-        for (const auto &entry : fs::directory_iterator(directoryPath))
-        {
-            if (!entry.is_regular_file())
-                continue;
-            string fname = entry.path().filename().string();
-            if (toLower(fname).find(needle) != string::npos)
-            {
-                matches.push_back(entry.path());
-            }
-        }
+        cerr << RED << "Invalid directory provided.\n" << RESET;
+        return false;
+    }
+    if (planned.cancelled)
+    {
+        cout << YELLOW << "Cancelled. Nothing was moved.\n" << RESET;
+        return true;
+    }
 
-        if (matches.empty())
+    if (plan.moves.empty())
+    {
+        size_t names = (name.empty() ? 0 : 1) + options.tokens.size();
+        if (names == 0)
+            cout << YELLOW << "No common name tokens detected. Nothing to move.\n" << RESET;
+        else if (names == 1)
+            cout << YELLOW << "No files found containing '" << (name.empty() ? options.tokens[0] : name) << "'.\n" << RESET;
+        else
+            cout << YELLOW << "No files found containing any of the " << names << " names.\n" << RESET;
+        if (options.interactive)
         {
-            cout << YELLOW << "No files found containing '" << name << "'.\n" << RESET;
             cout << YELLOW << "Press Enter to return to the menu..." << RESET;
             cin.get();
-            return;
         }
+        return true;
+    }
 
-        // Create destination directory named after provided name (sanitize)
-        string dirName = name;
-        for (auto &c : dirName)
-            if (c == '/' || c == '\\')
-                c = '_'; // replace slashes with underscores
-        
-        fs::path destDir = directoryPath / dirName;
-        error_code ec;
-        if (!fs::exists(destDir))
-            fs::create_directory(destDir, ec);
-        if (ec)
-        {
-            cerr << RED << "Failed to create directory '" << destDir << "': " << ec.message() << RESET << "\n";
-            return;
-        }
+    if (planned.dedupe.files)
+        cout << DIM << "[INFO] " << planned.dedupe.files << " identical file(s), " << planned.dedupe.bytes / 1024
+             << " KiB (" << planned.dedupe.fullyHashed << " read in full).\n" << RESET;
+
+    if (!options.planFile.empty() && !savePlanJson(plan, options.planFile))
+        cerr << RED << "Warning: Could not write plan to " << options.planFile << RESET << "\n";
 
-        // Move matched files
-        for (const auto &src : matches)
+    bool jsonl = options.output == OutputFormat::Jsonl;
+    if (options.dryRun)
+    {
+        if (jsonl)
         {
-            fs::path dest = destDir / src.filename();
-            if (fs::exists(dest))
-            {
-                ++skipped;
-                skippedFiles.push_back(src.filename());
-                continue;
-            }
-            error_code moveEc;
-            fs::rename(src, dest, moveEc);
-            if (moveEc)
-            {
-                ++skipped;
-                skippedFiles.push_back(src.filename());
-            }
-            else
-            {
-                ++moved;
-            }
+            logMoves(plan, nullptr);
+            logSummary(plan, nullptr);
         }
-    }
-    else
-    {
-        // Auto-detect common name tokens
-        map<string, int> tokenCount;// Token frequency map
-        
-        // Build ignore set from dynamic tokens
-        const auto& ignoreTokensVec = getIgnoreTokens(); // from include/ignoreTokens.hpp
-        unordered_set<string> ignoreSet(ignoreTokensVec.begin(), ignoreTokensVec.end()); 
-
-        // Tokenize stems and count tokens of length >= 4
-        for (const auto &entry : fs::directory_iterator(directoryPath))
-        { //loop through files
-            if (!entry.is_regular_file()){// Check for regular file
-                cout<< DIM << "Skipping non-regular file: " << entry.path().filename().string() << RESET << "\n";
-                continue;
-            }
-            string stem = entry.path().stem().string();
-            string lower = toLower(stem);// Lowercase stem
-            
-            // Split on non-alphanumeric
-            string token;
-            for (char ch : lower)
-            {
-                if (isalnum(static_cast<unsigned char>(ch)))// Alphanumeric check
-                {
-                    token.push_back(ch);
-                }
-                else
-                { 
-                    if (token.size() >= 4 && ignoreSet.find(token) == ignoreSet.end()){
-                        tokenCount[token]++;
-                        token.clear();
-                    }
-                }
-            }
-            
-            // Handle final token
-            if (token.size() >= 4 && ignoreSet.find(token) == ignoreSet.end()){
-                tokenCount[token]++;
-            }
-            // Also count whole stem if long enough
-            if (lower.size() >= 4 && ignoreSet.find(lower) == ignoreSet.end()){
-                tokenCount[lower]++;
-            }
+        else
+        {
+            printPlan(plan, cout);
         }
-
-        // Collect tokens that appear multiple times
-        vector<pair<string, int>> common;
-        for (auto &kv : tokenCount)
-            if (kv.second >= 2)
-                common.emplace_back(kv.first, kv.second);
-        
-        // Sort by frequency descending
-        sort(common.begin(), common.end(), [](auto &a, auto &b) {
-            return a.second > b.second;
-        });
-
-        if (common.empty())
+        if (options.interactive)
         {
-            cout << YELLOW << "No common name tokens detected. Nothing to move.\n" << RESET;
             cout << YELLOW << "Press Enter to return to the menu..." << RESET;
             cin.get();
-            return;
         }
+        return true;
+    }
 
-        // Limit to top 10 tokens to avoid over-creating folders
-        size_t limit = min<size_t>(10, common.size());
-        for (size_t i = 0; i < limit; ++i)
+    // JSON Lines reports every file after the moves instead
+    if (!jsonl)
+    {
+        for (const auto &move : plan.moves)
         {
-            const string token = common[i].first;
-            
-            // Find files that contain this token
-            vector<fs::path> found;
-            for (const auto &entry : fs::directory_iterator(directoryPath))
+            if (move.status == MoveStatus::DestinationExists || move.status == MoveStatus::DuplicateInPlan)
             {
-                if (!entry.is_regular_file())
-                    continue;
-                string fnameLower = toLower(entry.path().filename().string());
-                if (fnameLower.find(token) != string::npos && ignoreSet.find(token) == ignoreSet.end())
-                    found.push_back(entry.path());// Add to found list
+                cout << DIM << "Skipping file due to name conflict: " << move.source.filename().string() << RESET << "\n";
             }
-
-            if (found.size() < 2)
-                continue; // Skip tokens that don't represent groups
-
-            // Make directory named after token
-            fs::path destDir = directoryPath / token;
-            error_code ec;
-            if (!fs::exists(destDir))
-                fs::create_directory(destDir, ec);
-            if (ec)
-            {
-                cerr << RED << "Failed to create directory '" << destDir << "': " << ec.message() << RESET << "\n";
-                continue;
-            }
-
-            // Move files for this token
-            for (const auto &src : found)
+            else if (move.status == MoveStatus::Identical && !plan.linkDuplicates)
             {
-                fs::path dest = destDir / src.filename();
-                if (fs::exists(dest))
-                {
-                    ++skipped;
-                    cout<< DIM << "Skipping file due to name conflict: " << src.filename().string() << RESET << "\n";
-                    skippedFiles.push_back(src.filename());
-                    continue;
-                }
-                error_code moveEc;
-                fs::rename(src, dest, moveEc);
-                if (moveEc)
-                {
-                    ++skipped;
-                    cout<< DIM << "Skipping file due to error: " << src.filename().string() << RESET << "\n";
-                    skippedFiles.push_back(src.filename());
-                }
-                else
-                {
-                    ++moved;
-                }
+                cout << DIM << "Skipping identical file: " << move.source.filename().string() << RESET << "\n";
             }
         }
     }
 
+    // Journal the plan, create destination directories once, then move
+    ExecuteResult done = session.execute(plan, run, progress.control());
+    if (!done.error.empty())
+    {
+        cerr << RED << "Error: " << done.error << ". Nothing was moved.\n" << RESET;
+        return false;
+    }
+    if (done.journalFailed)
+        cerr << RED << "Warning: Could not update journal " << options.journalFile << RESET << "\n";
+    bool ok = done.moves.failures.empty() && !done.journalFailed;
+    const MoveResult &result = done.moves;
+    size_t moved = result.moved;
+    size_t skipped = result.skipped;
+    const vector<fs::path> &skippedFiles = result.skippedFiles;
+    if (jsonl)
+    {
+        logMoves(plan, &result);
+        logSummary(plan, &result);
+        return ok;
+    }
+
     // Print results
-    cout << GREEN << "Moved: " << moved << RESET << "  " << YELLOW << "Skipped: " << skipped << RESET << "\n";
+    cout << GREEN << "Moved: " << moved << RESET << "  " << YELLOW << "Skipped: " << skipped << RESET;
+    if (result.linked)
+        cout << "  " << CYAN << "Linked: " << result.linked << RESET;
+    cout << "\n";
     if (!skippedFiles.empty())
     {
         cout << DIM << "Skipped files (name conflicts or errors):\n" << RESET;
         for (const auto &s : skippedFiles)
             cout << " - " << s.string() << "\n";
     }
+    if (done.cancelled)
+        cout << YELLOW << "Cancelled before every file was moved.\n" << RESET;
 
-    cout << YELLOW << "Press Enter to return to the menu..." << RESET;
-    cin.get();
+    if (options.interactive)
+    {
+        cout << YELLOW << "Press Enter to return to the menu..." << RESET;
+        cin.get();
+    }
 
-    return;
+    return ok;
 }
\ No newline at end of file
@@ -3,12 +3,27 @@
 #include "../include/colors.hpp"
 #include "../include/getColor.hpp"
 #include "../include/fileTypes.hpp" 
-#include "../include/dangerousExts.hpp"  
+#include "../include/planner.hpp"
+#include "../include/journal.hpp"
+#include "../include/libclean.hpp"
+#include "../include/clean/consoleProgress.hpp"
+#include "../include/scanner.hpp"
+#include "../include/sniffer.hpp"
+#include "../include/mediaDate.hpp"
+#include "../include/quarantine.hpp"
+#include "../include/resultLog.hpp"
+#include "../include/watcher.hpp"
+#include "../include/ruleSet.hpp"
 #include "../include/json.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <iostream>
+#include <memory>
 #include <set>
+#include <unordered_set>
 
 /**
  * @file cleanByType.cpp
@@ -18,8 +33,53 @@
  * which inspects files in a given directory, classifies them using the
  * category→extensions mapping provided by `getFileTypes()`, and moves files
  * into type-named subdirectories. Files with extensions marked as "dangerous"
- * by `getDangerousExts()` are skipped.
+ * by `getDangerousExts()` are skipped, or moved into a restricted
+ * `Quarantine/` folder with `CleanOptions::quarantine`.
+ *
+ * `watchFilesByType()` applies the same plan to files as they arrive.
+ */
+
+/**
+ * @brief Report the dangerous files a plan leaves alone.
+ */
+static void reportDangerous(const MovePlan &plan)
+{
+    for (const auto &move : plan.moves)
+        if (move.status == MoveStatus::Dangerous)
+            std::cerr << RED << "Skipped dangerous file: "
+                      << move.source.filename().string() << RESET << "\n";
+}
+
+/**
+ * @brief Report what the dedupe stage found.
+ */
+static void reportDedupe(const DedupeSummary &summary)
+{
+    if (summary.files)
+        std::cout << DIM << "[INFO] " << summary.files << " identical file(s), "
+                  << summary.bytes / 1024 << " KiB (" << summary.fullyHashed << " read in full).\n" << RESET;
+}
+
+/**
+ * @brief Print the moved/skipped totals and the skipped file names.
  */
+static void reportResult(const MoveResult &result)
+{
+    std::cout << GREEN << "Moved: " << result.moved << RESET
+              << "  " << YELLOW << "Skipped: " << result.skipped << RESET;
+    if (result.linked)
+        std::cout << "  " << CYAN << "Linked: " << result.linked << RESET;
+    if (result.quarantined)
+        std::cout << "  " << RED << "Quarantined: " << result.quarantined << RESET;
+    std::cout << "\n";
+
+    if (!result.skippedFiles.empty())
+    {
+        std::cout << "Skipped files:\n";
+        for (const auto &s : result.skippedFiles)
+            std::cout << " - " << s.string() << "\n";
+    }
+}
 
 /**
  * @brief Move files from `directoryPath` into type-based subdirectories.
@@ -27,138 +87,336 @@
  * Scans `directoryPath` for regular files, determines each file's extension,
  * and moves the file into a subdirectory named after its type (for example
  * "Images" or "Documents"). Behavior:
- * - Uses `getFileTypes()` to build an extension→type lookup.
- * - Skips files whose lowercase extension appears in `getDangerousExts()`.
- * - Creates the destination directory if it does not exist.
+ * - Runs on `sharedSession()`: scans with `CleanSession::planType()`
+ *   (optionally recursive) and moves with `CleanSession::execute()`. In
+ *   interactive mode each phase shows a progress line and Ctrl+C cancels
+ *   the run (`ConsoleProgress`).
+ * - Classifies extensions with the shared `ExtClassifier` built from
+ *   `getFileTypes()`.
+ * - Skips files whose extension is flagged by `getDangerousExts()`; with
+ *   `options.quarantine` moves them into `Quarantine/` instead, strips
+ *   their permissions and leaves that folder out of recursive scans. With
+ *   `options.quarantineScan` the quarantined files are then handed to an
+ *   external scanner (`QuarantineScanner`).
+ * - Routing rules (`"$routes"` in `data/fileTypes.json`) send files to
+ *   other folders by category, size and age; the scan then collects sizes
+ *   and times so the rules cost no extra system call.
+ * - With `options.sniff`, files with unknown extensions are classified by
+ *   their leading bytes (`sniffTypes()`).
+ * - With `options.byDate`, photos and videos go to `<Category>/YYYY/MM` by
+ *   the capture date in their headers (`readCaptureDates()`).
+ * - Builds a move plan first (`planByType()`), then executes it; each
+ *   destination directory is created once up front.
  * - Skips files that would collide with an existing filename in the
  *   destination directory.
- * - Reports counts of moved and skipped files and prints a list of skipped filenames.
+ * - With `options.dedupe`, files whose content is already present are
+ *   skipped or replaced with hard links (`findDuplicates()`).
+ * - With `options.dryRun` only prints the plan; `options.planFile` saves
+ *   it as JSON.
+ * - Reports counts of moved and skipped files and prints a list of skipped
+ *   filenames, or with `OutputFormat::Jsonl` one record per file and a
+ *   summary (`logMoves()`, `logSummary()`).
  *
  * @param directoryPath Filesystem path to the target directory to organize.
+ * @param options       Run-time options (see `CleanOptions`).
+ * @return bool False when the directory is invalid, the journal could not
+ *              be written or a move failed; true otherwise (also for a dry
+ *              run, a cancelled run or nothing to move).
  *
- * @note The function prints prompts and waits for the user to press Enter
- *       before returning so it is suitable for interactive use in a TUI.
+ * @note In interactive mode the function prints prompts and waits for the
+ *       user to press Enter before returning so it is suitable for use in a
+ *       TUI. With `options.interactive == false` it neither clears the
+ *       screen nor reads from `std::cin`.
  *
  * @warning Uses `std::filesystem::rename()` which may throw or set error codes
  *          depending on platform; errors are reported to `std::cerr` and the
  *          offending file is skipped.
  */
-void cleanFilesByType(const fs::path &directoryPath)
+bool cleanFilesByType(const fs::path &directoryPath, const CleanOptions &options)
 {
-    Header::display();
-    // Counters for reporting
-    size_t moved = 0;
-    size_t skipped = 0;
-    std::vector<fs::path> skippedFiles;
+    if (options.interactive)
+        Header::display();
 
     // Validate input directory
     if (!fs::exists(directoryPath) || !fs::is_directory(directoryPath))
     {
         std::cerr << RED << "Invalid directory provided.\n" << RESET;
-        return;
+        return false;
     }
 
-    // Load dangerous extensions dynamically (lowercase, including dot)
-    auto dangerous = getDangerousExts();
+    // Stage 1: plan every move from the scanned files without touching them
+    CleanSession &session = sharedSession();
+    ConsoleProgress progress(options.interactive);
+    PlanResult planned = session.planType(directoryPath, options, progress.control());
+    MovePlan &plan = planned.plan;
+    if (!planned.error.empty())
+    {
+        std::cerr << RED << "Invalid directory provided.\n" << RESET;
+        return false;
+    }
+    reportDedupe(planned.dedupe);
 
-    // Build extension → type lookup using the file types mapping
-    std::map<std::string, std::string> extToType;
-    for (const auto &[type, exts] : getFileTypes())
+    if (!planned.cancelled && !options.planFile.empty() && !savePlanJson(plan, options.planFile))
+        std::cerr << RED << "Warning: Could not write plan to "
+                  << options.planFile << RESET << "\n";
+    bool jsonl = options.output == OutputFormat::Jsonl;
+    bool ok = true;
+    if (planned.cancelled)
     {
-        for (const auto &e : exts)
+        std::cout << YELLOW << "Cancelled. Nothing was moved.\n" << RESET;
+    }
+    else if (options.dryRun)
+    {
+        if (jsonl)
+        {
+            logMoves(plan, nullptr);
+            logSummary(plan, nullptr);
+        }
+        else
+        {
+            printPlan(plan, std::cout);
+        }
+    }
+    else
+    {
+        if (!jsonl)
+            reportDangerous(plan);
+
+        // Stage 2: journal the plan, create destination directories once, then move
+        // (and hand quarantined files to the scanner)
+        ExecuteResult done = session.execute(plan, options, progress.control());
+        if (!done.error.empty())
         {
-            std::string lowerExt = e;
-            std::transform(lowerExt.begin(), lowerExt.end(), lowerExt.begin(),
-                           [](unsigned char c) { return std::tolower(c); });
+            std::cerr << RED << "Error: " << done.error << ". Nothing was moved.\n" << RESET;
+            return false;
+        }
+        if (done.journalFailed)
+            std::cerr << RED << "Warning: Could not update journal " << options.journalFile << RESET << "\n";
+        ok = done.moves.failures.empty() && !done.journalFailed;
 
-            extToType[lowerExt] = type;
+        if (jsonl)
+        {
+            logMoves(plan, &done.moves);
+            logSummary(plan, &done.moves);
+        }
+        else
+        {
+            reportResult(done.moves);
+            if (done.cancelled)
+                std::cout << YELLOW << "Cancelled before every file was moved.\n" << RESET;
         }
     }
 
-    // Iterate over directory entries
-    for (const auto &entry : fs::directory_iterator(directoryPath))
+    // Pause for user acknowledgment before returning to menu
+    if (!options.interactive)
+        return ok;
+    std::cout << YELLOW << "Press Enter to return..." << RESET;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::cin.get();
+    return ok;
+}
+
+/// Set by SIGINT / SIGTERM to end `watchFilesByType()`.
+static volatile std::sig_atomic_t watchStop = 0;
+
+/// Set by SIGHUP to reload the rules before the next batch.
+static volatile std::sig_atomic_t watchReload = 0;
+
+static void onWatchSignal(int signal)
+{
+#ifdef SIGHUP
+    if (signal == SIGHUP)
     {
-        if (!entry.is_regular_file())
-            continue;
+        watchReload = 1;
+        return;
+    }
+#endif
+    watchStop = 1;
+}
+
+/**
+ * @brief Gather one debounced batch of changed file names.
+ *
+ * After the first event, keeps collecting until the directory has been
+ * quiet for `Quiet` or `MaxDelay` has passed since the first event, so a
+ * burst of arrivals becomes one plan while a single file is still moved
+ * well within a second.
+ *
+ * @return bool False when the watch failed.
+ */
+static bool collectBatch(DirectoryWatcher &watcher, std::vector<std::string> &names, bool &rescan)
+{
+    using namespace std::chrono;
+    constexpr milliseconds Idle(1000);    // wake-up interval to notice a stop request
+    constexpr milliseconds Quiet(100);    // silence that ends a batch
+    constexpr milliseconds MaxDelay(500); // latest a batch is processed after its first event
 
-        fs::path src = entry.path();
-        std::string ext = src.extension().string();
+    names.clear();
+    rescan = false;
+    while (names.empty() && !rescan)
+    {
+        if (watchStop || !watcher.wait(names, static_cast<int>(Idle.count())))
+            return false;
+        rescan = watcher.takeOverflow();
+    }
 
-        std::string lowerExt = ext;
-        std::transform(lowerExt.begin(), lowerExt.end(), lowerExt.begin(),
-                       [](unsigned char c) { return std::tolower(c); });
+    auto first = steady_clock::now();
+    while (!watchStop && steady_clock::now() - first < MaxDelay)
+    {
+        std::size_t before = names.size();
+        if (!watcher.wait(names, static_cast<int>(Quiet.count())))
+            return false;
+        bool overflow = watcher.takeOverflow();
+        rescan = rescan || overflow;
+        if (names.size() == before && !overflow)
+            break;
+    }
+    return true;
+}
 
-        // Dangerous files check
-        if (std::find(dangerous.begin(), dangerous.end(), lowerExt) != dangerous.end())
+bool watchFilesByType(const fs::path &directoryPath, const CleanOptions &options)
+{
+    DirectoryWatcher watcher(directoryPath);
+    if (!watcher.ok())
+    {
+        std::cerr << RED << "Error: Could not watch \"" << directoryPath.string() << "\".\n" << RESET;
+        return false;
+    }
+
+    MoveJournal journal;
+    bool journaled = false;
+    if (!options.journalFile.empty() && !options.dryRun)
+    {
+        journaled = journal.open(options.journalFile);
+        if (!journaled)
         {
-            std::cerr << RED << "Skipped dangerous file: "
-                      << src.filename().string() << RESET << "\n";
-            ++skipped;
-            skippedFiles.push_back(src.filename());
-            continue;
+            std::cerr << RED << "Error: Could not write journal "
+                      << options.journalFile << ". Nothing was moved.\n" << RESET;
+            return false;
         }
+    }
+    const std::string journalName = fs::path(options.journalFile).filename().string();
+
+    // One queue for the whole watch, so a burst of quarantined files shares scanner processes
+    std::unique_ptr<QuarantineScanner> scanner;
+    if (!options.quarantineScan.empty() && !options.dryRun)
+        scanner = std::make_unique<QuarantineScanner>(options.quarantineScan, options.output == OutputFormat::Jsonl);
 
-        // Determine file type; default to "Other"
-        std::string type = "Other";
-        if (extToType.count(lowerExt))
-            type = extToType[lowerExt];
+    watchStop = 0;
+    watchReload = 0;
+    std::signal(SIGINT, onWatchSignal);
+    std::signal(SIGTERM, onWatchSignal);
+#ifdef SIGHUP
+    std::signal(SIGHUP, onWatchSignal);
+#endif
+    std::cout << CYAN << "Watching " << directoryPath.string() << " (Ctrl+C to stop)\n" << RESET;
 
-        fs::path destDir = directoryPath / type;
-        fs::path dest = destDir / src.filename();
+    ScanOptions flat = options.scan;
+    flat.recursive = false;
+    bool ok = true;
+
+    std::vector<std::string> names;
+    bool rescan = false;
+    while (collectBatch(watcher, names, rescan))
+    {
+        // Pick up edited rule files before planning the batch. Every published set
+        // lives until exit, so a SIGHUP only reloads when a file actually changed
+        bool hangup = watchReload != 0;
+        watchReload = 0;
+        if (reloadRulesIfChanged())
+            std::cout << CYAN << "Rules reloaded (generation " << currentRules().generation << ")\n" << RESET;
+        else if (hangup)
+            std::cout << DIM << "[INFO] Rules unchanged (generation " << currentRules().generation << ")\n"
+                      << RESET;
+        const ExtClassifier &classifier = getClassifier();
+        flat.withStat = options.scan.withStat || options.byDate || classifier.routes().needsStat();
 
-        // Create target directory if necessary
-        if (!fs::exists(destDir))
+        FileTable files(directoryPath);
+        if (rescan)
         {
-            std::error_code ec;
-            if (!fs::create_directory(destDir, ec))
+            // Events were lost: fall back to a full listing of the directory
+            files = scanDirectory(directoryPath, flat);
+        }
+        else
+        {
+            std::uint32_t dir = files.addDirectory("");
+            std::unordered_set<std::string> seen;
+            for (const auto &name : names)
             {
-                std::cerr << RED << "Warning: Could not create directory "
-                          << destDir << ": " << ec.message() << RESET << "\n";
-                ++skipped;
-                skippedFiles.push_back(src.filename());
-                continue;
+                std::error_code ec;
+                if (!seen.insert(name).second || name == journalName ||
+                    !fs::is_regular_file(directoryPath / name, ec))
+                    continue;
+                FileRecord &record = files.add(dir, name, classifier);
+                if (flat.withStat)
+                    statRecord(directoryPath / name, record);
             }
         }
+        if (!options.journalFile.empty())
+            excludePath(files, options.journalFile);
+        if (files.empty())
+            continue;
+        if (options.sniff)
+            sniffTypes(files, options.scan.threads);
+        if (options.byDate)
+            readCaptureDates(files, options.scan.threads);
 
-        // Skip if destination file already exists to avoid overwriting
-        if (fs::exists(dest))
+        MovePlan plan = planByType(directoryPath, files, options.destination, options.byDate, options.quarantine);
+        reportDedupe(findDuplicates(plan, options.dedupe, options.scan.threads));
+        bool jsonl = options.output == OutputFormat::Jsonl;
+        if (options.dryRun)
         {
-            ++skipped;
-            skippedFiles.push_back(src.filename());
+            if (jsonl)
+            {
+                logMoves(plan, nullptr);
+                logSummary(plan, nullptr);
+                resultLog().flush(); // a batch is reported as soon as it is planned
+            }
+            else
+            {
+                printPlan(plan, std::cout);
+            }
             continue;
         }
-
-        // Move file, capturing error codes to avoid throwing
-        std::error_code ec;
-        fs::rename(src, dest, ec);
-
-        if (ec)
+        if (!jsonl)
+            reportDangerous(plan);
+        if (journaled && !journal.recordPlan(plan))
         {
-            std::cerr << RED << "Failed to move " << src
-                      << " -> " << dest << ": "
-                      << ec.message() << RESET << "\n";
-            ++skipped;
-            skippedFiles.push_back(src.filename());
+            std::cerr << RED << "Error: Could not write journal "
+                      << options.journalFile << ". Batch not moved.\n" << RESET;
+            ok = false;
+            continue;
+        }
+        MoveResult result = executePlan(plan, options.moveJobs, journaled ? &journal : nullptr, options.ioUring);
+        ok = ok && result.failures.empty();
+        if (jsonl)
+        {
+            logMoves(plan, &result);
+            logSummary(plan, &result);
+            resultLog().flush();
         }
         else
         {
-            ++moved;
+            reportResult(result);
         }
+        if (scanner)
+            scanner->submit(plan, result);
     }
 
-    // Report results
-    std::cout << GREEN << "Moved: " << moved << RESET
-              << "  " << YELLOW << "Skipped: " << skipped << RESET << "\n";
-
-    if (!skippedFiles.empty())
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+#ifdef SIGHUP
+    std::signal(SIGHUP, SIG_DFL);
+#endif
+    if (journaled && !journal.sync())
     {
-        std::cout << "Skipped files:\n";
-        for (const auto &s : skippedFiles)
-            std::cout << " - " << s.string() << "\n";
+        std::cerr << RED << "Warning: Could not update journal " << options.journalFile << RESET << "\n";
+        ok = false;
     }
-
-    // Pause for user acknowledgment before returning to menu
-    std::cout << YELLOW << "Press Enter to return..." << RESET;
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    std::cin.get();
-}
\ No newline at end of file
+    if (!watchStop)
+    {
+        std::cerr << RED << "Error: Lost the watch on \"" << directoryPath.string() << "\".\n" << RESET;
+        return false;
+    }
+    return ok;
+}
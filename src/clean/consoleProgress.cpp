@@ -0,0 +1,46 @@
+/**
+ * @file consoleProgress.cpp
+ * @brief Implementation of the interactive progress line.
+ *
+ * @see consoleProgress.hpp
+ */
+
+#include "../include/clean/consoleProgress.hpp"
+#include "../include/colors.hpp"
+
+#include <iostream>
+
+/// Cancelled by SIGINT while an interactive operation runs.
+static CancelToken consoleCancel;
+
+static void onConsoleInterrupt(int)
+{
+    consoleCancel.cancel();
+}
+
+ConsoleProgress::ConsoleProgress(bool active) : active_(active)
+{
+    if (!active_)
+        return;
+    consoleCancel.reset();
+    previous_ = std::signal(SIGINT, onConsoleInterrupt);
+    control_.cancel = &consoleCancel;
+    control_.progress = [](const Progress &p) {
+        const char *label = p.phase == ProgressPhase::Scan   ? "Scanning"
+                            : p.phase == ProgressPhase::Plan ? "Planning"
+                                                             : "Moving";
+        std::cout << "\r" << DIM << label << ": " << p.done;
+        if (p.total)
+            std::cout << "/" << p.total;
+        else
+            std::cout << " files";
+        std::cout << RESET << (p.finished ? "\n" : "") << std::flush;
+    };
+}
+
+ConsoleProgress::~ConsoleProgress()
+{
+    if (!active_)
+        return;
+    std::signal(SIGINT, previous_ == SIG_ERR ? SIG_DFL : previous_);
+}
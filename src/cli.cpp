@@ -0,0 +1,632 @@
+/**
+ * @file cli.cpp
+ * @brief Implementation of the argv-driven command line mode.
+ *
+ * Translates command line arguments into a `CleanOptions` instance with
+ * `interactive` disabled and dispatches to the same engines used by the
+ * TUI. See `cli.hpp` for the supported syntax.
+ */
+
+#include "cli.hpp"
+#include "colors.hpp"
+#include "options.hpp"
+#include "listFiles.hpp"
+#include "journal.hpp"
+#include "jobs.hpp"
+#include "scanIndex.hpp"
+#include "ruleBlob.hpp"
+#include "resultLog.hpp"
+#include "stats.hpp"
+#include "clean/cleanByType.hpp"
+#include "clean/cleanByName.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Print command line usage to the given stream.
+ *
+ * @param out Stream receiving the usage text.
+ */
+static void printUsage(std::ostream &out)
+{
+    out << "Usage:\n"
+        << "  clean                          Start the interactive menu\n"
+        << "  clean type <dir>               Organize files into type folders\n"
+        << "  clean name <dir> [--token X]   Organize files by name (auto-detect without --token)\n"
+        << "                                 Repeat --token or use --tokens FILE (JSON list) for many names\n"
+        << "  clean list <dir> [--stream | --summary]\n"
+        << "                                 List files grouped by type, in scan order, or as totals\n"
+        << "  clean jobs <manifest | ->      Organize many roots by type on one worker pool (see README)\n"
+        << "                                 '-' reads a JSON manifest or one path per line from stdin\n"
+        << "  clean resume <journal>         Finish the moves of an interrupted journaled run\n"
+        << "  clean undo <journal>           Move the files of a journaled run back\n"
+        << "  clean compile-rules [FILE] [--header H]\n"
+        << "                                 Compile data/*.json into data/rules.bin (or FILE) for fast startup\n"
+        << "  clean help                     Show this help\n"
+        << "\n"
+        << "Options:\n"
+        << "  -r, --recursive                Also process files in subdirectories\n"
+        << "  --max-depth N                  Limit recursion to N levels below <dir>\n"
+        << "  -j, --threads N                Worker threads for recursive scans (default: all cores)\n"
+        << "  --move-jobs N                  Keep up to N file moves in flight (default: 1)\n"
+        << "  --io-uring                     Submit the renames in batches through io_uring (Linux)\n"
+        << "  --dest DIR                     Create the sorted folders in DIR (may be another volume)\n"
+        << "  -n, --dry-run                  Print the move plan without moving anything\n"
+        << "  --plan FILE                    Save the move plan as JSON\n"
+        << "  --output text|jsonl            Report results as text or as one JSON object per file (JSON Lines)\n"
+        << "  --match longest|first          With several tokens, prefer the longest or the first listed\n"
+        << "  --fuzzy                        Auto-detect: ignore accents and group similarly spelled names\n"
+        << "  --dedupe skip|link             Detect identical files; leave them or replace them with hard links\n"
+        << "  --sniff                        Recognize files with unknown extensions by content (type only)\n"
+        << "  --by-date                      Sort photos and videos into <Category>/YYYY/MM by capture date (type only)\n"
+        << "  --quarantine                   Move dangerous files into a private Quarantine folder (type only)\n"
+        << "  --quarantine-scan CMD          Also run CMD on the quarantined files, many per call (implies --quarantine)\n"
+        << "  --watch                        Stay running and organize new files as they arrive (type only)\n"
+        << "  --journal FILE                 Record moves in FILE so the run can be resumed or undone\n"
+        << "  --incremental                  Reuse unchanged directories from the last scan of <dir>\n"
+        << "  --index FILE                   Like --incremental, keeping the scan index in FILE\n"
+        << "  --stats                        Print per-phase timings, call counts and the slowest moves\n"
+        << "  --stats-json FILE              Save the same statistics as JSON\n"
+        << "\n"
+        << "Options of 'jobs' (the options above are the defaults of every job):\n"
+        << "  --workers N                    Roots organized at once (default: all cores)\n"
+        << "  --per-device N                 Roots organized at once on one filesystem device (default: 2)\n"
+        << "  --report FILE                  Save per-root results and totals as JSON\n"
+        << "\n"
+        << "<dir> defaults to the current directory when omitted.\n";
+}
+
+/**
+ * @brief Keeps standard output for JSON Lines records while it is alive.
+ *
+ * Every other message written to `std::cout` (notices, progress, stats)
+ * goes to standard error instead; the records are flushed on destruction.
+ */
+class JsonlSession
+{
+public:
+    explicit JsonlSession(bool active) : active_(active)
+    {
+        if (active_)
+            saved_ = std::cout.rdbuf(std::cerr.rdbuf());
+    }
+
+    ~JsonlSession()
+    {
+        if (!active_)
+            return;
+        resultLog().close();
+        std::cout.rdbuf(saved_);
+    }
+
+    JsonlSession(const JsonlSession &) = delete;
+    JsonlSession &operator=(const JsonlSession &) = delete;
+
+private:
+    bool active_;
+    std::streambuf *saved_ = nullptr;
+};
+
+/**
+ * @brief Report a usage error and return the matching exit status.
+ *
+ * @param message Description of the problem.
+ * @return int Always 1.
+ */
+static int usageError(const std::string &message)
+{
+    std::cerr << RED << "Error: " << message << RESET << "\n\n";
+    printUsage(std::cerr);
+    return 1;
+}
+
+/**
+ * @brief Parse a non-negative decimal count.
+ *
+ * @param text  Text to parse.
+ * @param value Receives the parsed value on success.
+ * @return bool True when `text` is entirely a non-negative integer.
+ */
+static bool parseCount(const std::string &text, int &value)
+{
+    try
+    {
+        size_t used = 0;
+        int parsed = std::stoi(text, &used);
+        if (used != text.size() || parsed < 0)
+            return false;
+        value = parsed;
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+/**
+ * @brief Run `resume <journal>` or `undo <journal>`.
+ *
+ * @param command Either "resume" or "undo".
+ * @param args    Command line arguments without the program name.
+ * @return int Exit status: 0 on success, 1 on usage errors, 2 when the
+ *         journal cannot be read.
+ */
+static int runJournalCommand(const std::string &command, const std::vector<std::string> &args)
+{
+    std::string journalFile;
+    unsigned moveJobs = 1;
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const std::string &arg = args[i];
+        if (arg == "--move-jobs" && command == "resume")
+        {
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            int value = 0;
+            if (!parseCount(args[++i], value))
+                return usageError(arg + " expects a non-negative number");
+            moveJobs = value == 0 ? 1 : static_cast<unsigned>(value);
+        }
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            return usageError("unknown option '" + arg + "' for '" + command + "'");
+        }
+        else if (journalFile.empty())
+        {
+            journalFile = arg;
+        }
+        else
+        {
+            return usageError("unexpected argument '" + arg + "'");
+        }
+    }
+    if (journalFile.empty())
+        return usageError("'" + command + "' requires a journal file");
+
+    bool ok = true;
+    MoveResult result = command == "resume" ? resumeJournal(journalFile, moveJobs, ok)
+                                            : undoJournal(journalFile, ok);
+    if (!ok)
+    {
+        std::cerr << RED << "Error: Could not read journal \"" << journalFile << "\".\n" << RESET;
+        return 2;
+    }
+
+    std::cout << GREEN << (command == "resume" ? "Moved: " : "Restored: ") << result.moved << RESET
+              << "  " << YELLOW << "Skipped: " << result.skipped << RESET << "\n";
+    return 0;
+}
+
+/**
+ * @brief Run `compile-rules [FILE] [--header FILE]`.
+ *
+ * Reads the JSON files in `data/` and writes the compiled bundle (default
+ * `data/rules.bin`) and, with `--header`, the `constexpr` tables.
+ *
+ * @param args Command line arguments without the program name.
+ * @return int Exit status: 0 on success, 1 on usage errors, 2 when an
+ *         output file cannot be written.
+ */
+static int runCompileRules(const std::vector<std::string> &args)
+{
+    std::string blobFile;
+    std::string headerFile;
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const std::string &arg = args[i];
+        if (arg == "--header")
+        {
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            headerFile = args[++i];
+        }
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            return usageError("unknown option '" + arg + "' for 'compile-rules'");
+        }
+        else if (blobFile.empty())
+        {
+            blobFile = arg;
+        }
+        else
+        {
+            return usageError("unexpected argument '" + arg + "'");
+        }
+    }
+
+    RuleData rules = loadRuleSources();
+    if (!headerFile.empty())
+    {
+        if (!writeRuleHeader(headerFile, rules))
+        {
+            std::cerr << RED << "Error: Could not write \"" << headerFile << "\".\n" << RESET;
+            return 2;
+        }
+        std::cout << GREEN << "Wrote " << headerFile << RESET << "\n";
+        if (blobFile.empty())
+            return 0;
+    }
+
+    if (blobFile.empty())
+        blobFile = DefaultRuleBlob;
+    if (!writeRuleBlob(blobFile, rules))
+    {
+        std::cerr << RED << "Error: Could not write \"" << blobFile << "\".\n" << RESET;
+        return 2;
+    }
+    std::cout << GREEN << "Wrote " << blobFile << RESET << " (" << rules.fileTypes.size() << " categories, "
+              << rules.dangerousExts.size() << " dangerous extensions, " << rules.ignoreTokens.size()
+              << " ignore tokens)\n";
+    return 0;
+}
+
+/**
+ * @brief Run `jobs <manifest>` once the common options are parsed.
+ *
+ * @param manifest    Manifest file, or "-" for stdin.
+ * @param defaults    Options every job starts from.
+ * @param incremental Whether jobs keep a scan index by default.
+ * @param workers     Roots organized at once (0 = all cores).
+ * @param perDevice   Roots organized at once per filesystem device.
+ * @param reportFile  JSON report destination, or empty.
+ * @return int Exit status: 0 when every job succeeded, 1 on usage errors,
+ *         2 when the manifest cannot be read, 3 when a job failed.
+ */
+static int runJobsCommand(const std::string &manifest, const CleanOptions &defaults, bool incremental,
+                          unsigned workers, unsigned perDevice, const std::string &reportFile)
+{
+    if (manifest.empty())
+        return usageError("'jobs' requires a manifest file (or - for stdin)");
+
+    std::vector<CleanJob> jobs;
+    std::string error;
+    bool read = false;
+    if (manifest == "-")
+    {
+        read = readJobManifest(std::cin, defaults, incremental, jobs, error);
+    }
+    else
+    {
+        std::ifstream in(manifest);
+        if (!in)
+            error = "cannot open file";
+        else
+            read = readJobManifest(in, defaults, incremental, jobs, error);
+    }
+    if (!read)
+    {
+        std::cerr << RED << "Error: Could not read manifest \"" << manifest << "\": " << error << ".\n" << RESET;
+        return 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<JobResult> results = runJobs(jobs, workers, perDevice);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (defaults.output == OutputFormat::Jsonl)
+        logJobSummary(results, seconds);
+    else
+        printJobSummary(results, seconds, std::cout);
+    if (!reportFile.empty() && !saveJobReport(results, seconds, reportFile))
+        std::cerr << RED << "Warning: Could not write report to " << reportFile << RESET << "\n";
+
+    bool allOk =
+        std::all_of(results.begin(), results.end(), [](const JobResult &r) { return r.ok && r.failed == 0; });
+    return allOk ? 0 : 3;
+}
+
+int runCli(int argc, char *argv[])
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    const std::string command = args.front();
+
+    if (command == "help" || command == "-h" || command == "--help")
+    {
+        printUsage(std::cout);
+        return 0;
+    }
+    if (command == "resume" || command == "undo")
+        return runJournalCommand(command, args);
+    if (command == "compile-rules")
+        return runCompileRules(args);
+    if (command != "type" && command != "name" && command != "list" && command != "jobs")
+        return usageError("unknown command '" + command + "'");
+
+    CleanOptions options;
+    options.interactive = false;
+
+    std::string directory;
+    bool printStats = false;
+    bool incremental = false;
+    bool watch = false;
+    bool threadsGiven = false;
+    unsigned workers = 0;
+    unsigned perDevice = 2;
+    std::string reportFile;
+    std::string statsFile;
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const std::string &arg = args[i];
+        if (arg == "--stats")
+        {
+            printStats = true;
+        }
+        else if (arg == "--stats-json")
+        {
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            statsFile = args[++i];
+        }
+        else if (arg == "--stream" || arg == "--summary")
+        {
+            if (command != "list")
+                return usageError(arg + " is only valid with 'list'");
+            options.listMode = arg == "--stream" ? ListMode::Stream : ListMode::Summary;
+        }
+        else if (arg == "--token" || arg == "-t")
+        {
+            if (command != "name")
+                return usageError(arg + " is only valid with 'name'");
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            // Repeated tokens are all matched; the first one has the highest priority
+            if (options.token.empty())
+                options.token = args[++i];
+            else
+                options.tokens.push_back(args[++i]);
+        }
+        else if (arg == "--tokens")
+        {
+            if (command != "name")
+                return usageError(arg + " is only valid with 'name'");
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            if (!loadTokenFile(args[++i], options.tokens))
+            {
+                std::cerr << RED << "Error: Could not read tokens from \"" << args[i] << "\".\n" << RESET;
+                return 2;
+            }
+        }
+        else if (arg == "--match")
+        {
+            if (command != "name")
+                return usageError(arg + " is only valid with 'name'");
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            const std::string &policy = args[++i];
+            if (policy == "longest")
+                options.matchPolicy = MatchPolicy::Longest;
+            else if (policy == "first")
+                options.matchPolicy = MatchPolicy::First;
+            else
+                return usageError(arg + " expects 'longest' or 'first'");
+        }
+        else if (arg == "--fuzzy")
+        {
+            if (command != "name")
+                return usageError(arg + " is only valid with 'name'");
+            options.fuzzy = true;
+        }
+        else if (arg == "--dry-run" || arg == "-n")
+        {
+            if (command == "list")
+                return usageError(arg + " is not valid with 'list'");
+            options.dryRun = true;
+        }
+        else if (arg == "--dest")
+        {
+            if (command == "list")
+                return usageError(arg + " is not valid with 'list'");
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            options.destination = args[++i];
+        }
+        else if (arg == "--journal")
+        {
+            if (command == "list" || command == "jobs")
+                return usageError(arg + " is not valid with '" + command + "'");
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            options.journalFile = args[++i];
+        }
+        else if (arg == "--io-uring")
+        {
+            if (command == "list")
+                return usageError(arg + " is not valid with 'list'");
+            options.ioUring = true;
+        }
+        else if (arg == "--dedupe")
+        {
+            if (command == "list")
+                return usageError(arg + " is not valid with 'list'");
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            const std::string &mode = args[++i];
+            if (mode == "skip")
+                options.dedupe = DedupeMode::Skip;
+            else if (mode == "link")
+                options.dedupe = DedupeMode::Link;
+            else
+                return usageError(arg + " expects 'skip' or 'link'");
+        }
+        else if (arg == "--sniff")
+        {
+            if (command != "type" && command != "jobs")
+                return usageError(arg + " is only valid with 'type' and 'jobs'");
+            options.sniff = true;
+        }
+        else if (arg == "--by-date")
+        {
+            if (command != "type" && command != "jobs")
+                return usageError(arg + " is only valid with 'type' and 'jobs'");
+            options.byDate = true;
+        }
+        else if (arg == "--quarantine" || arg == "--quarantine-scan")
+        {
+            if (command != "type" && command != "jobs")
+                return usageError(arg + " is only valid with 'type' and 'jobs'");
+            if (arg == "--quarantine-scan")
+            {
+                if (i + 1 >= args.size())
+                    return usageError(arg + " requires a value");
+                options.quarantineScan = args[++i];
+            }
+            options.quarantine = true;
+        }
+        else if (arg == "--watch")
+        {
+            if (command != "type")
+                return usageError(arg + " is only valid with 'type'");
+            watch = true;
+        }
+        else if (arg == "--incremental")
+        {
+            incremental = true;
+        }
+        else if (arg == "--index")
+        {
+            if (command == "jobs")
+                return usageError(arg + " is not valid with 'jobs' (set \"index\" per job)");
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            options.indexFile = args[++i];
+        }
+        else if (arg == "--plan")
+        {
+            if (command == "list" || command == "jobs")
+                return usageError(arg + " is not valid with '" + command + "'");
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            options.planFile = args[++i];
+        }
+        else if (arg == "--output")
+        {
+            if (command == "list")
+                return usageError(arg + " is not valid with 'list'");
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            const std::string &format = args[++i];
+            if (format == "text")
+                options.output = OutputFormat::Text;
+            else if (format == "jsonl")
+                options.output = OutputFormat::Jsonl;
+            else
+                return usageError(arg + " expects 'text' or 'jsonl'");
+        }
+        else if (arg == "--report")
+        {
+            if (command != "jobs")
+                return usageError(arg + " is only valid with 'jobs'");
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            reportFile = args[++i];
+        }
+        else if (arg == "--recursive" || arg == "-r")
+        {
+            options.scan.recursive = true;
+        }
+        else if (arg == "--max-depth" || arg == "--threads" || arg == "-j" || arg == "--move-jobs" ||
+                 arg == "--workers" || arg == "--per-device")
+        {
+            if ((arg == "--workers" || arg == "--per-device") && command != "jobs")
+                return usageError(arg + " is only valid with 'jobs'");
+            if (i + 1 >= args.size())
+                return usageError(arg + " requires a value");
+            int value = 0;
+            if (!parseCount(args[++i], value))
+                return usageError(arg + " expects a non-negative number");
+            if (arg == "--max-depth")
+            {
+                options.scan.recursive = true;
+                options.scan.maxDepth = value;
+            }
+            else if (arg == "--move-jobs")
+            {
+                options.moveJobs = value == 0 ? 1 : static_cast<unsigned>(value);
+            }
+            else if (arg == "--workers")
+            {
+                workers = static_cast<unsigned>(value);
+            }
+            else if (arg == "--per-device")
+            {
+                perDevice = value == 0 ? 1 : static_cast<unsigned>(value);
+            }
+            else
+            {
+                options.scan.threads = static_cast<unsigned>(value);
+                threadsGiven = true;
+            }
+        }
+        else if (!arg.empty() && arg[0] == '-' && !(arg == "-" && command == "jobs"))
+        {
+            return usageError("unknown option '" + arg + "'");
+        }
+        else if (directory.empty())
+        {
+            directory = arg;
+        }
+        else
+        {
+            return usageError("unexpected argument '" + arg + "'");
+        }
+    }
+
+    JsonlSession session(options.output == OutputFormat::Jsonl);
+
+    if (command == "jobs")
+    {
+        // Roots run side by side, so each scans on one thread unless -j says otherwise
+        if (!threadsGiven)
+            options.scan.threads = 1;
+        if (printStats || !statsFile.empty())
+            runStats().enable();
+        int status = runJobsCommand(directory, options, incremental, workers, perDevice, reportFile);
+        if (printStats)
+            runStats().print(std::cout);
+        if (!statsFile.empty() && !runStats().saveJson(statsFile))
+            std::cerr << RED << "Warning: Could not write statistics to " << statsFile << RESET << "\n";
+        return status;
+    }
+
+    fs::path target = directory.empty() ? fs::current_path() : fs::path(directory);
+    std::error_code ec;
+    if (!fs::is_directory(target, ec))
+    {
+        std::cerr << RED << "Error: The specified path \"" << target.string()
+                  << "\" is invalid or not a directory.\n" << RESET;
+        return 2;
+    }
+
+    if (incremental && options.indexFile.empty())
+        options.indexFile = defaultIndexPath(target).string();
+
+    if (printStats || !statsFile.empty())
+        runStats().enable();
+
+    bool ok = true;
+    if (watch)
+        ok = watchFilesByType(target, options);
+    else if (command == "type")
+        ok = cleanFilesByType(target, options);
+    else if (command == "name")
+        ok = cleanFilesByName(target, options);
+    else
+        listFilesInDirectory(target, options);
+
+    if (printStats)
+        runStats().print(std::cout);
+    if (!statsFile.empty() && !runStats().saveJson(statsFile))
+        std::cerr << RED << "Warning: Could not write statistics to " << statsFile << RESET << "\n";
+
+    return ok ? 0 : 4;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file colors.cpp
+ * @brief Terminal detection for the color constants.
+ *
+ * @see colors.hpp
+ */
+
+#include "colors.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+void disableColors()
+{
+    for (std::string *code : {&RESET, &BOLD, &DIM, &RED, &GREEN, &YELLOW, &BLUE, &MAGENTA, &CYAN, &WHITE})
+        code->clear();
+}
+
+void initColors()
+{
+#ifdef _WIN32
+    bool terminal = _isatty(_fileno(stdout)) != 0;
+#else
+    bool terminal = ::isatty(STDOUT_FILENO) != 0;
+#endif
+    const char *noColor = std::getenv("NO_COLOR");
+    if (!terminal || (noColor && *noColor))
+        disableColors();
+}
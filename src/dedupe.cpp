@@ -0,0 +1,412 @@
+/**
+ * @file dedupe.cpp
+ * @brief Implementation of the staged duplicate detection.
+ *
+ * @see dedupe.hpp
+ */
+
+#include "dedupe.hpp"
+#include "stats.hpp"
+#include "threadPool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+    /// Block size of the full-content hash.
+    constexpr std::size_t BlockBytes = 1 << 20;
+
+    /// Marks a candidate that is an existing destination file rather than a move.
+    constexpr std::size_t NoMove = static_cast<std::size_t>(-1);
+
+    constexpr std::uint64_t P1 = 11400714785074694791ull;
+    constexpr std::uint64_t P2 = 14029467366897019727ull;
+    constexpr std::uint64_t P3 = 1609587929392839161ull;
+    constexpr std::uint64_t P4 = 9650029242287828579ull;
+    constexpr std::uint64_t P5 = 2870177450012600261ull;
+
+    std::uint64_t rotl(std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    std::uint64_t read64(const unsigned char *p)
+    {
+        std::uint64_t v;
+        std::memcpy(&v, p, 8);
+        return v;
+    }
+
+    std::uint32_t read32(const unsigned char *p)
+    {
+        std::uint32_t v;
+        std::memcpy(&v, p, 4);
+        return v;
+    }
+
+    std::uint64_t round(std::uint64_t acc, std::uint64_t input)
+    {
+        return rotl(acc + input * P2, 31) * P1;
+    }
+
+    std::uint64_t mergeRound(std::uint64_t acc, std::uint64_t value)
+    {
+        return (acc ^ round(0, value)) * P1 + P4;
+    }
+
+    /**
+     * @brief XXH64 of `length` bytes.
+     *
+     * The four independent lanes of the main loop keep a modern core's
+     * multipliers busy; the result matches the reference implementation on
+     * little-endian machines.
+     */
+    std::uint64_t xxh64(const char *data, std::size_t length, std::uint64_t seed)
+    {
+        const auto *p = reinterpret_cast<const unsigned char *>(data);
+        const auto *end = p + length;
+        std::uint64_t h;
+
+        if (length >= 32)
+        {
+            std::uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+            for (; p + 32 <= end; p += 32)
+            {
+                v1 = round(v1, read64(p));
+                v2 = round(v2, read64(p + 8));
+                v3 = round(v3, read64(p + 16));
+                v4 = round(v4, read64(p + 24));
+            }
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = mergeRound(mergeRound(mergeRound(mergeRound(h, v1), v2), v3), v4);
+        }
+        else
+        {
+            h = seed + P5;
+        }
+
+        h += length;
+        for (; p + 8 <= end; p += 8)
+            h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+        if (p + 4 <= end)
+        {
+            h = rotl(h ^ (read32(p) * P1), 23) * P2 + P3;
+            p += 4;
+        }
+        for (; p < end; ++p)
+            h = rotl(h ^ (*p * P5), 11) * P1;
+
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    /// A file that may be identical to another one.
+    struct Candidate
+    {
+        fs::path path;
+        std::uint64_t size = 0;
+        std::size_t move = NoMove; ///< Index in the plan, or `NoMove` for an existing file.
+        std::uint64_t ends = 0;    ///< Hash of the first and last `HeadTailBytes`.
+        std::uint64_t full = 0;    ///< Hash of the whole content.
+        bool readable = true;
+    };
+
+    using Group = std::vector<std::size_t>;
+
+    /**
+     * @brief Read `length` bytes at `offset` and chain them into `hash`.
+     */
+    bool hashRange(std::ifstream &in, std::uint64_t offset, std::size_t length, std::vector<char> &buffer,
+                   std::uint64_t &hash)
+    {
+        buffer.resize(length);
+        in.seekg(static_cast<std::streamoff>(offset));
+        if (!in.read(buffer.data(), static_cast<std::streamsize>(length)))
+            return false;
+        hash = xxh64(buffer.data(), length, hash);
+        return true;
+    }
+
+    /// Hash both ends of a file; files no longer than both ends are hashed whole.
+    void hashEnds(Candidate &c, std::vector<char> &buffer)
+    {
+        std::ifstream in(c.path, std::ios::binary);
+        c.ends = c.size;
+        if (c.size <= 2 * HeadTailBytes)
+        {
+            c.readable = in && hashRange(in, 0, static_cast<std::size_t>(c.size), buffer, c.ends);
+            c.full = c.ends; // already covers every byte
+            return;
+        }
+        c.readable = in && hashRange(in, 0, HeadTailBytes, buffer, c.ends) &&
+                     hashRange(in, c.size - HeadTailBytes, HeadTailBytes, buffer, c.ends);
+    }
+
+    /// Hash the whole content, one block at a time.
+    void hashFull(Candidate &c, std::vector<char> &buffer)
+    {
+        std::ifstream in(c.path, std::ios::binary);
+        c.full = c.size;
+        c.readable = static_cast<bool>(in);
+        for (std::uint64_t offset = 0; c.readable && offset < c.size; offset += BlockBytes)
+            c.readable = hashRange(in, offset, static_cast<std::size_t>(std::min<std::uint64_t>(BlockBytes, c.size - offset)),
+                                   buffer, c.full);
+    }
+
+    /// Run `hash` on every candidate of `groups`, one file per task.
+    template <typename Hash>
+    void hashGroups(std::vector<Candidate> &candidates, const std::vector<Group> &groups, unsigned threads, Hash hash)
+    {
+        std::vector<std::size_t> items;
+        for (const Group &g : groups)
+            items.insert(items.end(), g.begin(), g.end());
+        runStats().addCalls(Phase::Dedupe, items.size());
+
+        if (threads <= 1 || items.size() < 2)
+        {
+            std::vector<char> buffer;
+            for (std::size_t i : items)
+                hash(candidates[i], buffer);
+            return;
+        }
+
+        ThreadPool pool(static_cast<unsigned>(std::min<std::size_t>(threads, items.size())));
+        for (std::size_t i : items)
+            pool.submit([&, i] {
+                thread_local std::vector<char> buffer;
+                hash(candidates[i], buffer);
+            });
+        pool.wait();
+    }
+
+    /// A file found identical to its kept copy, confirmed byte for byte.
+    struct Comparison
+    {
+        std::size_t candidate = 0;
+        std::size_t keeper = 0;
+        bool same = false;
+        fs::file_time_type sourceTime{}; ///< Modification time of the candidate before reading it.
+        fs::file_time_type keptTime{};   ///< Modification time of the keeper before reading it.
+    };
+
+    /// Read the modification time of `path` and check that it still has `size` bytes.
+    bool stampFile(const fs::path &path, std::uint64_t size, fs::file_time_type &time)
+    {
+        std::error_code ec;
+        time = fs::last_write_time(path, ec);
+        if (ec)
+            return false;
+        std::uint64_t now = fs::file_size(path, ec);
+        return !ec && now == size;
+    }
+
+    /**
+     * @brief Compare two files of `size` bytes block by block.
+     *
+     * Equal hashes only make a match likely; this is what allows a file to
+     * be replaced with a link to the other.
+     */
+    bool sameContent(const fs::path &a, const fs::path &b, std::uint64_t size, std::vector<char> &left,
+                     std::vector<char> &right)
+    {
+        std::ifstream inA(a, std::ios::binary), inB(b, std::ios::binary);
+        if (!inA || !inB)
+            return false;
+        left.resize(BlockBytes);
+        right.resize(BlockBytes);
+        for (std::uint64_t offset = 0; offset < size; offset += BlockBytes)
+        {
+            auto length = static_cast<std::size_t>(std::min<std::uint64_t>(BlockBytes, size - offset));
+            if (!inA.read(left.data(), static_cast<std::streamsize>(length)) ||
+                !inB.read(right.data(), static_cast<std::streamsize>(length)) ||
+                std::memcmp(left.data(), right.data(), length) != 0)
+                return false;
+        }
+        return inA.peek() == std::ifstream::traits_type::eof() && inB.peek() == std::ifstream::traits_type::eof();
+    }
+
+    /// Stamp and compare one candidate with its keeper.
+    void confirm(const std::vector<Candidate> &candidates, Comparison &c, std::vector<char> &left,
+                 std::vector<char> &right)
+    {
+        const Candidate &file = candidates[c.candidate];
+        const Candidate &kept = candidates[c.keeper];
+        c.same = stampFile(file.path, file.size, c.sourceTime) && stampFile(kept.path, kept.size, c.keptTime) &&
+                 sameContent(file.path, kept.path, file.size, left, right);
+    }
+
+    /**
+     * @brief Split groups by a key, keeping the parts worth comparing further.
+     *
+     * A part is kept when it has at least two readable files, one of which
+     * is a move (existing files are never marked). Files keep their order.
+     */
+    template <typename Key>
+    std::vector<Group> refine(const std::vector<Candidate> &candidates, const std::vector<Group> &groups, Key key)
+    {
+        std::vector<Group> out;
+        for (const Group &g : groups)
+        {
+            std::vector<std::uint64_t> keys;
+            std::unordered_map<std::uint64_t, Group> parts;
+            for (std::size_t i : g)
+            {
+                if (!candidates[i].readable)
+                    continue;
+                auto [it, inserted] = parts.try_emplace(key(candidates[i]));
+                if (inserted)
+                    keys.push_back(it->first);
+                it->second.push_back(i);
+            }
+            for (std::uint64_t k : keys)
+            {
+                Group &part = parts[k];
+                bool hasMove = std::any_of(part.begin(), part.end(),
+                                           [&](std::size_t i) { return candidates[i].move != NoMove; });
+                if (part.size() >= 2 && hasMove)
+                    out.push_back(std::move(part));
+            }
+        }
+        return out;
+    }
+}
+
+DedupeSummary findDuplicates(MovePlan &plan, DedupeMode mode, unsigned threads)
+{
+    DedupeSummary summary;
+    plan.linkDuplicates = mode == DedupeMode::Link;
+    if (mode == DedupeMode::Off)
+        return summary;
+
+    PhaseTimer timer(Phase::Dedupe);
+    if (threads == 0)
+        threads = ThreadPool::defaultThreads();
+
+    // Moves first, in plan order, then the files already at the destinations
+    std::vector<Candidate> candidates;
+    std::unordered_set<std::string> sources;
+    std::vector<fs::path> destDirs;
+    std::unordered_set<std::string> seenDirs;
+    for (std::size_t m = 0; m < plan.moves.size(); ++m)
+    {
+        const PlannedMove &move = plan.moves[m];
+        if (move.quarantined)
+            continue; // a dangerous file is quarantined even when its content is known
+        if (move.status != MoveStatus::Ready && move.status != MoveStatus::DestinationExists &&
+            move.status != MoveStatus::DuplicateInPlan)
+            continue;
+        std::error_code ec;
+        std::uint64_t size = fs::file_size(move.source, ec);
+        runStats().addCalls(Phase::Dedupe);
+        if (!ec)
+            candidates.push_back({move.source, size, m});
+        sources.insert(move.source.string());
+        fs::path dir = move.destination.parent_path();
+        if (seenDirs.insert(dir.string()).second)
+            destDirs.push_back(std::move(dir));
+    }
+    for (const fs::path &dir : destDirs)
+    {
+        std::error_code ec;
+        runStats().addCalls(Phase::Dedupe);
+        for (fs::directory_iterator d(dir, ec), end; !ec && d != end; d.increment(ec))
+        {
+            std::error_code fileEc;
+            if (d->is_symlink(fileEc) || !d->is_regular_file(fileEc) || sources.count(d->path().string()))
+                continue;
+            std::uint64_t size = d->file_size(fileEc);
+            if (!fileEc)
+                candidates.push_back({d->path(), size, NoMove});
+        }
+    }
+    runStats().addItems(Phase::Dedupe, candidates.size());
+
+    // Stage 1: only files sharing a size can be identical; empty files never count
+    std::vector<Group> groups(1);
+    for (std::size_t i = 0; i < candidates.size(); ++i)
+        if (candidates[i].size > 0)
+            groups[0].push_back(i);
+    groups = refine(candidates, groups, [](const Candidate &c) { return c.size; });
+
+    // Stage 2: both ends
+    hashGroups(candidates, groups, threads, hashEnds);
+    groups = refine(candidates, groups, [](const Candidate &c) { return c.ends; });
+
+    // Stage 3: the full content, only for files larger than both ends
+    std::vector<Group> large;
+    for (Group &g : groups)
+        if (candidates[g[0]].size > 2 * HeadTailBytes)
+            large.push_back(std::move(g));
+    groups.erase(std::remove_if(groups.begin(), groups.end(), [](const Group &g) { return g.empty(); }),
+                 groups.end());
+    hashGroups(candidates, large, threads, hashFull);
+    for (const Group &g : large)
+        summary.fullyHashed += g.size();
+    large = refine(candidates, large, [](const Candidate &c) { return c.full; });
+    groups.insert(groups.end(), std::make_move_iterator(large.begin()), std::make_move_iterator(large.end()));
+
+    // Keep an existing file when there is one, else the first ready move
+    std::vector<Comparison> comparisons;
+    for (const Group &g : groups)
+    {
+        auto keeper = std::find_if(g.begin(), g.end(), [&](std::size_t i) { return candidates[i].move == NoMove; });
+        if (keeper == g.end())
+            keeper = std::find_if(g.begin(), g.end(), [&](std::size_t i) {
+                return plan.moves[candidates[i].move].status == MoveStatus::Ready;
+            });
+        if (keeper == g.end())
+            continue; // only conflicting moves: nothing is kept to compare against
+        for (std::size_t i : g)
+            if (i != *keeper && candidates[i].move != NoMove)
+                comparisons.push_back({i, *keeper});
+    }
+
+    // Stage 4: hashes can collide, so every match is confirmed against its keeper
+    runStats().addCalls(Phase::Dedupe, comparisons.size());
+    if (threads <= 1 || comparisons.size() < 2)
+    {
+        std::vector<char> left, right;
+        for (Comparison &c : comparisons)
+            confirm(candidates, c, left, right);
+    }
+    else
+    {
+        ThreadPool pool(static_cast<unsigned>(std::min<std::size_t>(threads, comparisons.size())));
+        for (Comparison &c : comparisons)
+            pool.submit([&] {
+                thread_local std::vector<char> left, right;
+                confirm(candidates, c, left, right);
+            });
+        pool.wait();
+    }
+
+    for (const Comparison &c : comparisons)
+    {
+        if (!c.same)
+            continue;
+        const Candidate &kept = candidates[c.keeper];
+        PlannedMove &move = plan.moves[candidates[c.candidate].move];
+        move.status = MoveStatus::Identical;
+        move.duplicateOf = kept.move == NoMove ? kept.path : plan.moves[kept.move].destination;
+        move.duplicateSize = candidates[c.candidate].size;
+        move.sourceTime = c.sourceTime;
+        move.duplicateTime = c.keptTime;
+        ++summary.files;
+        summary.bytes += candidates[c.candidate].size;
+    }
+
+    // Directories only needed by files that are now identical are not created
+    std::unordered_set<std::string> needed;
+    for (const auto &move : plan.moves)
+        if (move.status == MoveStatus::Ready)
+            needed.insert(move.destination.parent_path().string());
+    plan.directories.erase(std::remove_if(plan.directories.begin(), plan.directories.end(),
+                                          [&](const fs::path &d) { return !needed.count(d.string()); }),
+                           plan.directories.end());
+    return summary;
+}
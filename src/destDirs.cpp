@@ -0,0 +1,143 @@
+/**
+ * @file destDirs.cpp
+ * @brief Implementation of the destination directory cache.
+ *
+ * @see destDirs.hpp
+ */
+
+#include "destDirs.hpp"
+#include "stats.hpp"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// Cache key of a directory; "a/b/" and "a/b" are the same directory.
+static std::string dirKey(const fs::path &dir)
+{
+    if (!dir.has_filename() && dir.has_relative_path())
+        return dir.parent_path().string();
+    return dir.string();
+}
+
+#ifdef _WIN32
+
+DestinationDirs::DestinationDirs() = default;
+DestinationDirs::~DestinationDirs() = default;
+
+const DestinationDirs::Entry &DestinationDirs::resolve(const fs::path &dir)
+{
+    std::string key = dirKey(dir);
+    auto it = entries_.find(key);
+    if (it != entries_.end())
+        return it->second;
+
+    Entry entry;
+    runStats().addCalls(Phase::Mkdir);
+    if (fs::create_directories(dir, entry.error))
+        ++created_;
+    if (!entry.error && !fs::is_directory(dir, entry.error) && !entry.error)
+        entry.error = std::make_error_code(std::errc::not_a_directory);
+    return entries_.emplace(std::move(key), entry).first->second;
+}
+
+#else
+
+DestinationDirs::DestinationDirs()
+{
+    // Leave room for the descriptors the scan, journal and copies need
+    struct rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0)
+        maxHandles_ = limit.rlim_cur == RLIM_INFINITY ? 4096 : static_cast<std::size_t>(limit.rlim_cur / 2);
+}
+
+DestinationDirs::~DestinationDirs()
+{
+    for (auto &item : entries_)
+        if (item.second.fd >= 0)
+            ::close(item.second.fd);
+}
+
+const DestinationDirs::Entry &DestinationDirs::resolve(const fs::path &dir)
+{
+    std::string key = dirKey(dir);
+    auto it = entries_.find(key);
+    if (it != entries_.end())
+        return it->second;
+
+    // Open (or, past the handle budget, stat) `name` relative to `at`
+    auto probe = [this](int at, const char *name, Entry &entry) {
+        runStats().addCalls(Phase::Mkdir);
+        if (handles_ < maxHandles_)
+        {
+            int fd = ::openat(at, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd >= 0)
+            {
+                ++handles_;
+                entry.fd = fd;
+                return true;
+            }
+            if (errno != EMFILE && errno != ENFILE)
+            {
+                entry.error = std::error_code(errno, std::generic_category());
+                return false;
+            }
+            maxHandles_ = handles_; // out of descriptors: use paths from now on
+            runStats().addCalls(Phase::Mkdir);
+        }
+        struct stat st;
+        if (::fstatat(at, name, &st, 0) != 0)
+            entry.error = std::error_code(errno, std::generic_category());
+        else if (!S_ISDIR(st.st_mode))
+            entry.error = std::make_error_code(std::errc::not_a_directory);
+        return !entry.error;
+    };
+
+    Entry entry;
+    if (!probe(AT_FDCWD, key.c_str(), entry) && entry.error == std::errc::no_such_file_or_directory)
+    {
+        // Missing: make sure the parent exists first, then create this level under it
+        fs::path path(key);
+        fs::path parent = path.parent_path();
+        int at = AT_FDCWD;
+        std::string name = key;
+        if (!parent.empty() && parent != path)
+        {
+            const Entry &up = resolve(parent);
+            entry.error = up.error;
+            if (up.fd >= 0)
+            {
+                at = up.fd;
+                name = path.filename().string();
+            }
+        }
+        else
+        {
+            entry.error.clear(); // relative to the working directory
+        }
+        if (!entry.error)
+        {
+            runStats().addCalls(Phase::Mkdir);
+            if (::mkdirat(at, name.c_str(), 0777) == 0)
+                ++created_;
+            else if (errno != EEXIST)
+                entry.error = std::error_code(errno, std::generic_category());
+            if (!entry.error)
+                probe(at, name.c_str(), entry);
+        }
+    }
+    return entries_.emplace(std::move(key), entry).first->second;
+}
+
+#endif
+
+int DestinationDirs::open(const fs::path &dir, std::error_code &ec)
+{
+    const Entry &entry = resolve(dir);
+    ec = entry.error;
+    return entry.fd;
+}
@@ -0,0 +1,340 @@
+/**
+ * @file fileMove.cpp
+ * @brief Implementation of `moveFile()` with a zero-copy cross-device fallback.
+ *
+ * @see fileMove.hpp
+ */
+
+#include "fileMove.hpp"
+#include "ioRing.hpp"
+#include "stats.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/fs.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#elif defined(__APPLE__)
+#include <copyfile.h>
+#endif
+
+void moveFilesBatched(const std::vector<std::pair<const fs::path *, const fs::path *>> &moves,
+                      const std::function<void(std::size_t, std::error_code)> &onDone,
+                      const std::vector<int> &destDirs)
+{
+    auto destDir = [&](std::size_t i) { return i < destDirs.size() ? destDirs[i] : -1; };
+#if defined(__linux__)
+    IoRing ring;
+    if (ring.ok())
+    {
+        // Renames that io_uring cannot finish (other device, no RENAME_NOREPLACE) go through moveFile()
+        std::vector<std::size_t> fallback;
+        std::vector<std::size_t> unsettled; // handed to the kernel, outcome never reported
+        std::vector<char> reported(moves.size(), 0);
+        std::vector<fs::path> names(moves.size()); // handle-relative targets, alive until submitted
+        std::size_t next = 0;
+        while (next < moves.size())
+        {
+            std::size_t first = next;
+            for (; next < moves.size(); ++next)
+            {
+                int dir = destDir(next);
+                const char *target = moves[next].second->c_str();
+                if (dir >= 0)
+                {
+                    names[next] = moves[next].second->filename();
+                    target = names[next].c_str();
+                }
+                if (!ring.prepRename(AT_FDCWD, moves[next].first->c_str(), dir >= 0 ? dir : AT_FDCWD, target,
+                                     RENAME_NOREPLACE, next))
+                    break;
+            }
+
+            runStats().addCalls(Phase::Move); // one io_uring_enter() per batch
+            unsigned consumed = 0;
+            bool ok = ring.submitAndWait(
+                [&](std::uint64_t tag, int res) {
+                    reported[tag] = 1;
+                    if (res == -EXDEV || res == -EINVAL)
+                        fallback.push_back(tag);
+                    else
+                        onDone(tag, res < 0 ? std::error_code(-res, std::generic_category()) : std::error_code());
+                },
+                consumed);
+            if (!ok)
+            {
+                for (std::size_t i = first; i < next; ++i)
+                    if (!reported[i])
+                        (i - first < consumed ? unsettled : fallback).push_back(i);
+                break; // the ring is retired; the remaining moves use plain renames
+            }
+        }
+        for (std::size_t i : fallback)
+            onDone(i, moveFileInto(*moves[i].first, destDir(i), *moves[i].second));
+        for (std::size_t i : unsettled)
+        {
+            // The kernel's rename may have won: the source is gone and the file is in place
+            std::error_code ec = moveFileInto(*moves[i].first, destDir(i), *moves[i].second);
+            std::error_code statEc;
+            if (ec == std::errc::no_such_file_or_directory &&
+                !fs::exists(fs::symlink_status(*moves[i].first, statEc)) &&
+                fs::exists(fs::symlink_status(*moves[i].second, statEc)))
+                ec.clear();
+            onDone(i, ec);
+        }
+        for (std::size_t i = next; i < moves.size(); ++i)
+            onDone(i, moveFileInto(*moves[i].first, destDir(i), *moves[i].second));
+        return;
+    }
+#endif
+    for (std::size_t i = 0; i < moves.size(); ++i)
+        onDone(i, moveFileInto(*moves[i].first, destDir(i), *moves[i].second));
+}
+
+#ifdef _WIN32
+
+std::error_code moveFile(const fs::path &source, const fs::path &destination)
+{
+    // MoveFileEx performs a rename on the same volume and a CopyFileEx plus
+    // delete across volumes; WRITE_THROUGH flushes the copy before returning.
+    runStats().addCalls(Phase::Move);
+    if (MoveFileExW(source.c_str(), destination.c_str(),
+                    MOVEFILE_COPY_ALLOWED | MOVEFILE_WRITE_THROUGH))
+        return {};
+    return std::error_code(static_cast<int>(GetLastError()), std::system_category());
+}
+
+std::error_code moveFileInto(const fs::path &source, int, const fs::path &destination)
+{
+    return moveFile(source, destination);
+}
+
+#else
+
+namespace
+{
+    /// Current `errno` as an error code.
+    std::error_code lastError()
+    {
+        return std::error_code(errno, std::generic_category());
+    }
+
+    /// Closes a descriptor on scope exit.
+    struct FdGuard
+    {
+        int fd;
+        ~FdGuard()
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+    };
+
+#if !defined(__APPLE__)
+    /**
+     * @brief Copy `size` bytes between two open descriptors in the kernel.
+     *
+     * Only used after a rename failed with `EXDEV`, so no `FICLONE` is
+     * attempted: a reflink cannot cross filesystems. Prefers
+     * `copy_file_range()` (which still shares extents where the kernel can),
+     * then `sendfile()`, and finally a plain read/write loop as a last resort.
+     */
+    std::error_code copyContents(int in, int out, off_t size)
+    {
+#if defined(__linux__)
+        off_t copied = 0;
+        bool rangeOk = true;
+        while (copied < size)
+        {
+            ssize_t n = ::copy_file_range(in, nullptr, out, nullptr,
+                                          static_cast<size_t>(size - copied), 0);
+            runStats().addCalls(Phase::Move);
+            if (n > 0)
+            {
+                copied += n;
+                continue;
+            }
+            if (n == 0)
+                break;
+            if (errno == EINTR)
+                continue;
+            if (copied == 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL ||
+                                errno == EOPNOTSUPP || errno == EPERM))
+            {
+                rangeOk = false; // older kernels refuse cross-filesystem ranges
+                break;
+            }
+            return lastError();
+        }
+        if (rangeOk)
+            return {};
+
+        off_t offset = 0;
+        bool sendfileOk = true;
+        while (offset < size)
+        {
+            ssize_t n = ::sendfile(out, in, &offset, static_cast<size_t>(size - offset));
+            runStats().addCalls(Phase::Move);
+            if (n > 0)
+                continue;
+            if (n == 0)
+                break;
+            if (errno == EINTR)
+                continue;
+            if (offset == 0 && (errno == EINVAL || errno == ENOSYS))
+            {
+                sendfileOk = false;
+                break;
+            }
+            return lastError();
+        }
+        if (sendfileOk)
+            return {};
+#endif
+        // Portable fallback
+        if (::lseek(in, 0, SEEK_SET) < 0 || ::lseek(out, 0, SEEK_SET) < 0)
+            return lastError();
+        char buffer[1 << 16];
+        for (;;)
+        {
+            ssize_t n = ::read(in, buffer, sizeof buffer);
+            runStats().addCalls(Phase::Move);
+            if (n == 0)
+                return {};
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return lastError();
+            }
+            for (ssize_t written = 0; written < n;)
+            {
+                ssize_t w = ::write(out, buffer + written, static_cast<size_t>(n - written));
+                runStats().addCalls(Phase::Move);
+                if (w < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return lastError();
+                }
+                written += w;
+            }
+        }
+    }
+#endif
+
+    /**
+     * @brief Copy `source` to a new file at `destination`, sync it and
+     *        unlink the source.
+     */
+    std::error_code crossDeviceMove(const fs::path &source, int destDir, const char *destination)
+    {
+        // open, fstat, open, futimens, fsync, unlink and two closes; copy steps are counted as they run
+        runStats().addCalls(Phase::Move, 8);
+        FdGuard in{::open(source.c_str(), O_RDONLY | O_CLOEXEC)};
+        if (in.fd < 0)
+            return lastError();
+
+        struct stat st;
+        if (::fstat(in.fd, &st) != 0)
+            return lastError();
+
+        // O_EXCL: never overwrite something that appeared since planning
+        FdGuard out{::openat(destDir, destination, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                             st.st_mode & 07777)};
+        if (out.fd < 0)
+            return lastError();
+
+        auto fail = [&](std::error_code ec) {
+            ::unlinkat(destDir, destination, 0);
+            return ec;
+        };
+
+#if defined(__APPLE__)
+        if (::fcopyfile(in.fd, out.fd, nullptr, COPYFILE_DATA | COPYFILE_CLONE) != 0)
+            return fail(lastError());
+#else
+        if (std::error_code ec = copyContents(in.fd, out.fd, st.st_size))
+            return fail(ec);
+#endif
+
+        // Keep the original modification time; organizers often sort by it
+#if defined(__APPLE__)
+        struct timespec times[2] = {st.st_atimespec, st.st_mtimespec};
+#else
+        struct timespec times[2] = {st.st_atim, st.st_mtim};
+#endif
+        ::futimens(out.fd, times);
+
+        if (::fsync(out.fd) != 0)
+            return fail(lastError());
+
+        if (::unlink(source.c_str()) != 0)
+            return fail(lastError());
+        return {};
+    }
+}
+
+/**
+ * @brief Rename without ever replacing an existing destination.
+ *
+ * Uses `renameat2(RENAME_NOREPLACE)` on Linux and `renameatx_np(RENAME_EXCL)`
+ * on macOS. Filesystems that cannot honour the flag get an existence check
+ * followed by a plain rename. `to` is resolved relative to `toDir`.
+ *
+ * @return int 0 on success, -1 with `errno` set otherwise.
+ */
+static int renameNoReplace(const char *from, int toDir, const char *to)
+{
+#if defined(__linux__) && defined(SYS_renameat2)
+    if (::syscall(SYS_renameat2, AT_FDCWD, from, toDir, to, RENAME_NOREPLACE) == 0)
+        return 0;
+    if (errno != EINVAL && errno != ENOSYS)
+        return -1;
+#elif defined(__APPLE__)
+    if (::renameatx_np(AT_FDCWD, from, toDir, to, RENAME_EXCL) == 0)
+        return 0;
+    if (errno != ENOTSUP)
+        return -1;
+#endif
+    if (::faccessat(toDir, to, F_OK, 0) == 0)
+    {
+        errno = EEXIST;
+        return -1;
+    }
+    return ::renameat(AT_FDCWD, from, toDir, to);
+}
+
+/// `moveFile()` with the destination resolved relative to `destDir`.
+static std::error_code moveFileAt(const fs::path &source, int destDir, const char *destination)
+{
+    runStats().addCalls(Phase::Move);
+    if (renameNoReplace(source.c_str(), destDir, destination) == 0)
+        return {};
+    if (errno != EXDEV)
+        return lastError();
+    return crossDeviceMove(source, destDir, destination);
+}
+
+std::error_code moveFile(const fs::path &source, const fs::path &destination)
+{
+    return moveFileAt(source, AT_FDCWD, destination.c_str());
+}
+
+std::error_code moveFileInto(const fs::path &source, int destDir, const fs::path &destination)
+{
+    if (destDir < 0)
+        return moveFileAt(source, AT_FDCWD, destination.c_str());
+    return moveFileAt(source, destDir, destination.filename().c_str());
+}
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * @file fileTable.cpp
+ * @brief Implementation of the compact scanned-file store.
+ *
+ * @see fileTable.hpp
+ */
+
+#include "fileTable.hpp"
+#include "nameKernel.hpp"
+
+std::uint32_t FileTable::store(std::string_view text)
+{
+    auto offset = static_cast<std::uint32_t>(pool_.size());
+    pool_.append(text);
+    return offset;
+}
+
+std::uint32_t FileTable::addDirectory(std::string_view relative)
+{
+    DirRecord dir;
+    dir.offset = store(relative);
+    dir.length = static_cast<std::uint32_t>(relative.size());
+    dirs_.push_back(dir);
+    return static_cast<std::uint32_t>(dirs_.size() - 1);
+}
+
+FileRecord &FileTable::add(std::uint32_t dir, std::string_view name, const ExtClassifier &classifier)
+{
+    classifier_ = &classifier;
+
+    FileRecord record;
+    record.nameOffset = store(name);
+    record.dir = dir;
+    record.nameLength = static_cast<std::uint16_t>(name.size());
+    record.extLength = extensionLength(name);
+
+    Classification cls = classifier.classify(name.substr(name.size() - record.extLength));
+    record.category = cls.category;
+    if (cls.dangerous)
+        record.flags |= FileRecord::Dangerous;
+
+    records_.push_back(record);
+    return records_.back();
+}
+
+void FileTable::appendRelativePath(std::size_t i, std::string &out) const
+{
+    std::string_view dir = directory(i);
+    if (!dir.empty())
+    {
+        out.append(dir);
+        out.push_back('/');
+    }
+    out.append(name(i));
+}
+
+fs::path FileTable::path(std::size_t i) const
+{
+    std::string_view dir = directory(i);
+    fs::path p = root_;
+    if (!dir.empty())
+        p /= fs::path(dir);
+    p /= fs::path(name(i));
+    return p;
+}
+
+void FileTable::erase(std::size_t i)
+{
+    // The pool bytes stay; only the record goes
+    records_.erase(records_.begin() + static_cast<std::ptrdiff_t>(i));
+    if (i < captured_.size())
+        captured_.erase(captured_.begin() + static_cast<std::ptrdiff_t>(i));
+}
+
+void FileTable::setCaptured(std::size_t i, std::int64_t seconds)
+{
+    if (captured_.size() < records_.size())
+        captured_.resize(records_.size(), DateUnread);
+    captured_[i] = seconds;
+}
+
+void FileTable::append(FileTable &&other)
+{
+    if (!classifier_)
+        classifier_ = other.classifier_;
+    auto poolBase = static_cast<std::uint32_t>(pool_.size());
+    auto dirBase = static_cast<std::uint32_t>(dirs_.size());
+
+    pool_.append(other.pool_);
+    dirs_.reserve(dirs_.size() + other.dirs_.size());
+    for (DirRecord d : other.dirs_)
+    {
+        d.offset += poolBase;
+        dirs_.push_back(d);
+    }
+    if (!other.captured_.empty() || !captured_.empty())
+    {
+        captured_.resize(records_.size(), DateUnread);
+        captured_.insert(captured_.end(), other.captured_.begin(), other.captured_.end());
+        captured_.resize(records_.size() + other.records_.size(), DateUnread);
+    }
+    records_.reserve(records_.size() + other.records_.size());
+    for (FileRecord r : other.records_)
+    {
+        r.nameOffset += poolBase;
+        r.dir += dirBase;
+        records_.push_back(r);
+    }
+
+    other = FileTable(other.root_);
+}
+
+std::size_t FileTable::memoryUsage() const
+{
+    return pool_.capacity() + dirs_.capacity() * sizeof(DirRecord) +
+           records_.capacity() * sizeof(FileRecord) + captured_.capacity() * sizeof(std::int64_t);
+}
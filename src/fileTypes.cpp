@@ -1,5 +1,8 @@
 #include "fileTypes.hpp"
 #include "json.hpp"
+#include "ruleSet.hpp"
+#include "defaultRules.hpp"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -7,67 +10,173 @@
  * @file fileTypes.cpp
  * @brief Loads and provides mappings of file-type categories to file extensions.
  *
- * The module attempts to read `data/filetypes.json` for a user-provided
+ * The module attempts to read `data/fileTypes.json` for a user-provided
  * mapping of category → extension list. If the JSON file is missing or
  * invalid the implementation falls back to a built-in mapping returned by
  * `fallbackFileTypes()`.
  *
  * The `getFileTypes()` function provides a cached, read-once accessor that
- * loads the mappings on first call.
+ * loads the mappings on first call through the shared `RuleSet`. It is safe
+ * to call from several threads (e.g. the watch loop and the scanner workers).
  */
 
 using json = nlohmann::json;
 
-/**
- * @brief In-memory cache of loaded file type mappings.
- *
- * Populated on first call to `getFileTypes()` by `loadFileTypes()`.
- * This cache is intentionally single-threaded; callers in multi-threaded
- * contexts should add synchronization as needed.
- */
-static std::map<std::string, std::vector<std::string>> FILE_TYPES_CACHE;
-
-/**
- * @brief Indicates whether the cache has been populated.
- */
-static bool loaded = false;
-
 // -----------------------
 // Hardcoded fallback map
 // -----------------------
 /**
  * @brief Returns a built-in mapping of category → extension list.
  *
- * This fallback is used when `data/filetypes.json` cannot be opened or is
- * invalid JSON. The mapping includes common media, document, archive and code
- * extensions and provides a sensible default categorization.
+ * This fallback is used when `data/fileTypes.json` cannot be opened or is
+ * invalid JSON. It is built from the generated `constexpr` tables in
+ * `defaultRules.hpp` (the shipped `data/fileTypes.json`) and includes common
+ * media, document, archive and code extensions.
  *
  * @return std::map<std::string, std::vector<std::string>> The fallback mapping.
  */
 static std::map<std::string, std::vector<std::string>> fallbackFileTypes()
 {
-    return {
-        {"Images", {".jpg", ".jpeg", ".png", ".gif", ".bmp", ".tiff", ".webp", ".heic", ".heif", ".svg", ".ico", ".jfif", ".raw", ".arw", ".cr2", ".nef", ".orf", ".dng"}},
-        {"Videos", {".mp4", ".mov", ".avi", ".mkv", ".wmv", ".flv", ".webm", ".mpeg", ".mpg", ".3gp", ".m4v", ".ts", ".mts", ".vob"}},
-        {"Audio", {".mp3", ".wav", ".flac", ".aac", ".ogg", ".wma", ".m4a", ".opus", ".aiff", ".mid", ".midi"}},
-        {"Documents", {".pdf", ".doc", ".docx", ".txt", ".rtf", ".odt", ".csv", ".xlsx", ".xls", ".ppt", ".pptx", ".epub", ".md", ".tex", ".pages", ".numbers", ".key"}},
-        {"Archives", {".zip", ".rar", ".7z", ".tar", ".gz", ".bz2", ".xz", ".iso", ".dmg", ".tgz", ".cab"}},
-        {"Code", {".py", ".js", ".html", ".css", ".c", ".cpp", ".h", ".hpp", ".java", ".sh", ".ts", ".php", ".rb", ".go", ".swift", ".kt", ".rs", ".lua", ".sql", ".json", ".xml", ".yml", ".yaml", ".cs", ".vb", ".pl", ".asm", ".bat", ".cmd"}},
-        {"Fonts", {".ttf", ".otf", ".woff", ".woff2", ".eot", ".fon"}},
-        {"3D_Models", {".obj", ".fbx", ".stl", ".blend", ".3ds", ".dae", ".ply", ".gltf", ".glb"}},
-        {"Subtitles", {".srt", ".vtt", ".ass", ".ssa", ".sub"}},
-        {"Configs", {".ini", ".cfg", ".conf", ".jsonc", ".toml", ".env", ".properties"}},
-        {"DiskImages", {".iso", ".img", ".vhd", ".vhdx", ".vdi", ".vmdk"}},
-        {"Packages", {".deb", ".rpm", ".apk", ".jar", ".whl", ".gem", ".msi"}},
-        {"Other", {}}
-    };
+    std::map<std::string, std::vector<std::string>> result;
+    for (const auto &category : defaultRules::fileTypes)
+    {
+        auto &exts = result[std::string(category.name)];
+        for (std::size_t i = 0; i < category.count; ++i)
+            exts.emplace_back(defaultRules::extensions[category.first + i]);
+    }
+    return result;
+}
+
+// -----------------------
+// Routing rules
+// -----------------------
+/// Report a problem with routing rule `rule`.
+static bool failRoute(std::string &error, std::size_t rule, const std::string &message)
+{
+    error = "$routes[" + std::to_string(rule) + "]: " + message;
+    return false;
+}
+
+/// Whether `to` stays below the destination root.
+static bool isRelativeFolder(const std::string &to)
+{
+    fs::path p(to);
+    if (to.empty() || p.is_absolute() || p.has_root_name() || p.has_root_directory())
+        return false;
+    return std::none_of(p.begin(), p.end(), [](const fs::path &part) { return part == ".."; });
+}
+
+/**
+ * @brief Read the `"$routes"` list of a file types document.
+ *
+ * @param j      Value of the `"$routes"` key.
+ * @param routes Receives the rules, in order.
+ * @param error  Receives a description of the first problem.
+ * @return bool False when the list is malformed.
+ */
+static bool readRouteRules(const json &j, std::vector<RouteRule> &routes, std::string &error)
+{
+    if (!j.is_array())
+    {
+        error = "$routes must be a list of rules";
+        return false;
+    }
+
+    std::vector<RouteRule> result;
+    for (std::size_t i = 0; i < j.size(); ++i)
+    {
+        const json &entry = j[i];
+        if (!entry.is_object())
+            return failRoute(error, i, "a rule must be an object");
+
+        RouteRule rule;
+        for (const auto &[key, value] : entry.items())
+        {
+            if (key == "category")
+            {
+                if (value.is_string())
+                    rule.categories.push_back(value.get<std::string>());
+                else if (value.is_array() && std::all_of(value.begin(), value.end(),
+                                                         [](const json &c) { return c.is_string(); }))
+                    rule.categories = value.get<std::vector<std::string>>();
+                else
+                    return failRoute(error, i, "'category' must be a name or a list of names");
+            }
+            else if (key == "minSize" || key == "maxSize")
+            {
+                std::uint64_t bytes = 0;
+                bool ok = value.is_number_unsigned() ? (bytes = value.get<std::uint64_t>(), true)
+                          : value.is_string()        ? parseByteSize(value.get<std::string>(), bytes)
+                                                     : false;
+                if (!ok)
+                    return failRoute(error, i, "'" + key + "' expects a size such as \"4 GiB\"");
+                (key == "minSize" ? rule.minSize : rule.maxSize) = bytes;
+            }
+            else if (key == "olderThan" || key == "newerThan")
+            {
+                std::int64_t seconds = 0;
+                bool ok = value.is_number_unsigned() ? (seconds = value.get<std::int64_t>(), true)
+                          : value.is_string()        ? parseAge(value.get<std::string>(), seconds)
+                                                     : false;
+                if (!ok)
+                    return failRoute(error, i, "'" + key + "' expects an age such as \"90d\"");
+                (key == "olderThan" ? rule.minAge : rule.maxAge) = seconds;
+            }
+            else if (key == "to")
+            {
+                if (!value.is_string() || !isRelativeFolder(value.get<std::string>()))
+                    return failRoute(error, i, "'to' must be a folder below the destination");
+                rule.to = value.get<std::string>();
+            }
+            else
+            {
+                return failRoute(error, i, "unknown key '" + key + "'");
+            }
+        }
+        if (rule.to.empty())
+            return failRoute(error, i, "missing 'to'");
+        result.push_back(std::move(rule));
+    }
+    routes = std::move(result);
+    return true;
+}
+
+bool parseFileTypes(const json &j, std::map<std::string, std::vector<std::string>> &types,
+                    std::vector<RouteRule> &routes, std::string &error)
+{
+    if (!j.is_object())
+    {
+        error = "file types must be an object";
+        return false;
+    }
+
+    std::map<std::string, std::vector<std::string>> result;
+    std::vector<RouteRule> rules;
+    for (auto &[key, value] : j.items())
+    {
+        if (key == "$routes")
+        {
+            if (!readRouteRules(value, rules, error))
+                return false;
+            continue;
+        }
+        if (!value.is_array() || !std::all_of(value.begin(), value.end(), [](const json &e) { return e.is_string(); }))
+        {
+            error = "category \"" + key + "\" must be a list of extensions";
+            return false;
+        }
+        result[key] = value.get<std::vector<std::string>>();
+    }
+    types = std::move(result);
+    routes = std::move(rules);
+    return true;
 }
 
 // -----------------------
 // Try reading JSON
 // -----------------------
 /**
- * @brief Loads file type mappings from `data/filetypes.json`.
+ * @brief Loads file type mappings from `data/fileTypes.json`.
  *
  * Attempts to open and parse the JSON file. The expected format is a top-level
  * object where keys are category names and values are arrays of extension
@@ -82,13 +191,15 @@ static std::map<std::string, std::vector<std::string>> fallbackFileTypes()
  *
  * @return std::map<std::string, std::vector<std::string>> Loaded mapping.
  */
-std::map<std::string, std::vector<std::string>> loadFileTypes()
+std::map<std::string, std::vector<std::string>> loadFileTypes(std::vector<RouteRule> *routes)
 {
-    std::ifstream f("data/filetypes.json");
+    if (routes)
+        routes->clear();
+    std::ifstream f("data/fileTypes.json");
 
     if (!f.is_open())
     {
-        std::cerr << "[WARN] Could not open data/filetypes.json, using fallback.\n";
+        std::cerr << "[WARN] Could not open data/fileTypes.json, using fallback.\n";
         return fallbackFileTypes();
     }
 
@@ -98,17 +209,21 @@ std::map<std::string, std::vector<std::string>> loadFileTypes()
         f >> j;
 
         std::map<std::string, std::vector<std::string>> result;
-
-        for (auto &[key, value] : j.items())
+        std::vector<RouteRule> rules;
+        std::string error;
+        if (!parseFileTypes(j, result, rules, error))
         {
-            result[key] = value.get<std::vector<std::string>>();
+            std::cerr << "[WARN] Invalid fileTypes.json (" << error << "), using fallback.\n";
+            return fallbackFileTypes();
         }
+        if (routes)
+            *routes = std::move(rules);
 
         return result;
     }
     catch (...)
     {
-        std::cerr << "[WARN] Invalid JSON in filetypes.json, using fallback.\n";
+        std::cerr << "[WARN] Invalid JSON in fileTypes.json, using fallback.\n";
         return fallbackFileTypes();
     }
 }
@@ -119,18 +234,13 @@ std::map<std::string, std::vector<std::string>> loadFileTypes()
 /**
  * @brief Returns the cached mapping of file types to extensions.
  *
- * On first invocation, the function loads the mapping from
- * `data/filetypes.json` (falling back to the built-in mapping on error)
- * and caches the result for subsequent calls.
+ * The mapping is part of the shared `RuleSet`: it is loaded by
+ * `loadFileTypes()` on first use (falling back to the built-in mapping on
+ * error) and read lock-free afterwards.
  *
  * @return const std::map<std::string, std::vector<std::string>>& Reference to cached mapping.
  */
 const std::map<std::string, std::vector<std::string>>& getFileTypes()
 {
-    if (!loaded)
-    {
-        FILE_TYPES_CACHE = loadFileTypes();
-        loaded = true;
-    }
-    return FILE_TYPES_CACHE;
+    return currentRules().fileTypes;
 }
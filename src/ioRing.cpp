@@ -0,0 +1,245 @@
+/**
+ * @file ioRing.cpp
+ * @brief Implementation of the raw io_uring rename ring.
+ *
+ * @see ioRing.hpp
+ */
+
+#include "ioRing.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define CLEAN_HAVE_IO_URING 1
+#endif
+
+#ifdef CLEAN_HAVE_IO_URING
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+    unsigned loadAcquire(const unsigned *p)
+    {
+        return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+    }
+
+    void storeRelease(unsigned *p, unsigned value)
+    {
+        __atomic_store_n(p, value, __ATOMIC_RELEASE);
+    }
+
+    /// Whether the kernel reports `opcode` as supported.
+    bool probeOp(int fd, unsigned opcode)
+    {
+        std::vector<unsigned char> storage(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+        auto *probe = reinterpret_cast<io_uring_probe *>(storage.data());
+        if (::syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0)
+            return false;
+        return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED);
+    }
+}
+
+IoRing::IoRing(unsigned entries)
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof params);
+    int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0)
+        return; // ENOSYS, or disabled by sysctl / seccomp
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single)
+        sqRingSize_ = cqRingSize_ = sqRingSize_ > cqRingSize_ ? sqRingSize_ : cqRingSize_;
+
+    void *sq = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                      IORING_OFF_SQ_RING);
+    void *cq = single ? sq
+                      : ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                               IORING_OFF_CQ_RING);
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                        IORING_OFF_SQES);
+    if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        if (sqes != MAP_FAILED)
+            ::munmap(sqes, sqesSize_);
+        if (!single && cq != MAP_FAILED)
+            ::munmap(cq, cqRingSize_);
+        if (sq != MAP_FAILED)
+            ::munmap(sq, sqRingSize_);
+        ::close(fd);
+        return;
+    }
+
+    fd_ = fd;
+    sqRing_ = sq;
+    cqRing_ = cq;
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+    auto *sqBase = static_cast<char *>(sq);
+    sqHead_ = reinterpret_cast<unsigned *>(sqBase + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned *>(sqBase + params.sq_off.tail);
+    sqArray_ = reinterpret_cast<unsigned *>(sqBase + params.sq_off.array);
+    sqMask_ = *reinterpret_cast<unsigned *>(sqBase + params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+
+    auto *cqBase = static_cast<char *>(cq);
+    cqHead_ = reinterpret_cast<unsigned *>(cqBase + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned *>(cqBase + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned *>(cqBase + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cqBase + params.cq_off.cqes);
+
+    localTail_ = *sqTail_;
+    renameSupported_ = probeOp(fd_, IORING_OP_RENAMEAT);
+}
+
+IoRing::~IoRing()
+{
+    if (fd_ < 0)
+        return;
+    ::munmap(sqes_, sqesSize_);
+    if (cqRing_ != sqRing_)
+        ::munmap(cqRing_, cqRingSize_);
+    ::munmap(sqRing_, sqRingSize_);
+    ::close(fd_);
+}
+
+std::size_t IoRing::space() const
+{
+    if (fd_ < 0)
+        return 0;
+    return sqEntries_ - (localTail_ - loadAcquire(sqHead_));
+}
+
+io_uring_sqe *IoRing::nextSqe()
+{
+    if (space() == 0)
+        return nullptr;
+    unsigned slot = localTail_ & sqMask_;
+    io_uring_sqe *sqe = &sqes_[slot];
+    std::memset(sqe, 0, sizeof *sqe);
+    sqArray_[slot] = slot;
+    ++localTail_;
+    ++queued_;
+    return sqe;
+}
+
+bool IoRing::prepRename(int oldDir, const char *oldPath, int newDir, const char *newPath, unsigned flags,
+                        std::uint64_t tag)
+{
+    if (!renameSupported_)
+        return false;
+    io_uring_sqe *sqe = nextSqe();
+    if (!sqe)
+        return false;
+    sqe->opcode = IORING_OP_RENAMEAT;
+    sqe->fd = oldDir;
+    sqe->addr = reinterpret_cast<std::uint64_t>(oldPath);
+    sqe->len = static_cast<unsigned>(newDir);
+    sqe->addr2 = reinterpret_cast<std::uint64_t>(newPath);
+    sqe->rename_flags = flags;
+    sqe->user_data = tag;
+    return true;
+}
+
+bool IoRing::submitAndWait(const std::function<void(std::uint64_t tag, int result)> &onComplete,
+                           unsigned &consumed)
+{
+    consumed = 0;
+    if (fd_ < 0 || broken_)
+        return !broken_;
+    if (queued_ == 0)
+        return true;
+
+    // Publish the new tail, then submit and wait in one call
+    unsigned startHead = loadAcquire(sqHead_);
+    storeRelease(sqTail_, localTail_);
+    unsigned batch = queued_;
+    unsigned toSubmit = queued_;
+    unsigned pending = queued_;
+    queued_ = 0;
+    bool ok = true;
+
+    auto reap = [&] {
+        unsigned head = *cqHead_;
+        unsigned tail = loadAcquire(cqTail_);
+        for (; head != tail && pending > 0; ++head, --pending)
+        {
+            const io_uring_cqe &cqe = cqes_[head & cqMask_];
+            onComplete(cqe.user_data, cqe.res);
+        }
+        storeRelease(cqHead_, head);
+    };
+
+    while (pending > 0)
+    {
+        long rc = ::syscall(__NR_io_uring_enter, fd_, toSubmit, pending, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            ok = false;
+            break;
+        }
+        toSubmit -= static_cast<unsigned>(rc) < toSubmit ? static_cast<unsigned>(rc) : toSubmit;
+        reap();
+    }
+
+    unsigned head = loadAcquire(sqHead_);
+    consumed = head - startHead;
+    if (ok)
+        return true;
+
+    // Operations the kernel took keep running and post their completions without
+    // another io_uring_enter(); collect them for a while, then give up on the ring
+    using namespace std::chrono;
+    auto deadline = steady_clock::now() + DrainTimeout;
+    reap();
+    while (pending > batch - consumed && steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(milliseconds(1));
+        reap();
+    }
+    broken_ = true;
+    localTail_ = head; // withdraw the entries the kernel never read
+    storeRelease(sqTail_, localTail_);
+    return false;
+}
+
+#else
+
+IoRing::IoRing(unsigned) {}
+IoRing::~IoRing() {}
+
+std::size_t IoRing::space() const
+{
+    return 0;
+}
+
+io_uring_sqe *IoRing::nextSqe()
+{
+    return nullptr;
+}
+
+bool IoRing::prepRename(int, const char *, int, const char *, unsigned, std::uint64_t)
+{
+    return false;
+}
+
+bool IoRing::submitAndWait(const std::function<void(std::uint64_t tag, int result)> &, unsigned &consumed)
+{
+    consumed = 0;
+    return true;
+}
+
+#endif
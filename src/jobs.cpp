@@ -0,0 +1,602 @@
+/**
+ * @file jobs.cpp
+ * @brief Implementation of the multi-root job scheduler.
+ *
+ * @see jobs.hpp
+ */
+
+#include "jobs.hpp"
+#include "colors.hpp"
+#include "fileTypes.hpp"
+#include "json.hpp"
+#include "scanIndex.hpp"
+#include "mediaDate.hpp"
+#include "quarantine.hpp"
+#include "resultLog.hpp"
+#include "sniffer.hpp"
+#include "threadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace
+{
+    /// Rule keys of a manifest entry; unset keys keep the inherited rules.
+    struct RuleOverrides
+    {
+        std::optional<std::map<std::string, std::vector<std::string>>> fileTypes;
+        std::vector<RouteRule> routes; ///< Routing rules of `fileTypes`.
+        std::optional<std::vector<std::string>> dangerousExts;
+
+        bool empty() const { return !fileTypes && !dangerousExts; }
+    };
+
+    /// Options and rules a manifest entry starts from.
+    struct JobSettings
+    {
+        CleanOptions options;
+        RuleOverrides rules;
+        bool incremental = false;
+    };
+
+    bool fail(std::string &error, const std::string &where, const std::string &message)
+    {
+        error = where + ": " + message;
+        return false;
+    }
+
+    /**
+     * @brief Apply the option and rule keys of one manifest object.
+     *
+     * @param perJob Whether `j` describes a job (`root` and `index` are only valid there).
+     */
+    bool applyKeys(const json &j, JobSettings &settings, bool perJob, const std::string &where,
+                   std::string &error)
+    {
+        CleanOptions &o = settings.options;
+        for (const auto &[key, value] : j.items())
+        {
+            if (key == "root" && perJob)
+            {
+                if (!value.is_string())
+                    return fail(error, where, "'root' must be a string");
+            }
+            else if (key == "recursive" || key == "dryRun" || key == "sniff" || key == "byDate" ||
+                     key == "quarantine" || key == "incremental")
+            {
+                if (!value.is_boolean())
+                    return fail(error, where, "'" + key + "' must be true or false");
+                bool on = value.get<bool>();
+                if (key == "recursive")
+                    o.scan.recursive = on;
+                else if (key == "dryRun")
+                    o.dryRun = on;
+                else if (key == "sniff")
+                    o.sniff = on;
+                else if (key == "byDate")
+                    o.byDate = on;
+                else if (key == "quarantine")
+                    o.quarantine = on;
+                else
+                    settings.incremental = on;
+            }
+            else if (key == "maxDepth")
+            {
+                if (!value.is_number_integer() || value.get<long long>() < 0)
+                    return fail(error, where, "'maxDepth' must be a non-negative number");
+                o.scan.recursive = true;
+                o.scan.maxDepth = static_cast<int>(value.get<long long>());
+            }
+            else if (key == "index" && !perJob)
+            {
+                return fail(error, where, "'index' is only valid for a single job");
+            }
+            else if (key == "dest" || key == "index")
+            {
+                if (!value.is_string())
+                    return fail(error, where, "'" + key + "' must be a string");
+                (key == "dest" ? o.destination : o.indexFile) = value.get<std::string>();
+            }
+            else if (key == "dedupe")
+            {
+                std::string mode = value.is_string() ? value.get<std::string>() : std::string();
+                if (mode == "off")
+                    o.dedupe = DedupeMode::Off;
+                else if (mode == "skip")
+                    o.dedupe = DedupeMode::Skip;
+                else if (mode == "link")
+                    o.dedupe = DedupeMode::Link;
+                else
+                    return fail(error, where, "'dedupe' expects \"off\", \"skip\" or \"link\"");
+            }
+            else if (key == "fileTypes")
+            {
+                std::map<std::string, std::vector<std::string>> types;
+                std::string problem;
+                if (!parseFileTypes(value, types, settings.rules.routes, problem))
+                    return fail(error, where, "'fileTypes': " + problem);
+                settings.rules.fileTypes = std::move(types);
+            }
+            else if (key == "dangerousExts")
+            {
+                if (!value.is_array() || !std::all_of(value.begin(), value.end(),
+                                                      [](const json &e) { return e.is_string(); }))
+                    return fail(error, where, "'dangerousExts' must be a list of extensions");
+                settings.rules.dangerousExts = value.get<std::vector<std::string>>();
+            }
+            else
+            {
+                return fail(error, where, "unknown key '" + key + "'");
+            }
+        }
+        return true;
+    }
+
+    /// Rule set for the overrides, or null when nothing is overridden.
+    std::shared_ptr<const RuleSet> buildRules(const RuleOverrides &rules)
+    {
+        if (rules.empty())
+            return nullptr;
+        const RuleSet &base = currentRules();
+        return std::make_shared<const RuleSet>(rules.fileTypes ? *rules.fileTypes : base.fileTypes,
+                                               rules.dangerousExts ? *rules.dangerousExts : base.dangerousExts,
+                                               base.ignoreTokens, rules.fileTypes ? rules.routes : base.routes);
+    }
+
+    /// Turn settings and a root into a job.
+    CleanJob makeJob(const fs::path &root, JobSettings settings, std::shared_ptr<const RuleSet> rules)
+    {
+        CleanJob job;
+        job.root = root;
+        if (settings.incremental && settings.options.indexFile.empty())
+            settings.options.indexFile = defaultIndexPath(root).string();
+        job.options = std::move(settings.options);
+        job.options.interactive = false;
+        job.rules = std::move(rules);
+        return job;
+    }
+
+    bool readJsonManifest(const std::string &text, const JobSettings &defaults, std::vector<CleanJob> &jobs,
+                          std::string &error)
+    {
+        json manifest;
+        try
+        {
+            manifest = json::parse(text);
+        }
+        catch (const json::exception &e)
+        {
+            error = std::string("invalid JSON: ") + e.what();
+            return false;
+        }
+
+        JobSettings base = defaults;
+        const json *list = &manifest;
+        if (manifest.is_object())
+        {
+            for (const auto &[key, value] : manifest.items())
+                if (key != "defaults" && key != "jobs")
+                    return fail(error, "manifest", "unknown key '" + key + "'");
+            auto d = manifest.find("defaults");
+            if (d != manifest.end())
+            {
+                if (!d->is_object())
+                    return fail(error, "defaults", "must be an object");
+                if (!applyKeys(*d, base, false, "defaults", error))
+                    return false;
+            }
+            auto j = manifest.find("jobs");
+            if (j == manifest.end())
+                return fail(error, "manifest", "missing 'jobs'");
+            list = &*j;
+        }
+        if (!list->is_array())
+            return fail(error, "manifest", "'jobs' must be a list");
+
+        std::shared_ptr<const RuleSet> baseRules = buildRules(base.rules);
+        for (std::size_t i = 0; i < list->size(); ++i)
+        {
+            const json &entry = (*list)[i];
+            const std::string where = "job " + std::to_string(i + 1);
+            if (entry.is_string())
+            {
+                jobs.push_back(makeJob(entry.get<std::string>(), base, baseRules));
+                continue;
+            }
+            auto root = entry.is_object() ? entry.find("root") : entry.end();
+            if (!entry.is_object() || root == entry.end())
+                return fail(error, where, "expected a path or an object with 'root'");
+
+            JobSettings settings = base;
+            if (!applyKeys(entry, settings, true, where, error))
+                return false;
+            bool ownRules = entry.contains("fileTypes") || entry.contains("dangerousExts");
+            jobs.push_back(makeJob(root->get<std::string>(), settings,
+                                   ownRules ? buildRules(settings.rules) : baseRules));
+        }
+        return true;
+    }
+
+    /// Device a root lives on; roots on one device share its concurrency limit.
+    std::uint64_t deviceOf(const fs::path &root)
+    {
+#ifdef _WIN32
+        std::error_code ec;
+        fs::path absolute = fs::absolute(root, ec);
+        return std::hash<std::string>()(absolute.root_name().string());
+#else
+        struct stat st;
+        if (::stat(root.c_str(), &st) != 0)
+            return 0;
+        return static_cast<std::uint64_t>(st.st_dev);
+#endif
+    }
+
+    /**
+     * @brief Hands out jobs, round-robin over devices, within the per-device limit.
+     */
+    class JobQueue
+    {
+    public:
+        JobQueue(const std::vector<std::uint64_t> &devices, unsigned perDevice) : perDevice_(perDevice)
+        {
+            std::map<std::uint64_t, std::size_t> slot;
+            for (std::size_t i = 0; i < devices.size(); ++i)
+            {
+                auto [it, inserted] = slot.try_emplace(devices[i], pending_.size());
+                if (inserted)
+                    pending_.emplace_back();
+                pending_[it->second].push_back(i);
+                slotOf_.push_back(it->second);
+            }
+            active_.assign(pending_.size(), 0);
+            remaining_ = devices.size();
+        }
+
+        /// Next job to run, waiting while every device with work is at its limit.
+        bool take(std::size_t &job)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (;;)
+            {
+                if (remaining_ == 0)
+                    return false;
+                for (std::size_t k = 0; k < pending_.size(); ++k)
+                {
+                    std::size_t d = (next_ + k) % pending_.size();
+                    if (pending_[d].empty() || active_[d] >= perDevice_)
+                        continue;
+                    job = pending_[d].front();
+                    pending_[d].pop_front();
+                    ++active_[d];
+                    --remaining_;
+                    next_ = d + 1;
+                    return true;
+                }
+                ready_.wait(lock);
+            }
+        }
+
+        /// Release the device slot of a finished job.
+        void done(std::size_t job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --active_[slotOf_[job]];
+            }
+            ready_.notify_all();
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable ready_;
+        std::vector<std::deque<std::size_t>> pending_; ///< Waiting jobs, per device.
+        std::vector<unsigned> active_;                 ///< Running jobs, per device.
+        std::vector<std::size_t> slotOf_;              ///< Device slot of each job.
+        std::size_t remaining_ = 0;
+        std::size_t next_ = 0;                         ///< Device to offer first.
+        unsigned perDevice_;
+    };
+
+    /// Organize one root like `cleanFilesByType()`, without per-file output.
+    void runJob(const CleanJob &job, JobResult &result)
+    {
+        const CleanOptions &options = job.options;
+        std::error_code ec;
+        if (!fs::is_directory(job.root, ec))
+        {
+            result.error = "not a directory";
+            return;
+        }
+
+        ScanOptions scan = options.scan;
+        const RuleSet &rules = job.rules ? *job.rules : currentRules();
+        scan.classifier = &rules.classifier;
+        scan.withStat = scan.withStat || options.byDate || rules.classifier.routes().needsStat();
+        scan.withDates = options.byDate;
+        if (options.quarantine)
+            if (std::string folder = quarantineExclude(job.root, options.destination); !folder.empty())
+                scan.exclude.push_back(folder);
+        FileTable files = scanDirectoryIndexed(job.root, scan, options.indexFile);
+        result.files = files.size();
+        if (options.sniff)
+            sniffTypes(files, scan.threads);
+        if (options.byDate)
+            readCaptureDates(files, scan.threads); // files sniffed into a date category
+
+        MovePlan plan = planByType(job.root, files, options.destination, options.byDate, options.quarantine);
+        findDuplicates(plan, options.dedupe, scan.threads);
+        result.planned = plan.count(MoveStatus::Ready);
+        result.dangerous = plan.count(MoveStatus::Dangerous);
+        result.identical = plan.count(MoveStatus::Identical);
+
+        bool jsonl = options.output == OutputFormat::Jsonl;
+        if (options.dryRun)
+        {
+            result.skipped = plan.moves.size() - result.planned;
+            if (jsonl)
+            {
+                logMoves(plan, nullptr);
+                logSummary(plan, nullptr);
+            }
+        }
+        else
+        {
+            MoveResult moved = executePlan(plan, options.moveJobs, nullptr, options.ioUring);
+            result.moved = moved.moved;
+            result.skipped = moved.skipped;
+            result.failed = moved.failures.size();
+            result.linked = moved.linked;
+            result.quarantined = moved.quarantined;
+            if (jsonl)
+            {
+                logMoves(plan, &moved);
+                logSummary(plan, &moved);
+            }
+            if (!options.quarantineScan.empty())
+                QuarantineScanner(options.quarantineScan, jsonl).submit(plan, moved);
+        }
+        result.ok = true;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /// Sum of every job's counters.
+    JobResult total(const std::vector<JobResult> &results)
+    {
+        JobResult sum;
+        for (const JobResult &r : results)
+        {
+            sum.files += r.files;
+            sum.planned += r.planned;
+            sum.moved += r.moved;
+            sum.skipped += r.skipped;
+            sum.failed += r.failed;
+            sum.linked += r.linked;
+            sum.dangerous += r.dangerous;
+            sum.quarantined += r.quarantined;
+            sum.identical += r.identical;
+        }
+        return sum;
+    }
+
+    json resultJson(const JobResult &r)
+    {
+        return {{"files", r.files},         {"planned", r.planned}, {"moved", r.moved},
+                {"skipped", r.skipped},     {"failed", r.failed},   {"linked", r.linked},
+                {"dangerous", r.dangerous}, {"quarantined", r.quarantined}, {"identical", r.identical},
+                {"seconds", r.seconds}};
+    }
+
+    /// Jobs whose root could not be organized or that left failed moves behind.
+    std::size_t countFailed(const std::vector<JobResult> &results)
+    {
+        return std::count_if(results.begin(), results.end(),
+                             [](const JobResult &r) { return !r.ok || r.failed > 0; });
+    }
+}
+
+bool readJobManifest(std::istream &in, const CleanOptions &defaults, bool incremental, std::vector<CleanJob> &jobs,
+                     std::string &error)
+{
+    JobSettings base{defaults, {}, incremental};
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    auto first = text.find_first_not_of(" \t\r\n");
+    if (first != std::string::npos && (text[first] == '[' || text[first] == '{'))
+        return readJsonManifest(text, base, jobs, error);
+
+    // One path per line
+    std::istringstream lines(text);
+    for (std::string line; std::getline(lines, line);)
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        auto begin = line.find_first_not_of(" \t");
+        if (begin == std::string::npos || line[begin] == '#')
+            continue;
+        auto end = line.find_last_not_of(" \t");
+        jobs.push_back(makeJob(line.substr(begin, end - begin + 1), base, nullptr));
+    }
+    return true;
+}
+
+std::vector<JobResult> runJobs(const std::vector<CleanJob> &jobs, unsigned workers, unsigned perDevice)
+{
+    std::vector<JobResult> results(jobs.size());
+    std::vector<std::uint64_t> devices(jobs.size());
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        results[i].root = jobs[i].root;
+        devices[i] = results[i].device = deviceOf(jobs[i].root);
+    }
+    if (jobs.empty())
+        return results;
+
+    if (workers == 0)
+        workers = ThreadPool::defaultThreads();
+    workers = static_cast<unsigned>(std::min<std::size_t>(workers, jobs.size()));
+    JobQueue queue(devices, std::max(perDevice, 1u));
+    std::mutex outputMutex;
+
+    // One long-running loop per worker: jobs are taken from the queue rather
+    // than submitted, so the device limit is enforced at the moment a slot frees up
+    ThreadPool pool(workers);
+    for (unsigned w = 0; w < workers; ++w)
+        pool.submit([&] {
+            std::size_t i = 0;
+            while (queue.take(i))
+            {
+                JobResult &result = results[i];
+                auto start = std::chrono::steady_clock::now();
+                try
+                {
+                    runJob(jobs[i], result);
+                }
+                catch (const std::exception &e)
+                {
+                    result.ok = false;
+                    result.error = e.what();
+                }
+                result.seconds = secondsSince(start);
+                queue.done(i);
+
+                if (!result.ok && jobs[i].options.output == OutputFormat::Jsonl)
+                {
+                    JsonlRecord record("jobFailed");
+                    resultLog().write(record.path("root", result.root).text("error", result.error).line());
+                }
+
+                std::lock_guard<std::mutex> lock(outputMutex);
+                if (result.ok)
+                {
+                    std::cout << (result.failed ? RED : GREEN) << "[done] " << RESET << result.root.string() << ": "
+                              << result.files << " files, "
+                              << (jobs[i].options.dryRun ? result.planned : result.moved)
+                              << (jobs[i].options.dryRun ? " to move" : " moved") << ", " << result.skipped
+                              << " skipped";
+                    if (result.failed)
+                        std::cout << ", " << RED << result.failed << " failed" << RESET;
+                    std::cout << " (" << std::fixed << std::setprecision(2) << result.seconds << "s)\n";
+                }
+                else
+                    std::cerr << RED << "[failed] " << result.root.string() << ": " << result.error << RESET
+                              << "\n";
+            }
+        });
+    pool.wait();
+    return results;
+}
+
+void printJobSummary(const std::vector<JobResult> &results, double seconds, std::ostream &out)
+{
+    std::size_t failed = countFailed(results);
+    JobResult sum = total(results);
+
+    out << "\n" << CYAN << "Jobs: " << results.size() << RESET << "  " << GREEN << "OK: " << results.size() - failed
+        << RESET << "  " << (failed ? RED : RESET) << "Failed: " << failed << RESET << "  (" << std::fixed
+        << std::setprecision(2) << seconds << "s)\n";
+    out << "Files: " << sum.files << "  " << GREEN << "Moved: " << sum.moved << RESET << "  " << YELLOW
+        << "Skipped: " << sum.skipped << RESET;
+    if (sum.failed)
+        out << "  " << RED << "Failed moves: " << sum.failed << RESET;
+    if (sum.linked)
+        out << "  " << CYAN << "Linked: " << sum.linked << RESET;
+    if (sum.quarantined)
+        out << "  " << RED << "Quarantined: " << sum.quarantined << RESET;
+    if (sum.dangerous)
+        out << "  " << RED << "Dangerous: " << sum.dangerous << RESET;
+    out << "\n";
+
+    // Per-device totals show which volume the batch waited on
+    std::map<std::uint64_t, std::vector<JobResult>> byDevice;
+    for (const JobResult &r : results)
+        byDevice[r.device].push_back(r);
+    if (byDevice.size() > 1)
+    {
+        out << "\n" << std::left << std::setw(18) << "Device" << std::right << std::setw(6) << "Jobs" << std::setw(10)
+            << "Files" << std::setw(10) << "Moved" << std::setw(12) << "Busy (s)" << "\n";
+        for (const auto &[device, list] : byDevice)
+        {
+            JobResult d = total(list);
+            double busy = 0;
+            for (const JobResult &r : list)
+                busy += r.seconds;
+            std::ostringstream id;
+            id << std::hex << device;
+            out << std::left << std::setw(18) << id.str() << std::right << std::setw(6) << list.size()
+                << std::setw(10) << d.files << std::setw(10) << d.moved << std::setw(12) << std::setprecision(2)
+                << busy << "\n";
+        }
+    }
+
+    if (failed)
+    {
+        out << "\nFailed jobs:\n";
+        for (const JobResult &r : results)
+            if (!r.ok)
+                out << " - " << r.root.string() << ": " << r.error << "\n";
+            else if (r.failed)
+                out << " - " << r.root.string() << ": " << r.failed << " moves failed\n";
+    }
+}
+
+void logJobSummary(const std::vector<JobResult> &results, double seconds)
+{
+    std::size_t failed = countFailed(results);
+    JobResult sum = total(results);
+
+    JsonlRecord record("jobs");
+    record.number("jobs", results.size())
+        .number("failed", failed)
+        .number("files", sum.files)
+        .number("planned", sum.planned)
+        .number("moved", sum.moved)
+        .number("skipped", sum.skipped)
+        .number("movesFailed", sum.failed)
+        .number("linked", sum.linked)
+        .number("quarantined", sum.quarantined)
+        .number("dangerous", sum.dangerous)
+        .number("identical", sum.identical)
+        .real("seconds", seconds);
+    resultLog().write(record.line());
+}
+
+bool saveJobReport(const std::vector<JobResult> &results, double seconds, const fs::path &file)
+{
+    json jobs = json::array();
+    for (const JobResult &r : results)
+    {
+        json job = resultJson(r);
+        job["root"] = r.root.string();
+        job["device"] = r.device;
+        job["ok"] = r.ok;
+        if (!r.ok)
+            job["error"] = r.error;
+        jobs.push_back(std::move(job));
+    }
+    json report = {{"seconds", seconds}, {"totals", resultJson(total(results))}, {"jobs", std::move(jobs)}};
+    report["totals"].erase("seconds");
+
+    std::ofstream out(file);
+    out << report.dump(2) << "\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,398 @@
+/**
+ * @file journal.cpp
+ * @brief Implementation of the write-ahead move journal, resume and undo.
+ *
+ * @see journal.hpp
+ */
+
+#include "journal.hpp"
+#include "fileMove.hpp"
+#include "colors.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+    int openAppend(const fs::path &file)
+    {
+        return ::_wopen(file.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+    }
+    bool writeAll(int fd, const char *data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            int n = ::_write(fd, data, static_cast<unsigned>(size));
+            if (n <= 0)
+                return false;
+            data += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+    bool syncFd(int fd) { return ::_commit(fd) == 0; }
+    void closeFd(int fd) { ::_close(fd); }
+#else
+    int openAppend(const fs::path &file)
+    {
+        return ::open(file.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    }
+    bool writeAll(int fd, const char *data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t n = ::write(fd, data, size);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            data += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+    bool syncFd(int fd) { return ::fsync(fd) == 0; }
+    void closeFd(int fd) { ::close(fd); }
+#endif
+
+    /// Escape tabs, newlines and backslashes so a path fits in one field.
+    std::string escapePath(const fs::path &path)
+    {
+        std::string in = path.string();
+        std::string out;
+        out.reserve(in.size());
+        for (char c : in)
+        {
+            if (c == '\\')
+                out += "\\\\";
+            else if (c == '\t')
+                out += "\\t";
+            else if (c == '\n')
+                out += "\\n";
+            else
+                out += c;
+        }
+        return out;
+    }
+
+    /// Reverse of `escapePath()`.
+    fs::path unescapePath(const std::string &in)
+    {
+        std::string out;
+        out.reserve(in.size());
+        for (std::size_t i = 0; i < in.size(); ++i)
+        {
+            if (in[i] == '\\' && i + 1 < in.size())
+            {
+                char next = in[++i];
+                out += next == 't' ? '\t' : next == 'n' ? '\n' : next;
+            }
+            else
+            {
+                out += in[i];
+            }
+        }
+        return fs::path(out);
+    }
+
+    /// Parse the decimal id that follows a record tag.
+    bool parseId(const std::string &text, std::uint64_t &id)
+    {
+        if (text.empty())
+            return false;
+        id = 0;
+        for (char c : text)
+        {
+            if (c < '0' || c > '9')
+                return false;
+            id = id * 10 + static_cast<std::uint64_t>(c - '0');
+        }
+        return true;
+    }
+}
+
+MoveJournal::~MoveJournal()
+{
+    if (fd_ >= 0)
+    {
+        sync();
+        closeFd(fd_);
+    }
+}
+
+bool MoveJournal::open(const fs::path &file)
+{
+    bool ok = true;
+    std::error_code ec;
+    if (fs::exists(file, ec))
+    {
+        for (const auto &entry : readJournal(file, ok))
+            nextId_ = std::max(nextId_, entry.id + 1);
+        if (!ok)
+            return false;
+    }
+
+    fd_ = openAppend(file);
+    return fd_ >= 0;
+}
+
+void MoveJournal::append(const std::string &record)
+{
+    buffer_ += record;
+    if (buffer_.size() >= (1u << 16))
+    {
+        failed_ = !writeAll(fd_, buffer_.data(), buffer_.size()) || failed_;
+        buffer_.clear();
+    }
+}
+
+bool MoveJournal::flushLocked()
+{
+    if (fd_ < 0)
+        return false;
+    failed_ = !(buffer_.empty() || writeAll(fd_, buffer_.data(), buffer_.size())) || failed_;
+    buffer_.clear();
+    unsynced_ = 0;
+    failed_ = !syncFd(fd_) || failed_;
+    return !failed_;
+}
+
+bool MoveJournal::recordPlan(MovePlan &plan)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0 || failed_)
+        return false;
+
+    for (auto &move : plan.moves)
+    {
+        if (move.status != MoveStatus::Ready)
+            continue;
+        move.journalId = nextId_++;
+        // Absolute paths so a resume works from any working directory
+        append("P " + std::to_string(move.journalId) + "\t" +
+               escapePath(fs::absolute(move.source)) + "\t" +
+               escapePath(fs::absolute(move.destination)) + "\n");
+    }
+    return flushLocked();
+}
+
+void MoveJournal::recordDone(std::uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0 || failed_)
+        return;
+    append("D " + std::to_string(id) + "\n");
+    if (++unsynced_ >= SyncBatch)
+        flushLocked();
+}
+
+void MoveJournal::recordUndone(std::uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0 || failed_)
+        return;
+    append("U " + std::to_string(id) + "\n");
+    if (++unsynced_ >= SyncBatch)
+        flushLocked();
+}
+
+bool MoveJournal::sync()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return flushLocked();
+}
+
+std::vector<JournalEntry> readJournal(const fs::path &file, bool &ok)
+{
+    std::vector<JournalEntry> entries;
+    std::unordered_map<std::uint64_t, std::size_t> byId;
+
+    std::ifstream in(file, std::ios::binary);
+    ok = in.is_open();
+    if (!ok)
+        return entries;
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        // A torn final line (no newline yet) from a crash is ignored
+        if (in.eof())
+            break;
+        if (line.size() < 3 || line[1] != ' ')
+            continue;
+
+        std::uint64_t id = 0;
+        if (line[0] == 'P')
+        {
+            std::size_t tab1 = line.find('\t', 2);
+            std::size_t tab2 = tab1 == std::string::npos ? tab1 : line.find('\t', tab1 + 1);
+            if (tab2 == std::string::npos || !parseId(line.substr(2, tab1 - 2), id))
+                continue;
+
+            JournalEntry entry;
+            entry.id = id;
+            entry.source = unescapePath(line.substr(tab1 + 1, tab2 - tab1 - 1));
+            entry.destination = unescapePath(line.substr(tab2 + 1));
+            byId[id] = entries.size();
+            entries.push_back(std::move(entry));
+        }
+        else if ((line[0] == 'D' || line[0] == 'U') && parseId(line.substr(2), id))
+        {
+            auto it = byId.find(id);
+            if (it == byId.end())
+                continue;
+            if (line[0] == 'D')
+                entries[it->second].done = true;
+            else
+                entries[it->second].undone = true;
+        }
+    }
+    return entries;
+}
+
+void excludePath(FileTable &files, const fs::path &file)
+{
+    fs::path target = fs::absolute(file).lexically_normal();
+    std::string targetName = target.filename().string();
+    for (std::size_t i = files.size(); i-- > 0;)
+    {
+        // Cheap name check first; absolute() costs a getcwd()
+        if (files.name(i) == targetName && fs::absolute(files.path(i)).lexically_normal() == target)
+            files.erase(i);
+    }
+}
+
+MoveResult resumeJournal(const fs::path &file, unsigned jobs, bool &ok)
+{
+    MoveResult result;
+    std::vector<JournalEntry> entries = readJournal(file, ok);
+    if (!ok)
+        return result;
+
+    MoveJournal journal;
+    if (!journal.open(file))
+    {
+        ok = false;
+        return result;
+    }
+
+    // Rebuild a plan from the unfinished entries only
+    MovePlan plan;
+    std::set<fs::path> dirs;
+    for (const auto &entry : entries)
+    {
+        if (entry.done || entry.undone)
+            continue;
+
+        std::error_code ec;
+        bool sourceThere = fs::exists(entry.source, ec);
+        bool destThere = fs::exists(entry.destination, ec);
+        if (!sourceThere && destThere)
+        {
+            // Moved before the completion record reached the disk
+            journal.recordDone(entry.id);
+            ++result.moved;
+            continue;
+        }
+
+        if (!sourceThere || destThere)
+        {
+            // Source vanished, or something now occupies the destination
+            ++result.skipped;
+            result.skippedFiles.push_back(entry.source.filename());
+            continue;
+        }
+
+        PlannedMove move;
+        move.source = entry.source;
+        move.destination = entry.destination;
+        move.journalId = entry.id;
+        dirs.insert(entry.destination.parent_path());
+        plan.moves.push_back(std::move(move));
+    }
+    plan.directories.assign(dirs.begin(), dirs.end());
+
+    MoveResult remaining = executePlan(plan, jobs, &journal);
+    if (!journal.sync())
+        std::cerr << RED << "Warning: Could not update journal " << file.string() << RESET << "\n";
+
+    result.moved += remaining.moved;
+    result.skipped += remaining.skipped;
+    result.skippedFiles = std::move(remaining.skippedFiles);
+    return result;
+}
+
+MoveResult undoJournal(const fs::path &file, bool &ok)
+{
+    MoveResult result;
+    std::vector<JournalEntry> entries = readJournal(file, ok);
+    if (!ok)
+        return result;
+
+    MoveJournal journal;
+    if (!journal.open(file))
+    {
+        ok = false;
+        return result;
+    }
+
+    std::set<fs::path> createdDirs;
+    std::set<fs::path> touchedDirs;
+
+    // Newest first, so chains of moves unwind in the right order
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+    {
+        if (!it->done || it->undone)
+            continue;
+
+        std::error_code ec;
+        if (fs::exists(it->source, ec) || !fs::exists(it->destination, ec))
+        {
+            ++result.skipped;
+            result.skippedFiles.push_back(it->destination.filename());
+            continue;
+        }
+
+        fs::path sourceDir = it->source.parent_path();
+        if (createdDirs.insert(sourceDir).second)
+            fs::create_directories(sourceDir, ec);
+
+        if (std::error_code moveEc = moveFile(it->destination, it->source))
+        {
+            std::cerr << RED << "Failed to restore " << it->destination
+                      << " -> " << it->source << ": " << moveEc.message() << RESET << "\n";
+            ++result.skipped;
+            result.skippedFiles.push_back(it->destination.filename());
+            continue;
+        }
+
+        journal.recordUndone(it->id);
+        touchedDirs.insert(it->destination.parent_path());
+        ++result.moved;
+    }
+    if (!journal.sync())
+        std::cerr << RED << "Warning: Could not update journal " << file.string() << RESET << "\n";
+
+    // Remove category folders the run created and that are now empty
+    for (const auto &dir : touchedDirs)
+    {
+        std::error_code ec;
+        if (fs::is_empty(dir, ec) && !ec)
+            fs::remove(dir, ec);
+    }
+    return result;
+}
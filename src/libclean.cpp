@@ -0,0 +1,200 @@
+/**
+ * @file libclean.cpp
+ * @brief Implementation of `CleanSession`, the embeddable API.
+ *
+ * @see libclean.hpp
+ */
+
+#include "libclean.hpp"
+#include "journal.hpp"
+#include "mediaDate.hpp"
+#include "namePlan.hpp"
+#include "quarantine.hpp"
+#include "scanIndex.hpp"
+#include "sniffer.hpp"
+
+CleanSession::CleanSession(unsigned threads) : rules_(&currentRules()), pool_(threads)
+{
+}
+
+const RuleSet &CleanSession::rules() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return *rules_;
+}
+
+bool CleanSession::reloadRules()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool changed = reloadRulesIfChanged();
+    rules_ = &currentRules();
+    return changed;
+}
+
+ScanResult CleanSession::scanLocked(const fs::path &root, const CleanOptions &options, ScanOptions scan,
+                                    ProgressReporter &progress)
+{
+    ScanResult result;
+    std::error_code ec;
+    if (!fs::is_directory(root, ec))
+    {
+        result.error = "not a directory: " + root.string();
+        return result;
+    }
+
+    // The warm pool serves every scan that does not ask for another size
+    scan.classifier = &rules_->classifier;
+    scan.progress = &progress;
+    scan.pool = scan.threads == 0 || scan.threads == pool_.size() ? &pool_ : nullptr;
+    if (scan.threads == 0)
+        scan.threads = pool_.size(); // later stages spread over as many workers
+
+    progress.start(ProgressPhase::Scan);
+    result.files = scanDirectoryIndexed(root, scan, options.indexFile);
+    if (!options.journalFile.empty())
+        excludePath(result.files, options.journalFile); // never organize our own journal
+    progress.finish();
+    result.cancelled = progress.cancelled();
+    return result;
+}
+
+ScanResult CleanSession::scan(const fs::path &root, const CleanOptions &options, const RunControl &control)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ProgressReporter progress(control.progress, control.cancel, control.interval);
+    return scanLocked(root, options, options.scan, progress);
+}
+
+PlanResult CleanSession::planType(const fs::path &root, const CleanOptions &options, const RunControl &control)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ProgressReporter progress(control.progress, control.cancel, control.interval);
+    PlanResult result;
+
+    ScanOptions scan = options.scan;
+    scan.withStat = scan.withStat || rules_->classifier.routes().needsStat(); // size/age routing rules
+    scan.withStat = scan.withStat || options.byDate;                         // mtime fallback of the date layout
+    scan.withDates = options.byDate;
+    if (options.quarantine)
+        if (std::string folder = quarantineExclude(root, options.destination); !folder.empty())
+            scan.exclude.push_back(folder); // quarantined files are never listed again
+    ScanResult scanned = scanLocked(root, options, scan, progress);
+    static_cast<CallStatus &>(result) = scanned;
+    result.files = scanned.files.size();
+    if (!result.ok())
+        return result;
+
+    unsigned threads = scan.threads == 0 ? pool_.size() : scan.threads;
+    FileTable &files = scanned.files;
+    if (options.sniff)
+        sniffTypes(files, threads);
+    if (options.byDate)
+        readCaptureDates(files, threads); // files sniffed into a date category
+    result.cancelled = progress.cancelled();
+    if (result.cancelled)
+        return result;
+
+    progress.start(ProgressPhase::Plan, files.size());
+    result.plan = planByType(root, files, options.destination, options.byDate, options.quarantine);
+    result.dedupe = findDuplicates(result.plan, options.dedupe, threads);
+    progress.advance(files.size());
+    progress.finish();
+    return result;
+}
+
+PlanResult CleanSession::planName(const fs::path &root, const CleanOptions &options, const RunControl &control)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ProgressReporter progress(control.progress, control.cancel, control.interval);
+    PlanResult result;
+
+    ScanResult scanned = scanLocked(root, options, options.scan, progress);
+    static_cast<CallStatus &>(result) = scanned;
+    result.files = scanned.files.size();
+    if (!result.ok())
+        return result;
+
+    std::vector<std::string> tokens;
+    if (!options.token.empty())
+        tokens.push_back(options.token);
+    tokens.insert(tokens.end(), options.tokens.begin(), options.tokens.end());
+
+    unsigned threads = options.scan.threads == 0 ? pool_.size() : options.scan.threads;
+    progress.start(ProgressPhase::Plan, scanned.files.size());
+    result.plan = planByName(root, scanned.files, tokens, rules_->ignoreTokens, options.destination,
+                             options.matchPolicy, options.fuzzy, threads);
+    result.dedupe = findDuplicates(result.plan, options.dedupe, threads);
+    progress.advance(scanned.files.size());
+    progress.finish();
+    return result;
+}
+
+ExecuteResult CleanSession::execute(MovePlan &plan, const CleanOptions &options, const RunControl &control)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ProgressReporter progress(control.progress, control.cancel, control.interval);
+    ExecuteResult result;
+
+    // Write-ahead: record the plan durably before the first move
+    MoveJournal journal;
+    bool journaled = false;
+    if (!options.journalFile.empty())
+    {
+        journaled = journal.open(options.journalFile) && journal.recordPlan(plan);
+        if (!journaled)
+        {
+            result.error = "Could not write journal " + options.journalFile;
+            return result;
+        }
+    }
+
+    result.moves = executePlan(plan, options.moveJobs, journaled ? &journal : nullptr, options.ioUring, &progress);
+    result.cancelled = result.moves.cancelled;
+    result.journalFailed = journaled && !journal.sync();
+    if (!options.quarantineScan.empty())
+        QuarantineScanner(options.quarantineScan, options.output == OutputFormat::Jsonl)
+            .submit(plan, result.moves); // waits for the scans
+    return result;
+}
+
+ListResult CleanSession::list(const fs::path &root, const CleanOptions &options, const RunControl &control)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ProgressReporter progress(control.progress, control.cancel, control.interval);
+    ListResult result;
+
+    ScanOptions scan = options.scan;
+    scan.withStat = true;
+    ScanResult scanned = scanLocked(root, options, scan, progress);
+    static_cast<CallStatus &>(result) = scanned;
+    result.files = std::move(scanned.files);
+    if (!result.error.empty())
+        return result;
+
+    const ExtClassifier &classifier = rules_->classifier;
+    std::vector<CategoryTotal> totals(classifier.categoryCount());
+    for (std::size_t i = 0; i < result.files.size(); ++i)
+    {
+        const FileRecord &record = result.files[i];
+        CategoryTotal &total = totals[record.category];
+        ++total.files;
+        if (record.flags & FileRecord::HasStat)
+        {
+            total.bytes += record.size;
+            result.bytes += record.size;
+        }
+    }
+    for (CategoryId id = 0; id < classifier.categoryCount(); ++id)
+        if (totals[id].files)
+        {
+            totals[id].name = classifier.categoryName(id);
+            result.categories.push_back(std::move(totals[id]));
+        }
+    return result;
+}
+
+CleanSession &sharedSession()
+{
+    static CleanSession session;
+    return session;
+}
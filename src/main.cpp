@@ -26,6 +26,7 @@
 #include "../include/clean/cleanByType.hpp"    ///< File cleaning by type implementation
 #include "../include/clean/cleanByName.hpp"    ///< File cleaning by name implementation
 #include "../include/dangerousExts.hpp"       ///< Dangerous file extension detection
+#include "../include/cli.hpp"                 ///< Non-interactive command line mode
 /// @endcond
 
 namespace fs = std::filesystem;  ///< Alias for std::filesystem namespace
@@ -102,12 +103,21 @@ void byName(const fs::path &directoryPath);
 /**
  * @brief Application entry point.
  *
+ * @param argc Argument count.
+ * @param argv Argument vector.
  * @return int Exit status code (0 on success).
  *
- * @details Initializes the application by calling the main operation menu.
- *          The program remains in the menu loop until the user chooses to exit.
+ * @details When arguments are given the request is handled by the
+ *          non-interactive command line mode (see runCli()). Otherwise the
+ *          application starts the main operation menu and remains in the
+ *          menu loop until the user chooses to exit.
  */
-int main(){
+int main(int argc, char *argv[]){
+
+    initColors();
+
+    if (argc > 1)
+        return runCli(argc, argv);
 
     operation();
 
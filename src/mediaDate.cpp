@@ -0,0 +1,447 @@
+/**
+ * @file mediaDate.cpp
+ * @brief Implementation of the EXIF and MP4 / QuickTime capture date reader.
+ *
+ * @see mediaDate.hpp
+ */
+
+#include "mediaDate.hpp"
+#include "stats.hpp"
+#include "threadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std::string_view_literals;
+
+namespace
+{
+    /// Batches smaller than this are read on the calling thread.
+    constexpr std::size_t ParallelThreshold = 16;
+
+    /// Files handed to a worker at a time.
+    constexpr std::size_t Chunk = 64;
+
+    /// Seconds from the MP4 epoch (1904-01-01 UTC) to the Unix epoch.
+    constexpr std::int64_t Mp4EpochOffset = 2082844800;
+
+    /// Boxes visited per level before giving up on an MP4 / QuickTime file.
+    constexpr int MaxBoxes = 64;
+
+    constexpr std::int64_t None = FileTable::DateNone;
+
+    /// Read-only file for positioned reads; closed on destruction.
+    class HeaderFile
+    {
+    public:
+        explicit HeaderFile(const fs::path &file)
+        {
+#ifdef _WIN32
+            handle_ = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+#else
+            // Non-blocking so a file swapped for a FIFO after the scan cannot stall the run
+            fd_ = ::open(file.c_str(), O_RDONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK);
+#endif
+        }
+
+        ~HeaderFile()
+        {
+#ifdef _WIN32
+            if (handle_ != INVALID_HANDLE_VALUE)
+                CloseHandle(handle_);
+#else
+            if (fd_ >= 0)
+                ::close(fd_);
+#endif
+        }
+
+        HeaderFile(const HeaderFile &) = delete;
+        HeaderFile &operator=(const HeaderFile &) = delete;
+
+#ifdef _WIN32
+        bool ok() const { return handle_ != INVALID_HANDLE_VALUE; }
+#else
+        bool ok() const { return fd_ >= 0; }
+#endif
+
+        /// Read up to `n` bytes at `offset`; returns the bytes read or -1.
+        long read(std::uint64_t offset, char *buffer, std::size_t n)
+        {
+            runStats().addCalls(Phase::Metadata);
+#ifdef _WIN32
+            OVERLAPPED at{};
+            at.Offset = static_cast<DWORD>(offset);
+            at.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD got = 0;
+            if (!ReadFile(handle_, buffer, static_cast<DWORD>(n), &got, &at))
+                return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+            return static_cast<long>(got);
+#else
+            return static_cast<long>(::pread(fd_, buffer, n, static_cast<off_t>(offset)));
+#endif
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE handle_ = INVALID_HANDLE_VALUE;
+#else
+        int fd_ = -1;
+#endif
+    };
+
+    /// Bounds-checked integer access to a header buffer.
+    struct Bytes
+    {
+        std::string_view data;
+        bool little = false;
+
+        bool has(std::uint64_t offset, std::uint64_t n) const
+        {
+            return offset <= data.size() && n <= data.size() - offset;
+        }
+
+        std::uint64_t get(std::size_t offset, int n) const
+        {
+            std::uint64_t v = 0;
+            for (int k = 0; k < n; ++k)
+            {
+                auto byte = static_cast<unsigned char>(data[offset + (little ? n - 1 - k : k)]);
+                v = (v << 8) | byte;
+            }
+            return v;
+        }
+
+        std::uint16_t u16(std::size_t offset) const { return static_cast<std::uint16_t>(get(offset, 2)); }
+        std::uint32_t u32(std::size_t offset) const { return static_cast<std::uint32_t>(get(offset, 4)); }
+        std::uint64_t u64(std::size_t offset) const { return get(offset, 8); }
+    };
+
+    /// Parse an EXIF "YYYY:MM:DD HH:MM:SS" local time.
+    std::int64_t parseExifTime(std::string_view text)
+    {
+        int fields[6];
+        const std::size_t starts[6] = {0, 5, 8, 11, 14, 17};
+        const int widths[6] = {4, 2, 2, 2, 2, 2};
+        for (int f = 0; f < 6; ++f)
+        {
+            int value = 0;
+            for (int k = 0; k < widths[f]; ++k)
+            {
+                char c = text[starts[f] + k];
+                if (c < '0' || c > '9')
+                    return None;
+                value = value * 10 + (c - '0');
+            }
+            fields[f] = value;
+        }
+        if (fields[0] < 1900 || fields[1] < 1 || fields[1] > 12 || fields[2] < 1 || fields[2] > 31)
+            return None; // e.g. "0000:00:00 00:00:00" from cameras without a clock
+
+        std::tm tm{};
+        tm.tm_year = fields[0] - 1900;
+        tm.tm_mon = fields[1] - 1;
+        tm.tm_mday = fields[2];
+        tm.tm_hour = fields[3];
+        tm.tm_min = fields[4];
+        tm.tm_sec = fields[5];
+        tm.tm_isdst = -1;
+        std::time_t t = std::mktime(&tm);
+        return t == static_cast<std::time_t>(-1) ? None : static_cast<std::int64_t>(t);
+    }
+
+    /// Capture time from a TIFF structure (EXIF payload or TIFF-based raw file).
+    std::int64_t tiffTime(std::string_view tiff)
+    {
+        Bytes b{tiff};
+        if (!b.has(0, 8))
+            return None;
+        if (tiff.substr(0, 2) == "II"sv)
+            b.little = true;
+        else if (tiff.substr(0, 2) != "MM"sv)
+            return None;
+        if (b.u16(2) != 42)
+            return None;
+
+        std::string_view original, digitized, modified;
+        std::uint32_t exifIfd = 0;
+        auto readIfd = [&](std::uint32_t offset, bool exif) {
+            if (!b.has(offset, 2))
+                return;
+            std::uint16_t count = b.u16(offset);
+            for (std::uint32_t n = 0; n < count; ++n)
+            {
+                std::uint64_t entry = offset + 2 + n * 12ull;
+                if (!b.has(entry, 12))
+                    return;
+                std::uint16_t tag = b.u16(entry);
+                std::uint16_t type = b.u16(entry + 2);
+                std::uint32_t values = b.u32(entry + 4);
+                std::uint32_t value = b.u32(entry + 8);
+                if (!exif && tag == 0x8769 && (type == 4 || type == 13))
+                    exifIfd = value;
+                else if (type == 2 && values >= 19 && b.has(value, 19)) // ASCII, stored at `value`
+                {
+                    std::string_view text = tiff.substr(value, 19);
+                    if (!exif && tag == 0x0132)
+                        modified = text;
+                    else if (exif && tag == 0x9003)
+                        original = text;
+                    else if (exif && tag == 0x9004)
+                        digitized = text;
+                }
+            }
+        };
+        readIfd(b.u32(4), false);
+        if (exifIfd)
+            readIfd(exifIfd, true);
+
+        for (std::string_view text : {original, digitized, modified})
+            if (!text.empty())
+                if (std::int64_t t = parseExifTime(text); t != None)
+                    return t;
+        return None;
+    }
+
+    /// Capture time from the EXIF APP1 segment of a JPEG.
+    std::int64_t jpegTime(std::string_view head)
+    {
+        Bytes b{head};
+        std::uint64_t pos = 2;
+        while (b.has(pos, 4))
+        {
+            if (static_cast<unsigned char>(head[pos]) != 0xFF)
+                return None;
+            auto marker = static_cast<unsigned char>(head[pos + 1]);
+            if (marker == 0xFF || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+            {
+                pos += marker == 0xFF ? 1 : 2; // fill byte or standalone marker
+                continue;
+            }
+            if (marker == 0xDA || marker == 0xD9)
+                break; // image data starts: no more metadata
+            std::uint16_t length = b.u16(pos + 2);
+            if (length < 8)
+                break;
+            if (marker == 0xE1 && b.has(pos + 4, 6) && head.substr(pos + 4, 6) == "Exif\0\0"sv)
+                return tiffTime(head.substr(pos + 10, length - 8u));
+            pos += 2u + length;
+        }
+        return None;
+    }
+
+    /// Capture time from the `eXIf` chunk of a PNG.
+    std::int64_t pngTime(std::string_view head)
+    {
+        Bytes b{head};
+        std::uint64_t pos = 8;
+        while (b.has(pos, 8))
+        {
+            std::uint32_t length = b.u32(pos);
+            std::string_view type = head.substr(pos + 4, 4);
+            if (type == "eXIf"sv)
+                return tiffTime(head.substr(pos + 8, length));
+            if (type == "IDAT"sv || type == "IEND"sv)
+                break;
+            pos += 12ull + length;
+        }
+        return None;
+    }
+
+    /**
+     * @brief Find a box among the boxes in `[begin, end)`, one read per box header.
+     *
+     * @return bool True with the box payload in `payload` / `payloadSize`.
+     */
+    bool findBox(HeaderFile &file, std::uint64_t begin, std::uint64_t end, std::string_view type,
+                 std::uint64_t &payload, std::uint64_t &payloadSize)
+    {
+        std::uint64_t offset = begin;
+        for (int n = 0; n < MaxBoxes && offset + 8 <= end; ++n)
+        {
+            char header[16];
+            long got = file.read(offset, header, sizeof header);
+            if (got < 8)
+                return false;
+            Bytes b{std::string_view(header, static_cast<std::size_t>(got))};
+            std::uint64_t size = b.u32(0);
+            std::uint64_t headerSize = 8;
+            if (size == 1)
+            {
+                if (got < 16)
+                    return false;
+                size = b.u64(8);
+                headerSize = 16;
+            }
+            else if (size == 0)
+            {
+                size = end - offset; // extends to the end of the parent
+            }
+            if (size < headerSize || size > end - offset)
+                return false;
+            if (std::string_view(header + 4, 4) == type)
+            {
+                payload = offset + headerSize;
+                payloadSize = size - headerSize;
+                return true;
+            }
+            offset += size;
+        }
+        return false;
+    }
+
+    /// Creation time from `moov/mvhd` of an MP4 / QuickTime file.
+    std::int64_t movieTime(HeaderFile &file)
+    {
+        constexpr std::uint64_t Unbounded = ~std::uint64_t(0) >> 1;
+        std::uint64_t moov = 0, moovSize = 0, mvhd = 0, mvhdSize = 0;
+        if (!findBox(file, 0, Unbounded, "moov"sv, moov, moovSize) ||
+            !findBox(file, moov, moov + moovSize, "mvhd"sv, mvhd, mvhdSize))
+            return None;
+
+        char body[20];
+        long got = file.read(mvhd, body, sizeof body);
+        if (got < 8)
+            return None;
+        Bytes b{std::string_view(body, static_cast<std::size_t>(got))};
+        std::uint64_t created = 0;
+        if (body[0] == 1 && b.has(4, 8))
+            created = b.u64(4);
+        else if (body[0] == 0)
+            created = b.u32(4);
+        if (created <= static_cast<std::uint64_t>(Mp4EpochOffset) || created > (std::uint64_t(1) << 40))
+            return None; // unset (0) or not plausible
+        return static_cast<std::int64_t>(created) - Mp4EpochOffset;
+    }
+
+    /// `readCaptureTime()` with a caller-provided head buffer of `CaptureHeadSize` bytes.
+    std::int64_t captureTime(const fs::path &path, char *buffer)
+    {
+        HeaderFile file(path);
+        if (!file.ok())
+            return None;
+        long got = file.read(0, buffer, CaptureHeadSize);
+        if (got < 8)
+            return None;
+        std::string_view head(buffer, static_cast<std::size_t>(got));
+
+        if (head.substr(0, 2) == "\xFF\xD8"sv)
+            return jpegTime(head);
+        if (head.substr(0, 4) == "II*\0"sv || head.substr(0, 4) == "MM\0*"sv)
+            return tiffTime(head);
+        if (head.substr(0, 8) == "\x89PNG\r\n\x1A\n"sv)
+            return pngTime(head);
+        std::string_view box = head.substr(4, 4);
+        if (box == "ftyp"sv || box == "moov"sv || box == "mdat"sv || box == "wide"sv || box == "free"sv ||
+            box == "skip"sv)
+            return movieTime(file);
+        return None;
+    }
+
+    /// Unix seconds of a file-clock modification time.
+    std::int64_t unixSeconds(std::int64_t fileNanos)
+    {
+        auto fileTime = fs::file_time_type(
+            std::chrono::duration_cast<fs::file_time_type::duration>(std::chrono::nanoseconds(fileNanos)));
+        auto sys = fs::file_time_type::clock::to_sys(fileTime);
+        return std::chrono::duration_cast<std::chrono::seconds>(sys.time_since_epoch()).count();
+    }
+}
+
+bool isDateCategory(std::string_view category)
+{
+    return category == "Images"sv || category == "Videos"sv;
+}
+
+std::int64_t readCaptureTime(const fs::path &file)
+{
+    std::vector<char> buffer(CaptureHeadSize);
+    return captureTime(file, buffer.data());
+}
+
+std::size_t readCaptureDates(FileTable &files, unsigned threads)
+{
+    PhaseTimer timer(Phase::Metadata);
+    const ExtClassifier &classifier = files.classifier();
+    std::vector<char> dated(classifier.categoryCount(), 0);
+    for (CategoryId id = 0; id < classifier.categoryCount(); ++id)
+        dated[id] = isDateCategory(classifier.categoryName(id));
+
+    // Only photos and videos not read before (in this run or an indexed one) are opened
+    std::vector<std::size_t> candidates;
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        const FileRecord &r = files[i];
+        if (!dated[r.category] || (r.flags & FileRecord::Dangerous) || files.captured(i) != FileTable::DateUnread)
+            continue;
+        if ((r.flags & FileRecord::HasStat) && r.size == 0)
+        {
+            files.setCaptured(i, None); // nothing to read
+            continue;
+        }
+        candidates.push_back(i);
+    }
+    runStats().addItems(Phase::Metadata, candidates.size());
+    if (candidates.empty())
+        return 0;
+
+    // Allocates the side array up front, so workers only write their own slots
+    files.setCaptured(candidates.front(), FileTable::DateUnread);
+
+    auto readRange = [&](std::size_t begin, std::size_t end) {
+        std::vector<char> buffer(CaptureHeadSize);
+        for (std::size_t c = begin; c < end; ++c)
+            files.setCaptured(candidates[c], captureTime(files.path(candidates[c]), buffer.data()));
+    };
+
+    if (threads == 0)
+        threads = ThreadPool::defaultThreads();
+    threads = std::min(threads, MaxCaptureReaders);
+    if (threads <= 1 || candidates.size() < ParallelThreshold)
+    {
+        readRange(0, candidates.size());
+        return candidates.size();
+    }
+
+    ThreadPool pool(static_cast<unsigned>(std::min<std::size_t>(threads, (candidates.size() + Chunk - 1) / Chunk)));
+    for (std::size_t begin = 0; begin < candidates.size(); begin += Chunk)
+    {
+        std::size_t end = std::min(begin + Chunk, candidates.size());
+        pool.submit([&, begin, end] { readRange(begin, end); });
+    }
+    pool.wait();
+    return candidates.size();
+}
+
+bool captureMonth(const FileTable &files, std::size_t i, int &year, int &month)
+{
+    std::int64_t seconds = files.captured(i);
+    if (seconds == FileTable::DateUnread || seconds == FileTable::DateNone)
+    {
+        if (!(files[i].flags & FileRecord::HasStat))
+            return false;
+        seconds = unixSeconds(files[i].mtime);
+    }
+
+    std::time_t t = static_cast<std::time_t>(seconds);
+    std::tm tm{};
+#ifdef _WIN32
+    if (localtime_s(&tm, &t) != 0)
+        return false;
+#else
+    if (!localtime_r(&t, &tm))
+        return false;
+#endif
+    year = tm.tm_year + 1900;
+    month = tm.tm_mon + 1;
+    return true;
+}
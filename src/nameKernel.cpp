@@ -0,0 +1,260 @@
+/**
+ * @file nameKernel.cpp
+ * @brief Implementation of the vectorized file-name kernels.
+ *
+ * Every variant provides the same two block operations on `Width` bytes:
+ * `foldBlock()` lowercases a block and returns a bit mask of its separator
+ * bytes (bit `k` for byte `k`), `dotMask()` returns the mask of its dots.
+ * The drivers below walk those masks and finish the bytes that do not fill
+ * a block with the scalar code.
+ *
+ * @see nameKernel.hpp
+ */
+
+#include "nameKernel.hpp"
+#include "tokenIndex.hpp"
+
+#include <bit>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CLEAN_NAME_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CLEAN_NAME_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CLEAN_NAME_NEON 1
+#endif
+
+namespace
+{
+    unsigned char foldByte(unsigned char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c | 0x20) : c;
+    }
+
+    /// Whether an already folded byte belongs to a token.
+    bool isTokenByte(unsigned char c, bool highIsToken)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (highIsToken && c >= 0x80);
+    }
+
+#if defined(CLEAN_NAME_AVX2)
+
+    constexpr std::size_t Width = 32;
+    using Mask = std::uint32_t;
+
+    /// Bytes in [lo, lo + count): shifted so the range starts at -128, then one signed compare.
+    __m256i inRange(__m256i v, char lo, char count)
+    {
+        __m256i shifted = _mm256_add_epi8(v, _mm256_set1_epi8(static_cast<char>(-128 - lo)));
+        return _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(-128 + count)), shifted);
+    }
+
+    Mask foldBlock(const char *src, char *dst, bool highIsToken)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+        v = _mm256_or_si256(v, _mm256_and_si256(inRange(v, 'A', 26), _mm256_set1_epi8(0x20)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), v);
+        __m256i token = _mm256_or_si256(inRange(v, 'a', 26), inRange(v, '0', 10));
+        if (highIsToken)
+            token = _mm256_or_si256(token, _mm256_cmpgt_epi8(_mm256_setzero_si256(), v));
+        return ~static_cast<Mask>(_mm256_movemask_epi8(token));
+    }
+
+    Mask dotMask(const char *p)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        return static_cast<Mask>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('.'))));
+    }
+
+#elif defined(CLEAN_NAME_SSE2)
+
+    constexpr std::size_t Width = 16;
+    using Mask = std::uint32_t;
+
+    /// Bytes in [lo, lo + count): shifted so the range starts at -128, then one signed compare.
+    __m128i inRange(__m128i v, char lo, char count)
+    {
+        __m128i shifted = _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(-128 - lo)));
+        return _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(-128 + count)));
+    }
+
+    Mask foldBlock(const char *src, char *dst, bool highIsToken)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        v = _mm_or_si128(v, _mm_and_si128(inRange(v, 'A', 26), _mm_set1_epi8(0x20)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), v);
+        __m128i token = _mm_or_si128(inRange(v, 'a', 26), inRange(v, '0', 10));
+        if (highIsToken)
+            token = _mm_or_si128(token, _mm_cmplt_epi8(v, _mm_setzero_si128()));
+        return static_cast<Mask>(_mm_movemask_epi8(token)) ^ 0xFFFFu;
+    }
+
+    Mask dotMask(const char *p)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        return static_cast<Mask>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('.'))));
+    }
+
+#elif defined(CLEAN_NAME_NEON)
+
+    constexpr std::size_t Width = 16;
+    using Mask = std::uint32_t;
+
+    /// One bit per byte of a compare result (NEON has no movemask).
+    Mask movemask(uint8x16_t bytes)
+    {
+        static const std::uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+        uint8x16_t bits = vandq_u8(bytes, vld1q_u8(weights));
+        uint8x8_t sum = vpadd_u8(vget_low_u8(bits), vget_high_u8(bits));
+        sum = vpadd_u8(sum, sum);
+        sum = vpadd_u8(sum, sum);
+        return vget_lane_u16(vreinterpret_u16_u8(sum), 0);
+    }
+
+    uint8x16_t inRange(uint8x16_t v, std::uint8_t lo, std::uint8_t count)
+    {
+        return vcltq_u8(vsubq_u8(v, vdupq_n_u8(lo)), vdupq_n_u8(count));
+    }
+
+    Mask foldBlock(const char *src, char *dst, bool highIsToken)
+    {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const std::uint8_t *>(src));
+        v = vorrq_u8(v, vandq_u8(inRange(v, 'A', 26), vdupq_n_u8(0x20)));
+        vst1q_u8(reinterpret_cast<std::uint8_t *>(dst), v);
+        uint8x16_t token = vorrq_u8(inRange(v, 'a', 26), inRange(v, '0', 10));
+        if (highIsToken)
+            token = vorrq_u8(token, vcgeq_u8(v, vdupq_n_u8(0x80)));
+        return movemask(token) ^ 0xFFFFu;
+    }
+
+    Mask dotMask(const char *p)
+    {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const std::uint8_t *>(p));
+        return movemask(vceqq_u8(v, vdupq_n_u8('.')));
+    }
+
+#endif
+
+    /**
+     * @brief Fold `n` bytes into `dst` and call `onSeparator(i)` for every separator.
+     */
+    template <typename Fn>
+    void foldSplit(const char *src, std::size_t n, char *dst, bool highIsToken, Fn &&onSeparator)
+    {
+        std::size_t i = 0;
+#if defined(CLEAN_NAME_AVX2) || defined(CLEAN_NAME_SSE2) || defined(CLEAN_NAME_NEON)
+        for (; i + Width <= n; i += Width)
+        {
+            for (Mask m = foldBlock(src + i, dst + i, highIsToken); m != 0; m &= m - 1)
+                onSeparator(i + static_cast<std::size_t>(std::countr_zero(m)));
+        }
+#endif
+        for (; i < n; ++i)
+        {
+            unsigned char c = foldByte(static_cast<unsigned char>(src[i]));
+            dst[i] = static_cast<char>(c);
+            if (!isTokenByte(c, highIsToken))
+                onSeparator(i);
+        }
+    }
+}
+
+const char *nameKernelIsa()
+{
+#if defined(CLEAN_NAME_AVX2)
+    return "avx2";
+#elif defined(CLEAN_NAME_SSE2)
+    return "sse2";
+#elif defined(CLEAN_NAME_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+void foldAscii(const char *src, std::size_t n, char *dst)
+{
+    foldSplit(src, n, dst, false, [](std::size_t) {});
+}
+
+std::size_t findLastDot(std::string_view name)
+{
+    const char *p = name.data();
+    std::size_t n = name.size();
+#if defined(CLEAN_NAME_AVX2) || defined(CLEAN_NAME_SSE2) || defined(CLEAN_NAME_NEON)
+    if (n >= Width)
+    {
+        // Blocks from the end; the last one overlaps bytes already seen, which hold no dot
+        for (std::size_t end = n;;)
+        {
+            std::size_t start = end >= Width ? end - Width : 0;
+            if (Mask m = dotMask(p + start))
+                return start + static_cast<std::size_t>(std::bit_width(m)) - 1;
+            if (start == 0)
+                return std::string_view::npos;
+            end = start;
+        }
+    }
+#endif
+    while (n > 0)
+        if (p[--n] == '.')
+            return n;
+    return std::string_view::npos;
+}
+
+std::uint16_t extensionLength(std::string_view name)
+{
+    std::size_t dot = findLastDot(name);
+    if (dot == std::string_view::npos || dot == 0 || name == "..")
+        return 0;
+    return static_cast<std::uint16_t>(name.size() - dot);
+}
+
+void foldStems(const FileTable &files, std::size_t begin, std::size_t end, bool fold, NameBatch &batch)
+{
+    batch.text.clear();
+    batch.nameStart.clear();
+    batch.tokens.clear();
+    batch.tokenStart.clear();
+    batch.split.clear();
+
+    std::size_t total = 0;
+    for (std::size_t f = begin; f < end; ++f)
+        total += files.stem(f).size();
+    batch.text.reserve(fold ? total + total / 2 : total);
+
+    std::string folded; // foldName() output of the current stem
+    for (std::size_t f = begin; f < end; ++f)
+    {
+        std::string_view stem = files.stem(f);
+        if (fold)
+        {
+            foldName(stem, folded);
+            stem = folded;
+        }
+
+        auto at = static_cast<std::uint32_t>(batch.text.size());
+        batch.nameStart.push_back(at);
+        batch.tokenStart.push_back(static_cast<std::uint32_t>(batch.tokens.size()));
+        batch.text.resize(at + stem.size());
+
+        std::uint32_t start = 0;
+        bool split = false;
+        auto cut = [&](std::size_t i) {
+            auto stop = static_cast<std::uint32_t>(i);
+            if (stop > start)
+                batch.tokens.push_back({at + start, stop - start});
+            start = stop + 1;
+            split = true;
+        };
+        foldSplit(stem.data(), stem.size(), batch.text.data() + at, fold, cut);
+        if (static_cast<std::uint32_t>(stem.size()) > start)
+            batch.tokens.push_back({at + start, static_cast<std::uint32_t>(stem.size()) - start});
+        batch.split.push_back(split ? 1 : 0);
+    }
+    batch.nameStart.push_back(static_cast<std::uint32_t>(batch.text.size()));
+    batch.tokenStart.push_back(static_cast<std::uint32_t>(batch.tokens.size()));
+}
@@ -0,0 +1,97 @@
+/**
+ * @file namePlan.cpp
+ * @brief Implementation of `planByName()`.
+ *
+ * @see namePlan.hpp
+ */
+
+#include "namePlan.hpp"
+#include "stats.hpp"
+#include "tokenCluster.hpp"
+#include "tokenIndex.hpp"
+
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+
+MovePlan planByName(const fs::path &root, const FileTable &files, const std::vector<std::string> &tokens,
+                    const std::vector<std::string> &ignoreTokens, const fs::path &destRoot, MatchPolicy policy, bool fuzzy, unsigned threads)
+{
+    // Matching and planning count as the classify phase (ends after finalizePlan)
+    PhaseTimer timer(Phase::Classify);
+    runStats().addItems(Phase::Classify, files.size());
+
+    MovePlan plan;
+    plan.root = root;
+    plan.destRoot = destRoot.empty() ? root : destRoot;
+
+    // Explicit names, matched in one pass per file
+    if (!tokens.empty())
+    {
+        TokenMatcher matcher(tokens, policy);
+
+        // Destination directories named after each name (sanitized), built once
+        std::vector<std::string> dirNames;
+        std::vector<fs::path> destDirs;
+        for (const auto &token : tokens)
+        {
+            std::string dirName = token;
+            for (auto &c : dirName)
+                if (c == '/' || c == '\\')
+                    c = '_'; // replace slashes with underscores
+            destDirs.push_back(plan.destRoot / dirName);
+            dirNames.push_back(std::move(dirName));
+        }
+
+        for (std::size_t f = 0; f < files.size(); ++f)
+        {
+            std::uint32_t matched = matcher.match(files.name(f));
+            if (matched != TokenMatcher::NoMatch)
+                addMove(plan, files.path(f), destDirs[matched], dirNames[matched]);
+        }
+        finalizePlan(plan);
+        return plan;
+    }
+
+    // Auto-detect common name tokens
+    std::unordered_set<std::string> ignoreSet(ignoreTokens.begin(), ignoreTokens.end());
+
+    // One pass: token frequencies plus an inverted index (token -> files)
+    TokenIndex index = buildTokenIndex(files, ignoreSet, threads, fuzzy);
+
+    // Limit to the top 10 tokens (seen at least twice) to avoid over-creating folders
+    std::vector<std::pair<std::string, std::vector<std::uint32_t>>> common;
+    if (fuzzy)
+    {
+        for (auto &group : clusterTokens(index, 2, 10))
+            common.emplace_back(std::string(group.name), std::move(group.files));
+    }
+    else
+    {
+        for (const auto &top : commonTokens(index, 2, 10))
+            common.emplace_back(std::string(top.token), index.files(top.id));
+    }
+
+    // A file is planned into the first (most frequent) token group it belongs to
+    std::vector<char> assigned(files.size(), 0);
+    std::vector<std::size_t> found;
+    for (const auto &[token, members] : common)
+    {
+        found.clear();
+        for (std::uint32_t f : members)
+            if (!assigned[f])
+                found.push_back(f);
+        if (found.size() < 2)
+            continue; // Skip tokens that don't represent groups
+
+        fs::path destDir = plan.destRoot / token;
+        for (std::size_t f : found)
+        {
+            addMove(plan, files.path(f), destDir, token);
+            assigned[f] = 1;
+        }
+    }
+
+    finalizePlan(plan);
+    return plan;
+}
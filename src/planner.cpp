@@ -0,0 +1,528 @@
+/**
+ * @file planner.cpp
+ * @brief Implementation of move planning, plan output and plan execution.
+ *
+ * @see planner.hpp
+ */
+
+#include "planner.hpp"
+#include "classifier.hpp"
+#include "colors.hpp"
+#include "destDirs.hpp"
+#include "fileMove.hpp"
+#include "journal.hpp"
+#include "mediaDate.hpp"
+#include "progress.hpp"
+#include "quarantine.hpp"
+#include "json.hpp"
+#include "stats.hpp"
+#include "threadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+using json = nlohmann::json;
+
+std::size_t MovePlan::count(MoveStatus status) const
+{
+    std::size_t n = 0;
+    for (const auto &m : moves)
+        if (m.status == status)
+            ++n;
+    return n;
+}
+
+const char *moveStatusName(MoveStatus status)
+{
+    switch (status)
+    {
+    case MoveStatus::Ready:
+        return "ready";
+    case MoveStatus::DestinationExists:
+        return "exists";
+    case MoveStatus::DuplicateInPlan:
+        return "duplicate";
+    case MoveStatus::Dangerous:
+        return "dangerous";
+    case MoveStatus::Identical:
+        return "identical";
+    }
+    return "unknown";
+}
+
+void addMove(MovePlan &plan, const fs::path &source, const fs::path &destDir,
+             const std::string &category, MoveStatus status)
+{
+    // Recursive scans also see files that are already organized
+    if (source.parent_path() == destDir)
+        return;
+
+    PlannedMove &move = plan.moves.emplace_back();
+    move.source = source;
+    move.destination = destDir / source.filename();
+    move.category = category;
+    move.status = status;
+}
+
+void finalizePlan(MovePlan &plan)
+{
+    /// Names known to be taken in one destination directory.
+    struct DirState
+    {
+        std::unordered_set<std::string> existing; ///< Present on disk before the run.
+        std::unordered_set<std::string> planned;  ///< Claimed by an earlier move.
+        bool needed = false;
+    };
+    std::unordered_map<std::string, DirState> dirs;
+
+    plan.directories.clear();
+    for (auto &move : plan.moves)
+    {
+        if (move.status != MoveStatus::Ready)
+            continue;
+
+        fs::path destDir = move.destination.parent_path();
+        auto [it, inserted] = dirs.try_emplace(destDir.string());
+        DirState &state = it->second;
+        if (inserted)
+        {
+            // One listing per destination directory instead of one stat per file
+            runStats().addCalls(Phase::Classify);
+            std::error_code ec;
+            for (fs::directory_iterator d(destDir, ec), end; !ec && d != end; d.increment(ec))
+                state.existing.insert(d->path().filename().string());
+        }
+
+        std::string name = move.destination.filename().string();
+        if (state.existing.count(name))
+        {
+            move.status = MoveStatus::DestinationExists;
+        }
+        else if (!state.planned.insert(std::move(name)).second)
+        {
+            move.status = MoveStatus::DuplicateInPlan;
+        }
+        else if (!state.needed)
+        {
+            state.needed = true;
+            plan.directories.push_back(destDir);
+        }
+    }
+}
+
+MovePlan planByType(const fs::path &root, const FileTable &files,
+                    const fs::path &destRoot, bool byDate, bool quarantine)
+{
+    PhaseTimer timer(Phase::Classify);
+    const ExtClassifier &classifier = files.classifier();
+    runStats().addItems(Phase::Classify, files.size());
+
+    MovePlan plan;
+    plan.root = root;
+    plan.destRoot = destRoot.empty() ? root : destRoot;
+    plan.moves.reserve(files.size());
+
+    // Category folders are built once, not once per file
+    std::vector<fs::path> typeDirs;
+    for (CategoryId id = 0; id < classifier.categoryCount(); ++id)
+        typeDirs.push_back(plan.destRoot / classifier.categoryName(id));
+
+    // Routed folders are built the first time a (rule, category) pair is seen
+    const RouteTable &routes = classifier.routes();
+    const std::int64_t now = RouteTable::now();
+    std::vector<fs::path> routeDirs;
+
+    // Date folders are built once per (category, month)
+    std::vector<char> dated(classifier.categoryCount(), 0);
+    if (byDate)
+        for (CategoryId id = 0; id < classifier.categoryCount(); ++id)
+            dated[id] = isDateCategory(classifier.categoryName(id));
+    std::unordered_map<std::uint64_t, fs::path> dateDirs;
+
+    if (quarantine)
+        plan.quarantineDir = plan.destRoot / QuarantineFolder;
+
+    // Records were classified during the scan
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        const FileRecord &record = files[i];
+        if ((record.flags & FileRecord::Dangerous) && quarantine)
+        {
+            std::size_t before = plan.moves.size();
+            addMove(plan, files.path(i), plan.quarantineDir, QuarantineFolder);
+            if (plan.moves.size() > before)
+                plan.moves.back().quarantined = true;
+            continue;
+        }
+        const fs::path *dir = &typeDirs[record.category];
+        std::size_t route = routes.empty() ? RouteTable::NoRoute : routes.match(record, now);
+        if (route != RouteTable::NoRoute)
+        {
+            std::size_t slot = route * typeDirs.size() + record.category;
+            if (routeDirs.size() <= slot)
+                routeDirs.resize(slot + 1);
+            if (routeDirs[slot].empty())
+                routeDirs[slot] = plan.destRoot / routes.folder(route, classifier.categoryName(record.category));
+            dir = &routeDirs[slot];
+        }
+        else if (int year, month; dated[record.category] && captureMonth(files, i, year, month))
+        {
+            auto key = (static_cast<std::uint64_t>(record.category) << 32) |
+                       static_cast<std::uint32_t>(year * 12 + month - 1);
+            fs::path &dateDir = dateDirs[key];
+            if (dateDir.empty())
+            {
+                char parts[2][8];
+                std::snprintf(parts[0], sizeof parts[0], "%04d", year);
+                std::snprintf(parts[1], sizeof parts[1], "%02d", month);
+                dateDir = typeDirs[record.category] / parts[0] / parts[1];
+            }
+            dir = &dateDir;
+        }
+        addMove(plan, files.path(i), *dir, classifier.categoryName(record.category),
+                (record.flags & FileRecord::Dangerous) ? MoveStatus::Dangerous : MoveStatus::Ready);
+    }
+
+    finalizePlan(plan);
+    return plan;
+}
+
+void printPlan(const MovePlan &plan, std::ostream &out)
+{
+    for (const auto &move : plan.moves)
+    {
+        bool quarantine = move.quarantined && move.status == MoveStatus::Ready;
+        const std::string &color = quarantine                             ? RED
+                                   : move.status == MoveStatus::Ready     ? GREEN
+                                   : move.status == MoveStatus::Dangerous ? RED
+                                                                          : YELLOW;
+        // Identical files point at the copy that is kept instead of a destination
+        bool identical = move.status == MoveStatus::Identical;
+        const fs::path &target = identical ? move.duplicateOf : move.destination;
+
+        // Destinations outside the organized directory are shown in full
+        fs::path shownDest = plan.destRoot.empty() || plan.destRoot == plan.root
+                                 ? target.lexically_relative(plan.root)
+                                 : target;
+        out << color << "[" << (quarantine ? "quarantine" : moveStatusName(move.status)) << "] " << RESET
+            << move.source.lexically_relative(plan.root).string() << DIM << (identical ? " == " : " -> ") << RESET
+            << shownDest.string() << "\n";
+    }
+
+    std::size_t quarantined = 0;
+    for (const auto &move : plan.moves)
+        quarantined += move.quarantined && move.status == MoveStatus::Ready;
+
+    out << BOLD << "Plan: " << RESET
+        << GREEN << plan.count(MoveStatus::Ready) - quarantined << " to move" << RESET << ", ";
+    if (quarantined)
+        out << RED << quarantined << " to quarantine" << RESET << ", ";
+    out << YELLOW << plan.count(MoveStatus::DestinationExists) << " existing, "
+        << plan.count(MoveStatus::DuplicateInPlan) << " duplicate";
+    if (std::size_t identical = plan.count(MoveStatus::Identical))
+        out << ", " << identical << " identical";
+    out << RESET << ", "
+        << RED << plan.count(MoveStatus::Dangerous) << " dangerous" << RESET
+        << " (" << plan.directories.size() << " directories)\n";
+}
+
+bool savePlanJson(const MovePlan &plan, const fs::path &file)
+{
+    std::ofstream out(file, std::ios::binary);
+    if (!out.is_open())
+        return false;
+
+    json dirs = json::array();
+    for (const auto &d : plan.directories)
+        dirs.push_back(d.string());
+
+    out << "{\n  \"root\": " << json(plan.root.string()).dump()
+        << ",\n  \"destRoot\": " << json(plan.destRoot.string()).dump()
+        << ",\n  \"directories\": " << dirs.dump()
+        << ",\n  \"moves\": [";
+
+    // Stream moves one object at a time rather than building a DOM
+    bool first = true;
+    for (const auto &move : plan.moves)
+    {
+        json entry = {
+            {"source", move.source.string()},
+            {"destination", move.destination.string()},
+            {"category", move.category},
+            {"status", moveStatusName(move.status)}};
+        if (move.status == MoveStatus::Identical)
+            entry["duplicateOf"] = move.duplicateOf.string();
+        if (move.quarantined)
+            entry["quarantine"] = true;
+        out << (first ? "\n    " : ",\n    ") << entry.dump();
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+
+    return static_cast<bool>(out);
+}
+
+/// Entry of `resolvePlanDirectories()` for a move whose directory could not be created.
+static constexpr int DirFailed = -2;
+
+/**
+ * @brief Resolve every destination directory of a plan once.
+ *
+ * Creates what is missing and fills `destDirs` with each ready move's
+ * directory handle; a move whose directory failed keeps `DirFailed`.
+ *
+ * @param plan     Plan whose `directories` are resolved.
+ * @param dirs     Directory cache that owns the handles.
+ * @param destDirs One entry per move.
+ */
+static void resolvePlanDirectories(const MovePlan &plan, DestinationDirs &dirs, std::vector<int> &destDirs)
+{
+    PhaseTimer timer(Phase::Mkdir);
+    for (const auto &dir : plan.directories)
+    {
+        std::error_code ec;
+        dirs.open(dir, ec);
+        runStats().addItems(Phase::Mkdir);
+        if (ec)
+        {
+            runStats().addErrors(Phase::Mkdir);
+            std::cerr << RED << "Warning: Could not create directory "
+                      << dir << ": " << ec.message() << RESET << "\n";
+        }
+    }
+
+    // Every lookup below is a cache hit
+    destDirs.assign(plan.moves.size(), DirFailed);
+    for (std::size_t i = 0; i < plan.moves.size(); ++i)
+        if (plan.moves[i].status == MoveStatus::Ready)
+        {
+            std::error_code ec;
+            int fd = dirs.open(plan.moves[i].destination.parent_path(), ec);
+            if (!ec)
+                destDirs[i] = fd;
+        }
+}
+
+/**
+ * @brief Replace an identical file with a hard link to its kept copy.
+ *
+ * The link is created under a temporary name and renamed over the file,
+ * so the path never disappears. Nothing is linked when the size or
+ * modification time of either file differs from when `findDuplicates()`
+ * compared them.
+ *
+ * @return bool True when the file now shares the kept copy's data.
+ */
+static bool linkDuplicate(const PlannedMove &move)
+{
+    std::error_code ec;
+    if (!fs::exists(move.duplicateOf, ec))
+        return false; // the kept copy could not be moved into place
+    if (fs::equivalent(move.source, move.duplicateOf, ec))
+        return true; // already linked (rename() would be a no-op)
+
+    // Either file may have been written since the bytes were compared
+    auto unchanged = [&](const fs::path &path, fs::file_time_type time) {
+        std::error_code statEc;
+        std::uint64_t size = fs::file_size(path, statEc);
+        return !statEc && size == move.duplicateSize && fs::last_write_time(path, statEc) == time && !statEc;
+    };
+    if (!unchanged(move.source, move.sourceTime) || !unchanged(move.duplicateOf, move.duplicateTime))
+    {
+        std::cerr << RED << "Not linking " << move.source << ": it or " << move.duplicateOf
+                  << " changed after the comparison" << RESET << "\n";
+        return false;
+    }
+
+    fs::path temp = move.source;
+    temp += ".clean-link";
+    fs::create_hard_link(move.duplicateOf, temp, ec);
+    if (!ec)
+    {
+        fs::rename(temp, move.source, ec);
+        if (ec)
+        {
+            std::error_code ignored;
+            fs::remove(temp, ignored);
+        }
+    }
+    if (ec)
+    {
+        std::cerr << RED << "Failed to link " << move.source << " -> " << move.duplicateOf << ": "
+                  << ec.message() << RESET << "\n";
+        return false;
+    }
+    return true;
+}
+
+MoveResult executePlan(const MovePlan &plan, unsigned jobs, MoveJournal *journal, bool batched,
+                       ProgressReporter *progress)
+{
+    MoveResult result;
+    if (progress)
+        progress->start(ProgressPhase::Move, plan.count(MoveStatus::Ready));
+    auto stopped = [progress] { return progress && progress->cancelled(); };
+
+    // Create and open every destination directory once, up front
+    DestinationDirs dirs;
+    std::vector<int> destDirs;
+    resolvePlanDirectories(plan, dirs, destDirs);
+
+    // The quarantine folder is closed to other users before anything lands in it
+    bool quarantining = false;
+    for (std::size_t i = 0; i < plan.moves.size() && !quarantining; ++i)
+        quarantining = plan.moves[i].quarantined && destDirs[i] != DirFailed;
+    if (quarantining)
+    {
+        std::error_code ec;
+        restrictQuarantineDir(plan.quarantineDir, ec);
+        if (ec)
+            std::cerr << RED << "Warning: Could not restrict " << plan.quarantineDir << ": "
+                      << ec.message() << RESET << "\n";
+    }
+
+    std::mutex errorMutex; // serializes error output from concurrent moves
+    std::vector<MoveOutcome> &done = result.outcomes;
+    done.assign(plan.moves.size(), MoveOutcome::Skipped);
+
+    auto runnable = [&](std::size_t i) {
+        return plan.moves[i].status == MoveStatus::Ready && destDirs[i] != DirFailed && !stopped();
+    };
+
+    auto finishMove = [&](std::size_t i, std::error_code ec) {
+        const PlannedMove &move = plan.moves[i];
+        if (ec)
+        {
+            runStats().addErrors(Phase::Move);
+            std::lock_guard<std::mutex> lock(errorMutex);
+            done[i] = MoveOutcome::Failed;
+            result.failures.emplace_back(i, ec);
+            std::cerr << RED << "Failed to move " << move.source
+                      << " -> " << move.destination << ": "
+                      << ec.message() << RESET << "\n";
+        }
+        else
+        {
+            done[i] = MoveOutcome::Moved;
+            runStats().addItems(Phase::Move);
+            if (move.quarantined)
+            {
+                std::error_code permError;
+                restrictQuarantinedFile(move.destination, permError);
+                if (permError)
+                {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    std::cerr << RED << "Warning: Could not restrict " << move.destination << ": "
+                              << permError.message() << RESET << "\n";
+                }
+            }
+            if (journal && move.journalId)
+                journal->recordDone(move.journalId);
+        }
+        if (progress)
+            progress->advance();
+    };
+
+    auto runMove = [&](std::size_t i) {
+        const PlannedMove &move = plan.moves[i];
+        if (!runnable(i))
+            return;
+
+        // Rename, or copy and unlink when the destination is on another device
+        bool timed = runStats().enabled();
+        auto start = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+        std::error_code ec = moveFileInto(move.source, destDirs[i], move.destination);
+        if (timed)
+            runStats().recordMove(move.source, move.destination, nanosSince(start));
+        finishMove(i, ec);
+    };
+
+    PhaseTimer moveTimer(Phase::Move);
+    if (batched)
+    {
+        // Renames go to the kernel a batch at a time (io_uring on Linux)
+        std::vector<std::size_t> indices;
+        std::vector<std::pair<const fs::path *, const fs::path *>> pairs;
+        std::vector<int> handles;
+        for (std::size_t i = 0; i < plan.moves.size(); ++i)
+            if (runnable(i))
+            {
+                indices.push_back(i);
+                pairs.emplace_back(&plan.moves[i].source, &plan.moves[i].destination);
+                handles.push_back(destDirs[i]);
+            }
+        moveFilesBatched(pairs, [&](std::size_t n, std::error_code ec) { finishMove(indices[n], ec); }, handles);
+    }
+    else if (jobs <= 1 || plan.moves.size() < 2)
+    {
+        for (std::size_t i = 0; i < plan.moves.size(); ++i)
+            runMove(i);
+    }
+    else
+    {
+        // Several shards per worker keeps workers busy when shards are uneven
+        std::size_t shardCount = static_cast<std::size_t>(jobs) * 4;
+        std::vector<std::vector<std::size_t>> shards(shardCount);
+        std::hash<std::string> hasher;
+        for (std::size_t i = 0; i < plan.moves.size(); ++i)
+            if (plan.moves[i].status == MoveStatus::Ready)
+                shards[hasher(plan.moves[i].destination.string()) % shardCount].push_back(i);
+
+        ThreadPool pool(jobs);
+        for (auto &shard : shards)
+            if (!shard.empty())
+                pool.submit([&runMove, &shard] {
+                    for (std::size_t i : shard)
+                        runMove(i);
+                });
+        pool.wait();
+    }
+
+    // Identical files are linked once every kept copy is in place
+    result.cancelled = stopped();
+    if (plan.linkDuplicates && !result.cancelled)
+        for (std::size_t i = 0; i < plan.moves.size(); ++i)
+            if (plan.moves[i].status == MoveStatus::Identical && linkDuplicate(plan.moves[i]))
+                done[i] = MoveOutcome::Linked;
+
+    // Ready moves whose directory could not be created failed too
+    for (std::size_t i = 0; i < plan.moves.size(); ++i)
+        if (plan.moves[i].status == MoveStatus::Ready && destDirs[i] == DirFailed)
+        {
+            std::error_code ec;
+            dirs.open(plan.moves[i].destination.parent_path(), ec); // cached: reports the original error
+            done[i] = MoveOutcome::Failed;
+            result.failures.emplace_back(i, ec);
+        }
+    std::sort(result.failures.begin(), result.failures.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    for (std::size_t i = 0; i < plan.moves.size(); ++i)
+    {
+        if (done[i] == MoveOutcome::Moved)
+        {
+            ++result.moved;
+            result.quarantined += plan.moves[i].quarantined;
+        }
+        else if (done[i] == MoveOutcome::Linked)
+        {
+            ++result.linked;
+        }
+        else
+        {
+            ++result.skipped;
+            result.skippedFiles.push_back(plan.moves[i].source.filename());
+        }
+    }
+    if (progress)
+        progress->finish();
+
+    return result;
+}
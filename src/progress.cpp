@@ -0,0 +1,61 @@
+/**
+ * @file progress.cpp
+ * @brief Implementation of the throttled progress reporter.
+ *
+ * @see progress.hpp
+ */
+
+#include "progress.hpp"
+
+namespace
+{
+    std::int64_t nowNanos()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+}
+
+ProgressReporter::ProgressReporter(ProgressCallback callback, const CancelToken *cancel,
+                                   std::chrono::milliseconds interval)
+    : callback_(std::move(callback)), cancel_(cancel),
+      interval_(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count())
+{
+}
+
+void ProgressReporter::start(ProgressPhase phase, std::uint64_t total)
+{
+    phase_ = phase;
+    total_ = total;
+    done_.store(0, std::memory_order_relaxed);
+    next_.store(nowNanos() + interval_, std::memory_order_relaxed);
+    report(false);
+}
+
+void ProgressReporter::advance(std::uint64_t n)
+{
+    done_.fetch_add(n, std::memory_order_relaxed);
+    if (!callback_)
+        return;
+
+    // One thread wins the slot of each interval; the others return at once
+    std::int64_t now = nowNanos();
+    std::int64_t next = next_.load(std::memory_order_relaxed);
+    if (now < next || !next_.compare_exchange_strong(next, now + interval_, std::memory_order_relaxed))
+        return;
+    report(false);
+}
+
+void ProgressReporter::finish()
+{
+    report(true);
+}
+
+void ProgressReporter::report(bool finished)
+{
+    if (!callback_)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    callback_({phase_, done_.load(std::memory_order_relaxed), total_, finished});
+}
@@ -0,0 +1,187 @@
+/**
+ * @file quarantine.cpp
+ * @brief Implementation of the quarantine folder and the external scanner queue.
+ *
+ * @see quarantine.hpp
+ */
+
+#include "quarantine.hpp"
+#include "colors.hpp"
+#include "resultLog.hpp"
+
+#include <iostream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char **environ;
+#endif
+
+std::string quarantineExclude(const fs::path &root, const fs::path &destRoot)
+{
+    fs::path folder = (destRoot.empty() ? root : destRoot) / QuarantineFolder;
+    fs::path relative = folder.lexically_normal().lexically_relative(root.lexically_normal());
+    if (relative.empty() || *relative.begin() == "..")
+        return {};
+    return relative.generic_string();
+}
+
+void restrictQuarantineDir(const fs::path &dir, std::error_code &ec)
+{
+    fs::permissions(dir, fs::perms::owner_all, fs::perm_options::replace, ec);
+}
+
+void restrictQuarantinedFile(const fs::path &file, std::error_code &ec)
+{
+    fs::permissions(file, fs::perms::owner_read | fs::perms::owner_write, fs::perm_options::replace, ec);
+}
+
+QuarantineScanner::QuarantineScanner(const std::string &command, bool jsonl) : jsonl_(jsonl)
+{
+    std::istringstream words(command);
+    for (std::string word; words >> word;)
+        argv_.push_back(word);
+#ifndef _WIN32
+    if (!argv_.empty())
+        thread_ = std::thread([this] { run(); });
+#endif
+}
+
+QuarantineScanner::~QuarantineScanner()
+{
+    drain();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    changed_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void QuarantineScanner::submit(const MovePlan &plan, const MoveResult &result)
+{
+    std::size_t queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::size_t i = 0; i < plan.moves.size(); ++i)
+            if (plan.moves[i].quarantined && result.outcomes[i] == MoveOutcome::Moved)
+            {
+                queue_.push_back(plan.moves[i].destination.string());
+                ++queued;
+            }
+        if (!thread_.joinable())
+            queue_.clear();
+    }
+    if (queued == 0)
+        return;
+#ifdef _WIN32
+    std::cerr << YELLOW << "Warning: --quarantine-scan is not supported on Windows; "
+              << queued << " file(s) not scanned.\n" << RESET;
+#else
+    changed_.notify_all();
+#endif
+}
+
+std::size_t QuarantineScanner::drain()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] { return queue_.empty() && !busy_; });
+    return failures_;
+}
+
+void QuarantineScanner::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::vector<std::string> batch;
+    for (;;)
+    {
+        changed_.wait(lock, [this] { return !queue_.empty() || stop_; });
+        if (queue_.empty())
+            return;
+
+        // Everything queued so far, up to one process worth of arguments
+        batch.clear();
+        std::size_t bytes = 0;
+        while (!queue_.empty() && batch.size() < BatchSize &&
+               (batch.empty() || bytes + queue_.front().size() + 1 <= MaxArgBytes))
+        {
+            bytes += queue_.front().size() + 1;
+            batch.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+        busy_ = true;
+
+        lock.unlock();
+        scanBatch(batch);
+        lock.lock();
+        busy_ = false;
+        changed_.notify_all();
+    }
+}
+
+void QuarantineScanner::scanBatch(const std::vector<std::string> &paths)
+{
+#ifndef _WIN32
+    std::vector<char *> args;
+    args.reserve(argv_.size() + paths.size() + 1);
+    for (auto &word : argv_)
+        args.push_back(word.data());
+    for (const auto &path : paths)
+        args.push_back(const_cast<char *>(path.c_str()));
+    args.push_back(nullptr);
+
+    // Standard output carries the JSON Lines records, so the scanner reports on standard error
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (jsonl_)
+        posix_spawn_file_actions_adddup2(&actions, STDERR_FILENO, STDOUT_FILENO);
+    pid_t pid = 0;
+    int error = posix_spawnp(&pid, args[0], &actions, nullptr, args.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    int code = 0;
+    if (error == 0)
+    {
+        int status = 0;
+        while (::waitpid(pid, &status, 0) < 0 && errno == EINTR)
+        {
+        }
+        code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    }
+    bool failed = error != 0 || code != 0;
+
+    if (jsonl_)
+    {
+        JsonlRecord record("quarantineScan");
+        record.number("files", paths.size());
+        if (error != 0)
+            record.text("error", std::strerror(error));
+        else
+            record.number("status", static_cast<std::uint64_t>(code));
+        resultLog().write(record.line());
+    }
+    else if (error != 0)
+    {
+        std::cerr << RED << "Error: Could not run quarantine scanner \"" << argv_[0] << "\": "
+                  << std::strerror(error) << RESET << "\n";
+    }
+    else if (code != 0)
+    {
+        std::cerr << YELLOW << "Quarantine scan exited with status " << code << " for " << paths.size()
+                  << " file(s).\n" << RESET;
+    }
+
+    if (failed)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++failures_;
+    }
+#else
+    (void)paths;
+#endif
+}
@@ -0,0 +1,292 @@
+/**
+ * @file resultLog.cpp
+ * @brief Implementation of the JSON Lines result writer.
+ *
+ * @see resultLog.hpp
+ */
+
+#include "resultLog.hpp"
+
+#include <type_traits>
+
+namespace
+{
+    /// Records formatted locally before they are handed to the writer.
+    constexpr std::size_t ChunkSize = 64 * 1024;
+
+    /// Length of the valid UTF-8 sequence at `i`, or 0.
+    std::size_t utf8Length(std::string_view text, std::size_t i)
+    {
+        auto c = static_cast<unsigned char>(text[i]);
+        std::size_t length = c >= 0xF0 && c <= 0xF4 ? 4 : c >= 0xE0 ? 3 : c >= 0xC2 && c <= 0xDF ? 2 : 0;
+        if (length == 0 || i + length > text.size())
+            return 0;
+        for (std::size_t k = 1; k < length; ++k)
+            if ((static_cast<unsigned char>(text[i + k]) & 0xC0) != 0x80)
+                return 0;
+        auto next = static_cast<unsigned char>(text[i + 1]);
+        if ((c == 0xE0 && next < 0xA0) || (c == 0xED && next > 0x9F) || (c == 0xF0 && next < 0x90) ||
+            (c == 0xF4 && next > 0x8F))
+            return 0; // overlong, surrogate or beyond U+10FFFF
+        return length;
+    }
+}
+
+JsonlWriter::JsonlWriter(std::FILE *out, std::size_t capacity, bool background)
+    : out_(out), capacity_(capacity), background_(background)
+{
+    filling_.reserve(capacity_);
+    if (background_)
+        thread_ = std::thread([this] { run(); });
+}
+
+JsonlWriter::~JsonlWriter()
+{
+    close();
+}
+
+void JsonlWriter::handOff(std::unique_lock<std::mutex> &lock)
+{
+    if (!background_)
+    {
+        std::fwrite(filling_.data(), 1, filling_.size(), out_);
+        filling_.clear();
+        return;
+    }
+    changed_.wait(lock, [this] { return !busy_; });
+    filling_.swap(writing_);
+    filling_.clear();
+    filling_.reserve(capacity_);
+    busy_ = true;
+    changed_.notify_all();
+}
+
+void JsonlWriter::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        changed_.wait(lock, [this] { return busy_ || stop_; });
+        if (!busy_)
+            return;
+
+        // The block is ours until busy_ is cleared, so write it unlocked
+        lock.unlock();
+        std::fwrite(writing_.data(), 1, writing_.size(), out_);
+        lock.lock();
+        writing_.clear();
+        busy_ = false;
+        changed_.notify_all();
+    }
+}
+
+void JsonlWriter::write(std::string_view lines)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!filling_.empty() && filling_.size() + lines.size() > capacity_)
+        handOff(lock);
+    filling_.append(lines);
+}
+
+void JsonlWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!filling_.empty())
+        handOff(lock);
+    changed_.wait(lock, [this] { return !busy_; });
+    std::fflush(out_);
+}
+
+void JsonlWriter::close()
+{
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        background_ = false;
+    }
+    changed_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+JsonlWriter &resultLog()
+{
+    static JsonlWriter writer;
+    return writer;
+}
+
+void appendJsonString(std::string &out, std::string_view text)
+{
+    static const char hex[] = "0123456789abcdef";
+    out.push_back('"');
+    for (std::size_t i = 0; i < text.size();)
+    {
+        auto c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x80)
+        {
+            std::size_t length = utf8Length(text, i);
+            if (length == 0)
+            {
+                out.append("\\ufffd");
+                ++i;
+            }
+            else
+            {
+                out.append(text.substr(i, length));
+                i += length;
+            }
+            continue;
+        }
+        switch (c)
+        {
+        case '"':
+            out.append("\\\"");
+            break;
+        case '\\':
+            out.append("\\\\");
+            break;
+        case '\n':
+            out.append("\\n");
+            break;
+        case '\t':
+            out.append("\\t");
+            break;
+        default:
+            if (c < 0x20)
+            {
+                out.append("\\u00");
+                out.push_back(hex[c >> 4]);
+                out.push_back(hex[c & 0xF]);
+            }
+            else
+            {
+                out.push_back(static_cast<char>(c));
+            }
+        }
+        ++i;
+    }
+    out.push_back('"');
+}
+
+void JsonlRecord::key(std::string_view name)
+{
+    line_.push_back(line_.empty() ? '{' : ',');
+    appendJsonString(line_, name);
+    line_.push_back(':');
+}
+
+JsonlRecord &JsonlRecord::text(std::string_view name, std::string_view value)
+{
+    key(name);
+    appendJsonString(line_, value);
+    return *this;
+}
+
+JsonlRecord &JsonlRecord::path(std::string_view name, const fs::path &value)
+{
+    if constexpr (std::is_same_v<fs::path::value_type, char>)
+        return text(name, value.native());
+    else
+        return text(name, value.string());
+}
+
+JsonlRecord &JsonlRecord::number(std::string_view name, std::uint64_t value)
+{
+    key(name);
+    line_.append(std::to_string(value));
+    return *this;
+}
+
+JsonlRecord &JsonlRecord::real(std::string_view name, double value)
+{
+    char digits[32];
+    int n = std::snprintf(digits, sizeof digits, "%.6g", value);
+    key(name);
+    line_.append(digits, static_cast<std::size_t>(n));
+    return *this;
+}
+
+JsonlRecord &JsonlRecord::boolean(std::string_view name, bool value)
+{
+    key(name);
+    line_.append(value ? "true" : "false");
+    return *this;
+}
+
+const std::string &JsonlRecord::line()
+{
+    if (!closed_)
+    {
+        line_.append("}\n");
+        closed_ = true;
+    }
+    return line_;
+}
+
+void logMoves(const MovePlan &plan, const MoveResult *result)
+{
+    std::string chunk;
+    chunk.reserve(ChunkSize + 4096);
+    auto failure = result ? result->failures.begin() : decltype(result->failures.begin()){};
+
+    for (std::size_t i = 0; i < plan.moves.size(); ++i)
+    {
+        const PlannedMove &move = plan.moves[i];
+        MoveOutcome outcome = result ? result->outcomes[i] : MoveOutcome::Skipped;
+
+        const char *event = "planned";
+        if (move.status == MoveStatus::Dangerous)
+            event = "dangerous";
+        else if (result)
+            event = outcome == MoveOutcome::Moved    ? (move.quarantined ? "quarantined" : "moved")
+                    : outcome == MoveOutcome::Linked ? "linked"
+                    : outcome == MoveOutcome::Failed ? "failed"
+                                                     : "skipped";
+
+        JsonlRecord record(event);
+        record.path("source", move.source);
+        if (move.status != MoveStatus::Dangerous)
+            record.path("destination", move.destination).text("category", move.category);
+        if (!result)
+            record.text("status", moveStatusName(move.status));
+        else if (outcome == MoveOutcome::Skipped && move.status != MoveStatus::Dangerous)
+            record.text("reason", moveStatusName(move.status));
+        if (move.status == MoveStatus::Identical)
+            record.path("duplicateOf", move.duplicateOf);
+        if (move.quarantined && !result)
+            record.boolean("quarantine", true);
+        if (outcome == MoveOutcome::Failed)
+        {
+            while (failure != result->failures.end() && failure->first < i)
+                ++failure;
+            if (failure != result->failures.end() && failure->first == i)
+                record.text("error", failure->second.message());
+        }
+
+        chunk.append(record.line());
+        if (chunk.size() >= ChunkSize)
+        {
+            resultLog().write(chunk);
+            chunk.clear();
+        }
+    }
+    if (!chunk.empty())
+        resultLog().write(chunk);
+}
+
+void logSummary(const MovePlan &plan, const MoveResult *result)
+{
+    JsonlRecord record("summary");
+    record.path("root", plan.root)
+        .boolean("dryRun", result == nullptr)
+        .number("planned", plan.count(MoveStatus::Ready))
+        .number("moved", result ? result->moved : 0)
+        .number("skipped", result ? result->skipped : plan.moves.size() - plan.count(MoveStatus::Ready))
+        .number("linked", result ? result->linked : 0)
+        .number("failed", result ? result->failures.size() : 0)
+        .number("quarantined", result ? result->quarantined : 0)
+        .number("dangerous", plan.count(MoveStatus::Dangerous))
+        .number("identical", plan.count(MoveStatus::Identical));
+    resultLog().write(record.line());
+}
@@ -0,0 +1,205 @@
+/**
+ * @file routeRules.cpp
+ * @brief Parsing, compilation and evaluation of the routing rules.
+ *
+ * @see routeRules.hpp
+ */
+
+#include "routeRules.hpp"
+#include "colors.hpp"
+#include "fileTable.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+    /// Split `text` into a non-negative number and a unit (surrounding blanks removed).
+    bool splitQuantity(std::string_view text, double &number, std::string &unit)
+    {
+        std::string s(text);
+        char *end = nullptr;
+        number = std::strtod(s.c_str(), &end);
+        if (end == s.c_str() || !std::isfinite(number) || number < 0)
+            return false;
+        unit.clear();
+        for (const char *p = end; *p; ++p)
+            if (*p != ' ')
+                unit += static_cast<char>(std::tolower(static_cast<unsigned char>(*p)));
+        return true;
+    }
+
+    /// Convert `number * scale` to an integer, failing on overflow.
+    template <typename Int>
+    bool scaled(double number, double scale, Int &out)
+    {
+        double value = number * scale;
+        if (value >= static_cast<double>(std::numeric_limits<Int>::max()))
+            return false;
+        out = static_cast<Int>(std::llround(value));
+        return true;
+    }
+
+    /// Seconds to nanoseconds, saturating (ages beyond ~290 years never occur).
+    std::uint64_t nanoseconds(std::int64_t seconds)
+    {
+        constexpr std::int64_t MaxSeconds = std::numeric_limits<std::int64_t>::max() / 1000000000;
+        return static_cast<std::uint64_t>(std::min(seconds, MaxSeconds)) * 1000000000;
+    }
+}
+
+bool parseByteSize(std::string_view text, std::uint64_t &bytes)
+{
+    double number = 0;
+    std::string unit;
+    if (!splitQuantity(text, number, unit))
+        return false;
+
+    double scale = 0;
+    if (unit.empty() || unit == "b")
+        scale = 1;
+    else if (unit == "k" || unit == "kib")
+        scale = 1024.0;
+    else if (unit == "m" || unit == "mib")
+        scale = 1024.0 * 1024;
+    else if (unit == "g" || unit == "gib")
+        scale = 1024.0 * 1024 * 1024;
+    else if (unit == "t" || unit == "tib")
+        scale = 1024.0 * 1024 * 1024 * 1024;
+    else if (unit == "kb")
+        scale = 1e3;
+    else if (unit == "mb")
+        scale = 1e6;
+    else if (unit == "gb")
+        scale = 1e9;
+    else if (unit == "tb")
+        scale = 1e12;
+    else
+        return false;
+    return scaled(number, scale, bytes);
+}
+
+bool parseAge(std::string_view text, std::int64_t &seconds)
+{
+    double number = 0;
+    std::string unit;
+    if (!splitQuantity(text, number, unit))
+        return false;
+
+    double scale = 0;
+    if (unit.empty() || unit == "s")
+        scale = 1;
+    else if (unit == "min")
+        scale = 60;
+    else if (unit == "h")
+        scale = 3600;
+    else if (unit == "d")
+        scale = 86400;
+    else if (unit == "w")
+        scale = 7 * 86400;
+    else if (unit == "y")
+        scale = 365 * 86400;
+    else
+        return false;
+    return scaled(number, scale, seconds);
+}
+
+RouteTable::RouteTable(const std::vector<RouteRule> &rules, const std::vector<std::string> &categories)
+    : categoryCount_(categories.size())
+{
+    // Cheap tests first: the category flag rejects most files of most rules
+    for (const RouteRule &rule : rules)
+    {
+        Route route;
+        route.first = static_cast<std::uint32_t>(predicates_.size());
+        route.to = rule.to;
+
+        if (!rule.categories.empty())
+        {
+            std::size_t offset = categoryFlags_.size();
+            categoryFlags_.resize(offset + categoryCount_, 0);
+            for (const std::string &name : rule.categories)
+            {
+                auto it = std::find(categories.begin(), categories.end(), name);
+                if (it == categories.end())
+                {
+                    std::cerr << RED << "[Warning] Routing rule to \"" << rule.to << "\" names unknown category \""
+                              << name << "\".\n" << RESET;
+                    continue;
+                }
+                categoryFlags_[offset + static_cast<std::size_t>(it - categories.begin())] = 1;
+            }
+            predicates_.push_back({Test::Category, offset});
+        }
+        if (rule.minSize > 0)
+            predicates_.push_back({Test::MinSize, rule.minSize});
+        if (rule.maxSize != RouteRule::NoSizeLimit)
+            predicates_.push_back({Test::MaxSize, rule.maxSize});
+        if (rule.minAge > 0)
+            predicates_.push_back({Test::MinAge, nanoseconds(rule.minAge)});
+        if (rule.maxAge != RouteRule::NoAgeLimit)
+            predicates_.push_back({Test::MaxAge, nanoseconds(rule.maxAge)});
+
+        route.count = static_cast<std::uint32_t>(predicates_.size() - route.first);
+        needsStat_ = needsStat_ || rule.needsStat();
+        routes_.push_back(std::move(route));
+    }
+}
+
+std::size_t RouteTable::match(const FileRecord &record, std::int64_t now) const
+{
+    bool hasStat = record.flags & FileRecord::HasStat;
+    // Files dated in the future count as new
+    std::uint64_t age = hasStat && now > record.mtime ? static_cast<std::uint64_t>(now - record.mtime) : 0;
+
+    for (std::size_t r = 0; r < routes_.size(); ++r)
+    {
+        const Route &route = routes_[r];
+        bool matches = true;
+        for (std::uint32_t p = route.first; matches && p < route.first + route.count; ++p)
+        {
+            const Predicate &predicate = predicates_[p];
+            switch (predicate.test)
+            {
+            case Test::Category:
+                matches = categoryFlags_[predicate.value + record.category] != 0;
+                break;
+            case Test::MinSize:
+                matches = hasStat && record.size >= predicate.value;
+                break;
+            case Test::MaxSize:
+                matches = hasStat && record.size < predicate.value;
+                break;
+            case Test::MinAge:
+                matches = hasStat && age >= predicate.value;
+                break;
+            case Test::MaxAge:
+                matches = hasStat && age < predicate.value;
+                break;
+            }
+        }
+        if (matches)
+            return r;
+    }
+    return NoRoute;
+}
+
+fs::path RouteTable::folder(std::size_t route, const std::string &category) const
+{
+    static constexpr std::string_view Placeholder = "{category}";
+    std::string to = routes_[route].to;
+    for (std::size_t at = to.find(Placeholder); at != std::string::npos;
+         at = to.find(Placeholder, at + category.size()))
+        to.replace(at, Placeholder.size(), category);
+    return fs::path(to);
+}
+
+std::int64_t RouteTable::now()
+{
+    auto now = fs::file_time_type::clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
@@ -0,0 +1,392 @@
+/**
+ * @file ruleBlob.cpp
+ * @brief Writing and reading the compiled rule bundle.
+ *
+ * Bundle layout (native byte order):
+ *
+ *     Header
+ *     int64[stampCount]             source stamps at compile time
+ *     CategoryRef[categoryCount]    name and extension range
+ *     RouteRef[routeCount]          routing rules, in priority order
+ *     StringRef[extensionCount]     extensions of all categories, in order
+ *     StringRef[dangerousCount]     dangerous extensions
+ *     StringRef[tokenCount]         ignore tokens
+ *     StringRef[routeCategoryCount] category names of all routing rules, in order
+ *     pool                          all strings
+ *
+ * @see ruleBlob.hpp
+ */
+
+#include "ruleBlob.hpp"
+#include "ruleSet.hpp"
+#include "defaultRules.hpp"
+#include "fileTypes.hpp"
+#include "dangerousExts.hpp"
+#include "ignoreTokens.hpp"
+#include "mappedFile.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    constexpr char Magic[8] = {'C', 'L', 'N', 'R', 'U', 'L', 'E', '\1'};
+    constexpr std::uint32_t Version = 2;
+
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t stampCount;
+        std::uint32_t categoryCount;
+        std::uint32_t extensionCount;
+        std::uint32_t dangerousCount;
+        std::uint32_t tokenCount;
+        std::uint32_t routeCount;
+        std::uint32_t routeCategoryCount;
+        std::uint32_t poolSize;
+        std::uint32_t reserved;
+    };
+
+    struct StringRef
+    {
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+    struct CategoryRef
+    {
+        StringRef name;
+        std::uint32_t firstExtension;
+        std::uint32_t extensionCount;
+    };
+
+    struct RouteRef
+    {
+        StringRef to;
+        std::uint32_t firstCategory;
+        std::uint32_t categoryCount;
+        std::uint64_t minSize;
+        std::uint64_t maxSize;
+        std::int64_t minAge;
+        std::int64_t maxAge;
+    };
+
+    static_assert(sizeof(Header) == 48 && sizeof(StringRef) == 8 && sizeof(CategoryRef) == 16 &&
+                      sizeof(RouteRef) == 48,
+                  "rule bundle records must have a fixed layout");
+
+    template <typename T>
+    void appendRaw(std::string &out, const T &value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof value);
+    }
+
+    StringRef store(std::string &pool, const std::string &text)
+    {
+        StringRef ref{static_cast<std::uint32_t>(pool.size()), static_cast<std::uint32_t>(text.size())};
+        pool.append(text);
+        return ref;
+    }
+
+    /// Write `text` as a C++ string literal; octal escapes avoid hex-digit run-on.
+    void writeLiteral(std::ostream &out, const std::string &text)
+    {
+        out << '"';
+        for (unsigned char c : text)
+        {
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if (c < 0x20 || c >= 0x7f)
+            {
+                char escape[8];
+                std::snprintf(escape, sizeof escape, "\\%03o", c);
+                out << escape;
+            }
+            else
+                out << c;
+        }
+        out << '"';
+    }
+
+    /// Write a `std::array<std::string_view, N>` definition.
+    void writeArray(std::ostream &out, const char *name, const std::vector<std::string> &items)
+    {
+        out << "inline constexpr std::array<std::string_view, " << items.size() << "> " << name << " = {";
+        for (std::size_t i = 0; i < items.size(); ++i)
+        {
+            out << (i % 8 == 0 ? "\n    " : " ");
+            writeLiteral(out, items[i]);
+            out << ',';
+        }
+        out << "\n};\n\n";
+    }
+}
+
+RuleData loadRuleSources()
+{
+    RuleData rules;
+    rules.stamps = ruleSourceStamps();
+    rules.fileTypes = loadFileTypes(&rules.routes);
+    rules.dangerousExts = loadDangerousExts();
+    rules.ignoreTokens = loadIgnoreTokens();
+    return rules;
+}
+
+RuleData builtinRules()
+{
+    RuleData rules;
+    for (const auto &category : defaultRules::fileTypes)
+    {
+        auto &exts = rules.fileTypes[std::string(category.name)];
+        for (std::size_t i = 0; i < category.count; ++i)
+            exts.emplace_back(defaultRules::extensions[category.first + i]);
+    }
+    rules.dangerousExts.assign(defaultRules::dangerousExts.begin(), defaultRules::dangerousExts.end());
+    rules.ignoreTokens.assign(defaultRules::ignoreTokens.begin(), defaultRules::ignoreTokens.end());
+    for (const auto &route : defaultRules::routes)
+    {
+        RouteRule rule;
+        for (std::size_t i = 0; i < route.count; ++i)
+            rule.categories.emplace_back(defaultRules::routeCategories[route.first + i]);
+        rule.minSize = route.minSize;
+        rule.maxSize = route.maxSize;
+        rule.minAge = route.minAge;
+        rule.maxAge = route.maxAge;
+        rule.to = std::string(route.to);
+        rules.routes.push_back(std::move(rule));
+    }
+    return rules;
+}
+
+bool writeRuleBlob(const fs::path &file, const RuleData &rules)
+{
+    std::string pool, categories, routes, extensions, dangerous, tokens, routeCategories;
+    std::uint32_t extensionCount = 0;
+    for (const auto &[name, exts] : rules.fileTypes)
+    {
+        CategoryRef category{store(pool, name), extensionCount, static_cast<std::uint32_t>(exts.size())};
+        appendRaw(categories, category);
+        for (const auto &ext : exts)
+            appendRaw(extensions, store(pool, ext));
+        extensionCount += static_cast<std::uint32_t>(exts.size());
+    }
+    for (const auto &ext : rules.dangerousExts)
+        appendRaw(dangerous, store(pool, ext));
+    for (const auto &token : rules.ignoreTokens)
+        appendRaw(tokens, store(pool, token));
+    std::uint32_t routeCategoryCount = 0;
+    for (const auto &rule : rules.routes)
+    {
+        RouteRef route{store(pool, rule.to), routeCategoryCount, static_cast<std::uint32_t>(rule.categories.size()),
+                       rule.minSize, rule.maxSize, rule.minAge, rule.maxAge};
+        appendRaw(routes, route);
+        for (const auto &category : rule.categories)
+            appendRaw(routeCategories, store(pool, category));
+        routeCategoryCount += static_cast<std::uint32_t>(rule.categories.size());
+    }
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof Magic);
+    header.version = Version;
+    header.stampCount = static_cast<std::uint32_t>(rules.stamps.size());
+    header.categoryCount = static_cast<std::uint32_t>(rules.fileTypes.size());
+    header.extensionCount = extensionCount;
+    header.dangerousCount = static_cast<std::uint32_t>(rules.dangerousExts.size());
+    header.tokenCount = static_cast<std::uint32_t>(rules.ignoreTokens.size());
+    header.routeCount = static_cast<std::uint32_t>(rules.routes.size());
+    header.routeCategoryCount = routeCategoryCount;
+    header.poolSize = static_cast<std::uint32_t>(pool.size());
+
+    std::error_code ec;
+    fs::path temp = file;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+            return false;
+        out.write(reinterpret_cast<const char *>(&header), sizeof header);
+        for (std::int64_t stamp : rules.stamps)
+            out.write(reinterpret_cast<const char *>(&stamp), sizeof stamp);
+        out << categories << routes << extensions << dangerous << tokens << routeCategories << pool;
+        if (!out)
+        {
+            out.close();
+            fs::remove(temp, ec);
+            return false;
+        }
+    }
+    fs::rename(temp, file, ec);
+    if (ec)
+    {
+        fs::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool readRuleBlob(const fs::path &file, RuleData &rules)
+{
+    MappedFile mapped;
+    if (!mapped.open(file) || mapped.size() < sizeof(Header))
+        return false;
+
+    const char *data = mapped.data();
+    Header header;
+    std::memcpy(&header, data, sizeof header);
+    std::uint64_t refs = std::uint64_t(header.extensionCount) + header.dangerousCount + header.tokenCount +
+                         header.routeCategoryCount;
+    std::uint64_t expected = sizeof(Header) + std::uint64_t(header.stampCount) * sizeof(std::int64_t) +
+                             std::uint64_t(header.categoryCount) * sizeof(CategoryRef) +
+                             std::uint64_t(header.routeCount) * sizeof(RouteRef) + refs * sizeof(StringRef) +
+                             header.poolSize;
+    if (std::memcmp(header.magic, Magic, sizeof Magic) != 0 || header.version != Version ||
+        expected != mapped.size())
+        return false;
+
+    const char *p = data + sizeof(Header);
+    const auto *stamps = reinterpret_cast<const std::int64_t *>(p);
+    p += header.stampCount * sizeof(std::int64_t);
+    const auto *categories = reinterpret_cast<const CategoryRef *>(p);
+    p += header.categoryCount * sizeof(CategoryRef);
+    const auto *routes = reinterpret_cast<const RouteRef *>(p);
+    p += header.routeCount * sizeof(RouteRef);
+    const auto *extensions = reinterpret_cast<const StringRef *>(p);
+    const auto *dangerous = extensions + header.extensionCount;
+    const auto *tokens = dangerous + header.dangerousCount;
+    const auto *routeCategories = tokens + header.tokenCount;
+    const char *pool = reinterpret_cast<const char *>(routeCategories + header.routeCategoryCount);
+
+    bool valid = true;
+    auto text = [&](const StringRef &ref) {
+        if (std::uint64_t(ref.offset) + ref.length > header.poolSize)
+        {
+            valid = false;
+            return std::string();
+        }
+        return std::string(pool + ref.offset, ref.length);
+    };
+
+    RuleData result;
+    result.stamps.assign(stamps, stamps + header.stampCount);
+    for (std::uint32_t c = 0; c < header.categoryCount; ++c)
+    {
+        const CategoryRef &category = categories[c];
+        if (std::uint64_t(category.firstExtension) + category.extensionCount > header.extensionCount)
+            return false;
+        auto &exts = result.fileTypes[text(category.name)];
+        exts.reserve(category.extensionCount);
+        for (std::uint32_t i = 0; i < category.extensionCount; ++i)
+            exts.push_back(text(extensions[category.firstExtension + i]));
+    }
+    for (std::uint32_t i = 0; i < header.dangerousCount; ++i)
+        result.dangerousExts.push_back(text(dangerous[i]));
+    for (std::uint32_t i = 0; i < header.tokenCount; ++i)
+        result.ignoreTokens.push_back(text(tokens[i]));
+    for (std::uint32_t r = 0; r < header.routeCount; ++r)
+    {
+        const RouteRef &route = routes[r];
+        if (std::uint64_t(route.firstCategory) + route.categoryCount > header.routeCategoryCount)
+            return false;
+        RouteRule rule;
+        for (std::uint32_t i = 0; i < route.categoryCount; ++i)
+            rule.categories.push_back(text(routeCategories[route.firstCategory + i]));
+        rule.minSize = route.minSize;
+        rule.maxSize = route.maxSize;
+        rule.minAge = route.minAge;
+        rule.maxAge = route.maxAge;
+        rule.to = text(route.to);
+        result.routes.push_back(std::move(rule));
+    }
+    if (!valid)
+        return false;
+
+    rules = std::move(result);
+    return true;
+}
+
+bool writeRuleHeader(const fs::path &file, const RuleData &rules)
+{
+    std::ofstream out(file, std::ios::trunc);
+    if (!out.is_open())
+        return false;
+
+    out << "#pragma once\n"
+        << "#include <array>\n"
+        << "#include <cstddef>\n"
+        << "#include <cstdint>\n"
+        << "#include <string_view>\n"
+        << "\n"
+        << "/**\n"
+        << " * @file defaultRules.hpp\n"
+        << " * @brief Built-in rules as constexpr tables.\n"
+        << " *\n"
+        << " * Generated from the JSON files in `data/` by `clean compile-rules\n"
+        << " * --header`; do not edit by hand. These tables are the fallback when a data\n"
+        << " * file is missing and, with `CLEAN_EMBED_RULES`, the rules used without any\n"
+        << " * file I/O.\n"
+        << " */\n"
+        << "\n"
+        << "namespace defaultRules\n"
+        << "{\n"
+        << "\n"
+        << "/// One category: its name and a range of `extensions`.\n"
+        << "struct Category\n"
+        << "{\n"
+        << "    std::string_view name;\n"
+        << "    std::size_t first;\n"
+        << "    std::size_t count;\n"
+        << "};\n"
+        << "\n"
+        << "/// One routing rule: a range of `routeCategories` and its size and age bounds.\n"
+        << "struct Route\n"
+        << "{\n"
+        << "    std::string_view to;\n"
+        << "    std::size_t first;\n"
+        << "    std::size_t count;\n"
+        << "    std::uint64_t minSize;\n"
+        << "    std::uint64_t maxSize;\n"
+        << "    std::int64_t minAge;\n"
+        << "    std::int64_t maxAge;\n"
+        << "};\n"
+        << "\n";
+
+    std::vector<std::string> extensions;
+    for (const auto &[name, exts] : rules.fileTypes)
+        extensions.insert(extensions.end(), exts.begin(), exts.end());
+    writeArray(out, "extensions", extensions);
+
+    out << "inline constexpr std::array<Category, " << rules.fileTypes.size() << "> fileTypes = {{\n";
+    std::size_t first = 0;
+    for (const auto &[name, exts] : rules.fileTypes)
+    {
+        out << "    {";
+        writeLiteral(out, name);
+        out << ", " << first << ", " << exts.size() << "},\n";
+        first += exts.size();
+    }
+    out << "}};\n\n";
+
+    writeArray(out, "dangerousExts", rules.dangerousExts);
+    writeArray(out, "ignoreTokens", rules.ignoreTokens);
+
+    std::vector<std::string> routeCategories;
+    for (const auto &rule : rules.routes)
+        routeCategories.insert(routeCategories.end(), rule.categories.begin(), rule.categories.end());
+    writeArray(out, "routeCategories", routeCategories);
+
+    out << "inline constexpr std::array<Route, " << rules.routes.size() << "> routes = {{\n";
+    first = 0;
+    for (const auto &rule : rules.routes)
+    {
+        out << "    {";
+        writeLiteral(out, rule.to);
+        out << ", " << first << ", " << rule.categories.size() << ", " << rule.minSize << "u, " << rule.maxSize
+            << "u, " << rule.minAge << ", " << rule.maxAge << "},\n";
+        first += rule.categories.size();
+    }
+    out << "}};\n\n";
+    out << "} // namespace defaultRules\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,133 @@
+/**
+ * @file ruleSet.cpp
+ * @brief Publication and reloading of the shared rule set.
+ *
+ * @see ruleSet.hpp
+ */
+
+#include "ruleSet.hpp"
+#include "ruleBlob.hpp"
+#include "colors.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+    /// Data files a rule set is built from; a change to any of them triggers a reload.
+    const char *const RuleSources[] = {
+        "data/fileTypes.json",
+        "data/dangerousExts.json",
+        "data/ignoreTokens.json",
+    };
+
+    /// Published set; readers only ever load this pointer.
+    std::atomic<const RuleSet *> current{nullptr};
+
+    /// Append the size and mtime of `file` to `stamps` (-1, -1 when missing).
+    void appendStamp(std::vector<std::int64_t> &stamps, const char *file)
+    {
+        std::error_code ec;
+        auto size = fs::file_size(file, ec);
+        auto time = ec ? fs::file_time_type{} : fs::last_write_time(file, ec);
+        stamps.push_back(ec ? -1 : static_cast<std::int64_t>(size));
+        stamps.push_back(ec ? -1 : static_cast<std::int64_t>(time.time_since_epoch().count()));
+    }
+
+    /// Stamps of every file a set depends on: the JSON sources and the compiled bundle.
+    std::vector<std::int64_t> dependencyStamps()
+    {
+        std::vector<std::int64_t> stamps = ruleSourceStamps();
+        appendStamp(stamps, DefaultRuleBlob);
+        return stamps;
+    }
+
+    /// Serializes publishers and owns every set ever published.
+    std::mutex publishMutex;
+    std::vector<std::unique_ptr<const RuleSet>> published;
+
+    /**
+     * @brief Read the rules from the best available source.
+     *
+     * A compiled bundle is used when it matches the JSON files it was built
+     * from. Builds with `CLEAN_EMBED_RULES` never parse JSON: they use the
+     * bundle when present and the built-in tables otherwise.
+     */
+    RuleData loadRules()
+    {
+        RuleData rules;
+        if (readRuleBlob(DefaultRuleBlob, rules))
+        {
+#ifdef CLEAN_EMBED_RULES
+            return rules;
+#else
+            if (rules.stamps == ruleSourceStamps())
+                return rules;
+            std::cout << DIM << "[INFO] " << DefaultRuleBlob
+                      << " is out of date, reading the JSON rules (run 'clean compile-rules').\n" << RESET;
+#endif
+        }
+#ifdef CLEAN_EMBED_RULES
+        return builtinRules();
+#else
+        return loadRuleSources();
+#endif
+    }
+
+    /// Build a set from disk and make it current; `publishMutex` must be held.
+    const RuleSet &publishLocked()
+    {
+        auto stamps = dependencyStamps();
+        RuleData data = loadRules();
+        auto rules = std::make_unique<RuleSet>(std::move(data.fileTypes), std::move(data.dangerousExts),
+                                               std::move(data.ignoreTokens), std::move(data.routes));
+        rules->generation = published.size() + 1;
+        rules->stamps = std::move(stamps);
+
+        const RuleSet *raw = rules.get();
+        published.push_back(std::move(rules));
+        current.store(raw, std::memory_order_release);
+        return *raw;
+    }
+}
+
+std::vector<std::int64_t> ruleSourceStamps()
+{
+    std::vector<std::int64_t> stamps;
+    for (const char *source : RuleSources)
+        appendStamp(stamps, source);
+    return stamps;
+}
+
+const RuleSet &currentRules()
+{
+    if (const RuleSet *rules = current.load(std::memory_order_acquire))
+        return *rules;
+
+    // First use: exactly one thread loads, the others wait for it
+    std::lock_guard<std::mutex> lock(publishMutex);
+    if (const RuleSet *rules = current.load(std::memory_order_acquire))
+        return *rules;
+    return publishLocked();
+}
+
+const RuleSet &reloadRules()
+{
+    std::lock_guard<std::mutex> lock(publishMutex);
+    return publishLocked();
+}
+
+bool reloadRulesIfChanged()
+{
+    if (dependencyStamps() == currentRules().stamps)
+        return false;
+
+    std::lock_guard<std::mutex> lock(publishMutex);
+    // Another thread may have reloaded while we waited
+    if (dependencyStamps() == current.load(std::memory_order_acquire)->stamps)
+        return false;
+    publishLocked();
+    return true;
+}
@@ -0,0 +1,360 @@
+/**
+ * @file scanIndex.cpp
+ * @brief Implementation of the memory-mapped scan index.
+ *
+ * File layout (native byte order, every section 8-byte aligned):
+ *
+ *     Header
+ *     DiskDir[dirCount]       relative path, mtime, file and subdir ranges
+ *     DiskFile[fileCount]     name, size, mtime, flags, capture time
+ *     DiskSubdir[subdirCount] name
+ *     pool                    root path followed by all names
+ *
+ * @see scanIndex.hpp
+ */
+
+#include "scanIndex.hpp"
+#include "colors.hpp"
+#include "mediaDate.hpp"
+#include "progress.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+
+
+namespace
+{
+    constexpr char Magic[8] = {'C', 'L', 'N', 'I', 'D', 'X', '\0', '\1'};
+    constexpr std::uint32_t Version = 3; // 2: file mtimes on the file clock everywhere, 3: capture times
+
+    /// Largest string pool an index may hold (`FileTable` stores 32-bit offsets).
+    constexpr std::uint64_t MaxPoolBytes = std::numeric_limits<std::uint32_t>::max();
+
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t reserved;
+        std::uint64_t dirCount;
+        std::uint64_t fileCount;
+        std::uint64_t subdirCount;
+        std::uint64_t poolSize;
+        std::uint64_t rootLength;
+    };
+
+    struct DiskDir
+    {
+        std::uint64_t pathOffset;
+        std::uint32_t pathLength;
+        std::uint32_t fileCount;
+        std::int64_t mtime;
+        std::uint64_t firstFile;
+        std::uint64_t firstSubdir;
+        std::uint32_t subdirCount;
+        std::uint32_t allStat;
+    };
+
+    struct DiskFile
+    {
+        std::uint64_t nameOffset;
+        std::uint16_t nameLength;
+        std::uint8_t hasStat;
+        std::uint8_t reserved[5];
+        std::uint64_t size;
+        std::int64_t mtime;
+        std::int64_t captured;
+    };
+
+    struct DiskSubdir
+    {
+        std::uint64_t nameOffset;
+        std::uint32_t nameLength;
+        std::uint32_t reserved;
+    };
+
+    static_assert(sizeof(Header) == 56 && sizeof(DiskDir) == 48 && sizeof(DiskFile) == 40 &&
+                      sizeof(DiskSubdir) == 16,
+                  "index records must have a fixed layout");
+
+    /// Root identity stored in the index.
+    std::string rootKey(const fs::path &root)
+    {
+        std::error_code ec;
+        fs::path abs = fs::absolute(root, ec);
+        return (ec ? root : abs).lexically_normal().string();
+    }
+
+    /// Whether `[offset, offset + length)` lies within `[0, limit)` (without overflowing).
+    bool inRange(std::uint64_t offset, std::uint64_t length, std::uint64_t limit)
+    {
+        return offset <= limit && length <= limit - offset;
+    }
+
+    template <typename T>
+    void appendRaw(std::string &out, const T &value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof value);
+    }
+}
+
+void ScanIndex::unmap()
+{
+    dirs_.clear();
+    file_.close();
+    data_ = nullptr;
+    size_ = 0;
+}
+
+bool ScanIndex::load(const fs::path &file, const fs::path &root)
+{
+    unmap();
+    if (!file_.open(file) || file_.size() < sizeof(Header))
+    {
+        file_.close();
+        return false;
+    }
+    data_ = file_.data();
+    size_ = file_.size();
+
+    // Validate the header and that every section fits in the file
+    const Header *header = reinterpret_cast<const Header *>(data_);
+    std::uint64_t tableBytes = header->dirCount * sizeof(DiskDir) + header->fileCount * sizeof(DiskFile) +
+                               header->subdirCount * sizeof(DiskSubdir);
+    std::string key = rootKey(root);
+    if (std::memcmp(header->magic, Magic, sizeof Magic) != 0 || header->version != Version ||
+        header->dirCount > size_ || header->fileCount > size_ || header->subdirCount > size_ ||
+        sizeof(Header) + tableBytes + header->poolSize != size_ || header->rootLength > header->poolSize ||
+        std::string_view(data_ + sizeof(Header) + tableBytes, header->rootLength) != key)
+    {
+        unmap();
+        return false;
+    }
+
+    const char *pool = data_ + sizeof(Header) + tableBytes;
+    const DiskDir *dirs = reinterpret_cast<const DiskDir *>(data_ + sizeof(Header));
+    dirs_.reserve(header->dirCount);
+    for (std::uint64_t i = 0; i < header->dirCount; ++i)
+    {
+        const DiskDir &d = dirs[i];
+        if (!inRange(d.pathOffset, d.pathLength, header->poolSize) ||
+            !inRange(d.firstFile, d.fileCount, header->fileCount) ||
+            !inRange(d.firstSubdir, d.subdirCount, header->subdirCount))
+        {
+            unmap();
+            return false;
+        }
+        dirs_.emplace(std::string_view(pool + d.pathOffset, d.pathLength),
+                      Directory{d.mtime, d.firstFile, d.fileCount, d.subdirCount, d.firstSubdir, d.allStat != 0});
+    }
+
+    // file() and subdir() read names straight from the pool, so check every range once here
+    const DiskFile *files = reinterpret_cast<const DiskFile *>(dirs + header->dirCount);
+    for (std::uint64_t i = 0; i < header->fileCount; ++i)
+        if (!inRange(files[i].nameOffset, files[i].nameLength, header->poolSize))
+        {
+            unmap();
+            return false;
+        }
+    const DiskSubdir *subdirs = reinterpret_cast<const DiskSubdir *>(files + header->fileCount);
+    for (std::uint64_t i = 0; i < header->subdirCount; ++i)
+        if (!inRange(subdirs[i].nameOffset, subdirs[i].nameLength, header->poolSize))
+        {
+            unmap();
+            return false;
+        }
+    return true;
+}
+
+const ScanIndex::Directory *ScanIndex::find(std::string_view relative) const
+{
+    auto it = dirs_.find(relative);
+    return it == dirs_.end() ? nullptr : &it->second;
+}
+
+ScanIndex::File ScanIndex::file(std::uint64_t i) const
+{
+    const Header *header = reinterpret_cast<const Header *>(data_);
+    const char *files = data_ + sizeof(Header) + header->dirCount * sizeof(DiskDir);
+    const char *pool = files + header->fileCount * sizeof(DiskFile) + header->subdirCount * sizeof(DiskSubdir);
+    const DiskFile &f = reinterpret_cast<const DiskFile *>(files)[i];
+    return {std::string_view(pool + f.nameOffset, f.nameLength), f.size, f.mtime, f.hasStat != 0, f.captured};
+}
+
+std::string_view ScanIndex::subdir(std::uint64_t i) const
+{
+    const Header *header = reinterpret_cast<const Header *>(data_);
+    const char *subdirs = data_ + sizeof(Header) + header->dirCount * sizeof(DiskDir) +
+                          header->fileCount * sizeof(DiskFile);
+    const char *pool = subdirs + header->subdirCount * sizeof(DiskSubdir);
+    const DiskSubdir &s = reinterpret_cast<const DiskSubdir *>(subdirs)[i];
+    return std::string_view(pool + s.nameOffset, s.nameLength);
+}
+
+bool ScanIndex::save(const fs::path &file, const FileTable &table, const std::vector<DirState> &dirs)
+{
+    // Group record indices by directory (records of one directory are contiguous, but be safe)
+    std::vector<std::uint64_t> start(table.directoryCount() + 1, 0);
+    for (const FileRecord &r : table.records())
+        ++start[r.dir + 1];
+    for (std::size_t d = 1; d < start.size(); ++d)
+        start[d] += start[d - 1];
+    std::vector<std::uint64_t> order(table.size());
+    {
+        std::vector<std::uint64_t> next(start.begin(), start.end() - 1);
+        for (std::size_t i = 0; i < table.size(); ++i)
+            order[next[table[i].dir]++] = i;
+    }
+
+    std::string pool = rootKey(table.root());
+    std::uint64_t rootLength = pool.size();
+    std::string dirBytes, fileBytes, subdirBytes;
+    std::uint64_t fileCount = 0, subdirCount = 0;
+
+    for (const DirState &state : dirs)
+    {
+        std::string_view path = table.directoryPath(state.dir);
+        DiskDir d{};
+        d.pathOffset = pool.size();
+        d.pathLength = static_cast<std::uint32_t>(path.size());
+        pool.append(path);
+        d.mtime = state.mtime;
+        d.firstFile = fileCount;
+        d.firstSubdir = subdirCount;
+        d.allStat = 1;
+
+        for (std::uint64_t k = start[state.dir]; k < start[state.dir + 1]; ++k)
+        {
+            std::size_t i = order[k];
+            const FileRecord &r = table[i];
+            std::string_view name = table.name(i);
+            DiskFile f{};
+            f.nameOffset = pool.size();
+            f.nameLength = static_cast<std::uint16_t>(name.size());
+            f.hasStat = (r.flags & FileRecord::HasStat) ? 1 : 0;
+            f.size = r.size;
+            f.mtime = r.mtime;
+            f.captured = table.captured(i);
+            d.allStat = d.allStat && f.hasStat;
+            pool.append(name);
+            appendRaw(fileBytes, f);
+            ++fileCount;
+            ++d.fileCount;
+        }
+        for (const auto &name : state.subdirs)
+        {
+            DiskSubdir s{};
+            s.nameOffset = pool.size();
+            s.nameLength = static_cast<std::uint32_t>(name.size());
+            pool.append(name);
+            appendRaw(subdirBytes, s);
+            ++subdirCount;
+            ++d.subdirCount;
+        }
+        appendRaw(dirBytes, d);
+    }
+
+    // Loaded names go back into a FileTable, whose pool is addressed with 32-bit offsets
+    if (pool.size() > MaxPoolBytes)
+    {
+        std::cerr << RED << "Warning: The names of this scan exceed 4 GiB; the scan index is not saved."
+                  << RESET << "\n";
+        return false;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof Magic);
+    header.version = Version;
+    header.dirCount = dirs.size();
+    header.fileCount = fileCount;
+    header.subdirCount = subdirCount;
+    header.poolSize = pool.size();
+    header.rootLength = rootLength;
+
+    std::error_code ec;
+    if (file.has_parent_path())
+        fs::create_directories(file.parent_path(), ec);
+
+    // Write beside the target and rename over it, so readers never see a partial index
+    fs::path temp = file;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+            return false;
+        out.write(reinterpret_cast<const char *>(&header), sizeof header);
+        out << dirBytes << fileBytes << subdirBytes << pool;
+        if (!out)
+        {
+            out.close();
+            fs::remove(temp, ec);
+            return false;
+        }
+    }
+    fs::rename(temp, file, ec);
+    if (ec)
+    {
+        fs::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+fs::path defaultIndexPath(const fs::path &root)
+{
+    fs::path cache;
+#ifdef _WIN32
+    if (const char *local = std::getenv("LOCALAPPDATA"))
+        cache = fs::path(local) / "clean";
+#else
+    if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+        cache = fs::path(xdg) / "clean";
+    else if (const char *home = std::getenv("HOME"); home && *home)
+        cache = fs::path(home) / ".cache" / "clean";
+#endif
+    if (cache.empty())
+        return root / ".clean-index";
+
+    // One file per root, named after a hash of its absolute path
+    char name[32];
+    std::snprintf(name, sizeof name, "%016zx.idx", std::hash<std::string>{}(rootKey(root)));
+    return cache / name;
+}
+
+FileTable scanDirectoryIndexed(const fs::path &root, const ScanOptions &options, const fs::path &indexFile)
+{
+    if (indexFile.empty())
+    {
+        FileTable table = scanDirectory(root, options);
+        if (options.withDates)
+            readCaptureDates(table, options.threads);
+        return table;
+    }
+
+    std::vector<DirState> states;
+    FileTable table;
+    {
+        ScanIndex previous;
+        bool loaded = previous.load(indexFile, root);
+        table = scanDirectory(root, options, loaded ? &previous : nullptr, &states);
+        if (options.withDates)
+            readCaptureDates(table, options.threads); // only files the index had no date for
+    } // unmapped before the file is replaced
+
+    // A cancelled scan keeps the previous index, which is still valid
+    bool cancelled = options.progress && options.progress->cancelled();
+    if (!cancelled && !ScanIndex::save(indexFile, table, states))
+        std::cerr << RED << "Warning: Could not write scan index " << indexFile << RESET << "\n";
+
+    // The index must never be organized itself
+    std::string indexName = indexFile.filename().string();
+    for (std::size_t i = table.size(); i-- > 0;)
+        if (table.name(i) == indexName && fs::absolute(table.path(i)).lexically_normal() ==
+                                              fs::absolute(indexFile).lexically_normal())
+            table.erase(i);
+    return table;
+}
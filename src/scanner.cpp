@@ -0,0 +1,560 @@
+/**
+ * @file scanner.cpp
+ * @brief Implementation of the shared, optionally parallel directory scanner.
+ *
+ * Each directory is one task: the worker lists it, appends regular files to
+ * a per-worker `FileTable` and submits every subdirectory as a new task.
+ * The per-worker tables are concatenated once the pool is idle, so the hot
+ * loop never contends on a shared container.
+ *
+ * @see scanner.hpp
+ */
+
+#include "scanner.hpp"
+#include "threadPool.hpp"
+#include "colors.hpp"
+#include "stats.hpp"
+#include "classifier.hpp"
+#include "scanIndex.hpp"
+#include "progress.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief List one directory.
+ *
+ * @param dir     Directory to list.
+ * @param onFile  Called with the `fs::directory_entry` of every regular file in `dir`.
+ * @param subdirs When non-null, receives the subdirectories of `dir`.
+ */
+template <typename OnFile>
+static void scanOne(const fs::path &dir, OnFile &&onFile, std::vector<fs::path> *subdirs)
+{
+    std::error_code ec;
+    fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec);
+    runStats().addCalls(Phase::Scan);
+    if (ec)
+    {
+        runStats().addErrors(Phase::Scan);
+        std::cerr << RED << "Warning: Could not open directory " << dir
+                  << ": " << ec.message() << RESET << "\n";
+        return;
+    }
+
+    for (const fs::directory_iterator end; it != end; it.increment(ec))
+    {
+        if (ec)
+            break;
+
+        const fs::directory_entry &entry = *it;
+        std::error_code typeEc;
+        if (entry.is_symlink(typeEc))
+        {
+            // Links to files are organized like files; links to directories are not followed
+            runStats().addCalls(Phase::Scan); // resolving the target needs a stat()
+            if (entry.is_regular_file(typeEc))
+                onFile(entry);
+            continue;
+        }
+        if (entry.is_regular_file(typeEc))
+            onFile(entry);
+        else if (subdirs && entry.is_directory(typeEc))
+            subdirs->push_back(entry.path());
+    }
+
+    if (ec)
+    {
+        runStats().addErrors(Phase::Scan);
+        std::cerr << RED << "Warning: Error while reading " << dir
+                  << ": " << ec.message() << RESET << "\n";
+    }
+}
+
+/**
+ * @brief File name part of a path as a view into its native string.
+ *
+ * @param p       Path produced by a directory iterator.
+ * @param scratch Storage used where native strings are not `char` based.
+ */
+static std::string_view leafName(const fs::path &p, std::string &scratch)
+{
+#ifdef _WIN32
+    scratch = p.filename().string();
+    return scratch;
+#else
+    (void)scratch;
+    std::string_view full = p.native();
+    std::size_t slash = full.rfind('/');
+    return slash == std::string_view::npos ? full : full.substr(slash + 1);
+#endif
+}
+
+#ifndef _WIN32
+/**
+ * @brief Copy size and modification time from a `stat` result into a record.
+ *
+ * `stat` reports Unix time; it is converted to the file clock so that
+ * records compare with `fs::file_time_type` on every platform.
+ */
+static void fillStat(FileRecord &record, const struct stat &st)
+{
+    using namespace std::chrono;
+    record.size = static_cast<std::uint64_t>(st.st_size);
+#if defined(__APPLE__)
+    const struct timespec &ts = st.st_mtimespec;
+#else
+    const struct timespec &ts = st.st_mtim;
+#endif
+    sys_time<nanoseconds> written(seconds(ts.tv_sec) + nanoseconds(ts.tv_nsec));
+    record.mtime = duration_cast<nanoseconds>(fs::file_time_type::clock::from_sys(written).time_since_epoch()).count();
+    record.flags |= FileRecord::HasStat;
+}
+#endif
+
+bool statRecord(const fs::path &file, FileRecord &record)
+{
+    runStats().addCalls(Phase::Scan);
+#ifdef _WIN32
+    std::error_code ec;
+    auto size = fs::file_size(file, ec);
+    auto mtime = ec ? fs::file_time_type{} : fs::last_write_time(file, ec);
+    if (ec)
+        return false;
+    record.size = size;
+    record.mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+    record.flags |= FileRecord::HasStat;
+    return true;
+#else
+    struct stat st;
+    if (::stat(file.c_str(), &st) != 0)
+        return false;
+    fillStat(record, st);
+    return true;
+#endif
+}
+
+/**
+ * @brief Adds each listed file of one directory to a `FileTable`.
+ */
+struct CollectRecords
+{
+    FileTable &table;
+    std::uint32_t dir;
+    const ExtClassifier &classifier;
+    bool withStat;
+    std::string scratch;
+
+    void operator()(const fs::directory_entry &entry)
+    {
+        FileRecord &record = table.add(dir, leafName(entry.path(), scratch), classifier);
+        if (!withStat)
+            return;
+
+        runStats().addCalls(Phase::Scan);
+#ifdef _WIN32
+        std::error_code ec;
+        auto size = entry.file_size(ec);
+        auto mtime = entry.last_write_time(ec);
+        if (ec)
+            return;
+        record.size = size;
+        record.mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+        record.flags |= FileRecord::HasStat;
+#else
+        struct stat st;
+        if (::stat(entry.path().c_str(), &st) == 0)
+            fillStat(record, st);
+#endif
+    }
+};
+
+#if defined(__linux__)
+/// Record layout returned by `getdents64()`.
+struct LinuxDirent64
+{
+    std::uint64_t d_ino;
+    std::int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+/**
+ * @brief List one directory into `table` with raw `getdents64()`.
+ *
+ * Names are taken straight from the kernel buffer together with their
+ * `d_type`, so no `fs::path` is built per entry and no `stat()` is issued
+ * unless the filesystem does not report types, the entry is a symbolic
+ * link, or `withStat` asks for sizes. Those lookups go through the open
+ * directory descriptor (`fstatat()`) rather than a full path.
+ *
+ * Behaves like `scanOne()` + `CollectRecords`: links to files are
+ * collected, links to directories are not followed, and unreadable
+ * directories are reported (permission errors are skipped silently).
+ */
+static void listRecords(const fs::path &dir, FileTable &table, std::uint32_t d, const ExtClassifier &classifier,
+                        bool withStat, std::vector<std::string> *subdirNames)
+{
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    runStats().addCalls(Phase::Scan);
+    if (fd < 0)
+    {
+        if (errno == EACCES)
+            return;
+        runStats().addErrors(Phase::Scan);
+        std::cerr << RED << "Warning: Could not open directory " << dir
+                  << ": " << std::strerror(errno) << RESET << "\n";
+        return;
+    }
+
+    alignas(LinuxDirent64) char buffer[32 * 1024];
+    for (;;)
+    {
+        long n = ::syscall(SYS_getdents64, fd, buffer, sizeof buffer);
+        runStats().addCalls(Phase::Scan);
+        if (n == 0)
+            break;
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            runStats().addErrors(Phase::Scan);
+            std::cerr << RED << "Warning: Error while reading " << dir
+                      << ": " << std::strerror(errno) << RESET << "\n";
+            break;
+        }
+
+        for (long offset = 0; offset < n;)
+        {
+            const auto *entry = reinterpret_cast<const LinuxDirent64 *>(buffer + offset);
+            offset += entry->d_reclen;
+            std::string_view name(entry->d_name);
+            if (name == "." || name == "..")
+                continue;
+
+            unsigned char type = entry->d_type;
+            struct stat st;
+            bool haveStat = false;
+            if (type == DT_UNKNOWN || type == DT_LNK)
+            {
+                // Links are resolved to their target; unknown types need an lstat first
+                runStats().addCalls(Phase::Scan);
+                if (::fstatat(fd, entry->d_name, &st, type == DT_LNK ? 0 : AT_SYMLINK_NOFOLLOW) != 0)
+                    continue;
+                if (type == DT_UNKNOWN && S_ISLNK(st.st_mode))
+                {
+                    type = DT_LNK;
+                    runStats().addCalls(Phase::Scan);
+                    if (::fstatat(fd, entry->d_name, &st, 0) != 0)
+                        continue;
+                }
+                else if (type == DT_UNKNOWN)
+                {
+                    type = S_ISREG(st.st_mode) ? DT_REG : S_ISDIR(st.st_mode) ? DT_DIR : DT_UNKNOWN;
+                }
+                haveStat = true;
+                if (type == DT_LNK && !S_ISREG(st.st_mode))
+                    continue; // links to directories are not followed
+                if (type == DT_LNK)
+                    type = DT_REG;
+            }
+
+            if (type == DT_REG)
+            {
+                FileRecord &record = table.add(d, name, classifier);
+                if (!withStat)
+                    continue;
+                if (!haveStat)
+                {
+                    runStats().addCalls(Phase::Scan);
+                    if (::fstatat(fd, entry->d_name, &st, 0) != 0)
+                        continue;
+                }
+                fillStat(record, st);
+            }
+            else if (type == DT_DIR && subdirNames)
+            {
+                subdirNames->emplace_back(name);
+            }
+        }
+    }
+    ::close(fd);
+}
+#endif
+
+/**
+ * @brief List one directory into `table` (files) and `subdirNames` (subdirectories).
+ */
+static void listInto(const fs::path &dir, FileTable &table, std::uint32_t d, const ExtClassifier &classifier,
+                     bool withStat, std::vector<std::string> *subdirNames)
+{
+#if defined(__linux__)
+    listRecords(dir, table, d, classifier, withStat, subdirNames);
+#else
+    std::vector<fs::path> subdirs;
+    std::string scratch;
+    scanOne(dir, CollectRecords{table, d, classifier, withStat, {}}, subdirNames ? &subdirs : nullptr);
+    for (const auto &sub : subdirs)
+        subdirNames->emplace_back(leafName(sub, scratch));
+#endif
+}
+
+/// Relative path of a subdirectory, given its parent's relative path and its name.
+static std::string childPath(const std::string &parent, std::string_view name)
+{
+    if (parent.empty())
+        return std::string(name);
+    std::string out;
+    out.reserve(parent.size() + 1 + name.size());
+    out.append(parent).append(1, '/').append(name);
+    return out;
+}
+
+/// Modification time of a directory in file-clock nanoseconds, or `ScanIndex::Dirty`.
+static std::int64_t directoryMtime(const fs::path &dir)
+{
+    std::error_code ec;
+    auto time = fs::last_write_time(dir, ec);
+    runStats().addCalls(Phase::Scan);
+    if (ec)
+        return ScanIndex::Dirty;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+namespace
+{
+    /// Settings shared by every directory visit of one scan.
+    struct ScanContext
+    {
+        const ScanOptions &options;
+        const ExtClassifier &classifier;
+        bool indexed;                // collect `DirState`s for a new index
+        const ScanIndex *previous;   // entries of the last scan, may be null
+        std::int64_t racyLimit;      // mtimes at or after this are stored as dirty
+    };
+}
+
+/**
+ * @brief Copy the index's capture dates to re-listed files that did not change.
+ *
+ * A file keeps its date when its name, size and mtime match the index.
+ *
+ * @param previous Index of the last scan.
+ * @param prev     Recorded state of the directory.
+ * @param table    Table the directory was listed into.
+ * @param first    First record of the directory in `table`.
+ */
+static void carryCaptureDates(const ScanIndex &previous, const ScanIndex::Directory &prev, FileTable &table,
+                              std::size_t first)
+{
+    std::unordered_map<std::string_view, ScanIndex::File> known;
+    for (std::uint32_t n = 0; n < prev.fileCount; ++n)
+    {
+        ScanIndex::File f = previous.file(prev.firstFile + n);
+        if (f.hasStat && f.captured != FileTable::DateUnread)
+            known.emplace(f.name, f);
+    }
+    if (known.empty())
+        return;
+    for (std::size_t i = first; i < table.size(); ++i)
+    {
+        auto it = known.find(table.name(i));
+        const FileRecord &r = table[i];
+        if (it != known.end() && (r.flags & FileRecord::HasStat) && it->second.size == r.size &&
+            it->second.mtime == r.mtime)
+            table.setCaptured(i, it->second.captured);
+    }
+}
+
+/**
+ * @brief List one directory into `table`, or reuse its entries from the index.
+ *
+ * @param ctx         Scan settings.
+ * @param dir         Directory to visit.
+ * @param relative    `dir` relative to the root.
+ * @param descend     Whether subdirectories will be visited.
+ * @param table       Receives the files.
+ * @param states      Receives the directory state when indexing.
+ * @param subdirNames Receives the names of the subdirectories to visit.
+ */
+static void visitDirectory(const ScanContext &ctx, const fs::path &dir, const std::string &relative,
+                           bool descend, FileTable &table, std::vector<DirState> &states,
+                           std::vector<std::string> &subdirNames)
+{
+    std::uint32_t d = table.addDirectory(relative);
+    subdirNames.clear();
+
+    if (!ctx.indexed)
+    {
+        listInto(dir, table, d, ctx.classifier, ctx.options.withStat, descend ? &subdirNames : nullptr);
+        return;
+    }
+
+    std::int64_t mtime = directoryMtime(dir);
+    const ScanIndex::Directory *prev = ctx.previous ? ctx.previous->find(relative) : nullptr;
+    if (prev && mtime != ScanIndex::Dirty && prev->mtime == mtime &&
+        (!ctx.options.withStat || prev->allStat))
+    {
+        // Unchanged since the last scan: no listing needed
+        for (std::uint32_t n = 0; n < prev->fileCount; ++n)
+        {
+            ScanIndex::File f = ctx.previous->file(prev->firstFile + n);
+            FileRecord &record = table.add(d, f.name, ctx.classifier);
+            if (f.hasStat)
+            {
+                record.size = f.size;
+                record.mtime = f.mtime;
+                record.flags |= FileRecord::HasStat;
+            }
+            if (ctx.options.withDates && f.captured != FileTable::DateUnread)
+                table.setCaptured(table.size() - 1, f.captured);
+        }
+        for (std::uint32_t n = 0; n < prev->subdirCount; ++n)
+            subdirNames.emplace_back(ctx.previous->subdir(prev->firstSubdir + n));
+    }
+    else
+    {
+        // Subdirectories are always recorded so a later, deeper scan can reuse them
+        std::size_t first = table.size();
+        listInto(dir, table, d, ctx.classifier, ctx.options.withStat, &subdirNames);
+        if (prev && ctx.options.withDates)
+            carryCaptureDates(*ctx.previous, *prev, table, first);
+    }
+
+    bool racy = mtime != ScanIndex::Dirty && mtime >= ctx.racyLimit;
+    states.push_back({d, racy ? ScanIndex::Dirty : mtime, subdirNames});
+    if (!descend)
+        subdirNames.clear();
+}
+
+FileTable scanDirectory(const fs::path &root, const ScanOptions &options)
+{
+    return scanDirectory(root, options, nullptr, nullptr);
+}
+
+FileTable scanDirectory(const fs::path &root, const ScanOptions &options,
+                        const ScanIndex *previous, std::vector<DirState> *states)
+{
+    PhaseTimer timer(Phase::Scan);
+
+    // Directories touched this close to the scan may change again within the same mtime tick
+    auto now = fs::file_time_type::clock::now();
+    std::int64_t racyLimit =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count() - 2000000000LL;
+    const ExtClassifier &classifier = options.classifier ? *options.classifier : getClassifier();
+    ScanContext ctx{options, classifier, states != nullptr, previous, racyLimit};
+
+    FileTable table(root);
+    std::vector<DirState> unusedStates;
+    std::vector<DirState> &rootStates = states ? *states : unusedStates;
+
+    if (!options.recursive || options.maxDepth == 0)
+    {
+        std::vector<std::string> subdirNames;
+        if (!options.progress || !options.progress->cancelled())
+            visitDirectory(ctx, root, std::string(), false, table, rootStates, subdirNames);
+        if (options.progress)
+            options.progress->advance(table.size());
+        runStats().addItems(Phase::Scan, table.size());
+        return table;
+    }
+
+    std::optional<ThreadPool> ownPool;
+    ThreadPool &pool = options.pool ? *options.pool : ownPool.emplace(options.threads);
+    std::vector<FileTable> perWorker(pool.size(), FileTable(root));
+    std::vector<std::vector<DirState>> perWorkerStates(pool.size());
+
+    // Held by std::function so a directory task can submit its children
+    std::function<void(const fs::path &, const std::string &, int)> visit =
+        [&](const fs::path &dir, const std::string &relative, int depth) {
+            if (options.progress && options.progress->cancelled())
+                return; // pending directories are dropped as they come up
+            bool descend = options.maxDepth < 0 || depth < options.maxDepth;
+            std::vector<std::string> subdirNames;
+
+            unsigned worker = ThreadPool::currentWorker();
+            std::size_t before = perWorker[worker].size();
+            visitDirectory(ctx, dir, relative, descend, perWorker[worker], perWorkerStates[worker], subdirNames);
+            if (options.progress)
+                options.progress->advance(perWorker[worker].size() - before);
+
+            for (auto &name : subdirNames)
+            {
+                std::string childRelative = childPath(relative, name);
+                if (!options.exclude.empty() &&
+                    std::find(options.exclude.begin(), options.exclude.end(), childRelative) !=
+                        options.exclude.end())
+                    continue;
+                fs::path sub = dir / name;
+                pool.submit([&visit, sub = std::move(sub), childRelative = std::move(childRelative), depth] {
+                    visit(sub, childRelative, depth + 1);
+                });
+            }
+        };
+
+    pool.submit([&visit, &root] { visit(root, std::string(), 0); });
+    pool.wait();
+
+    for (std::size_t w = 0; w < perWorker.size(); ++w)
+    {
+        // Directory indices shift by the directories merged before this worker's
+        auto dirBase = static_cast<std::uint32_t>(table.directoryCount());
+        table.append(std::move(perWorker[w]));
+        for (auto &state : perWorkerStates[w])
+        {
+            state.dir += dirBase;
+            rootStates.push_back(std::move(state));
+        }
+    }
+    runStats().addItems(Phase::Scan, table.size());
+    return table;
+}
+
+void scanEach(const fs::path &root, const ScanOptions &options,
+              const std::function<void(const fs::directory_entry &)> &onFile)
+{
+    PhaseTimer timer(Phase::Scan);
+    std::uint64_t found = 0;
+    auto visitFile = [&](const fs::directory_entry &entry) {
+        ++found;
+        onFile(entry);
+    };
+
+    // Depth-first with an explicit stack: only pending directories are held
+    std::vector<std::pair<fs::path, int>> pending{{root, 0}};
+    std::vector<fs::path> subdirs;
+    while (!pending.empty())
+    {
+        auto [dir, depth] = std::move(pending.back());
+        pending.pop_back();
+
+        bool descend = options.recursive && (options.maxDepth < 0 || depth < options.maxDepth);
+        subdirs.clear();
+        scanOne(dir, visitFile, descend ? &subdirs : nullptr);
+
+        // Reverse so subdirectories are visited in listing order
+        for (auto it = subdirs.rbegin(); it != subdirs.rend(); ++it)
+            pending.emplace_back(std::move(*it), depth + 1);
+    }
+    runStats().addItems(Phase::Scan, found);
+}
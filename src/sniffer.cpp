@@ -0,0 +1,264 @@
+/**
+ * @file sniffer.cpp
+ * @brief Implementation of the magic-number sniffer.
+ *
+ * @see sniffer.hpp
+ */
+
+#include "sniffer.hpp"
+#include "stats.hpp"
+#include "threadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std::string_view_literals;
+
+namespace
+{
+    /// Batches smaller than this are read on the calling thread.
+    constexpr std::size_t ParallelThreshold = 64;
+
+    /// Files handed to a worker at a time.
+    constexpr std::size_t Chunk = 256;
+
+    /**
+     * @brief One built-in signature: `magic` at `offset` (and `magic2` at `offset2`).
+     *
+     * A null category marks an executable, which is flagged dangerous.
+     * Within one first byte the more specific entries come first.
+     */
+    struct Signature
+    {
+        const char *category;
+        std::uint16_t offset;
+        std::string_view magic;
+        std::uint16_t offset2 = 0;
+        std::string_view magic2 = {};
+    };
+
+    constexpr Signature Signatures[] = {
+        // Images
+        {"Images", 0, "\x89PNG\r\n\x1A\n"sv},
+        {"Images", 0, "\xFF\xD8\xFF"sv},
+        {"Images", 0, "GIF87a"sv},
+        {"Images", 0, "GIF89a"sv},
+        {"Images", 0, "II*\0"sv},
+        {"Images", 0, "MM\0*"sv},
+        {"Images", 0, "RIFF"sv, 8, "WEBP"sv},
+        {"Images", 0, "<svg"sv},
+        {"Images", 4, "ftypheic"sv},
+        {"Images", 4, "ftypheix"sv},
+        {"Images", 4, "ftypmif1"sv},
+        {"Images", 4, "ftypavif"sv},
+        // Audio
+        {"Audio", 0, "ID3"sv},
+        {"Audio", 0, "fLaC"sv},
+        {"Audio", 0, "OggS"sv},
+        {"Audio", 0, "RIFF"sv, 8, "WAVE"sv},
+        {"Audio", 0, "FORM"sv, 8, "AIFF"sv},
+        {"Audio", 0, "MThd"sv},
+        {"Audio", 0, "\xFF\xFB"sv},
+        {"Audio", 0, "\xFF\xF3"sv},
+        {"Audio", 0, "\xFF\xF1"sv},
+        {"Audio", 4, "ftypM4A"sv},
+        // Videos
+        {"Videos", 0, "\x1A\x45\xDF\xA3"sv},
+        {"Videos", 0, "RIFF"sv, 8, "AVI "sv},
+        {"Videos", 0, "FLV\x01"sv},
+        {"Videos", 0, "\x30\x26\xB2\x75\x8E\x66\xCF\x11"sv},
+        {"Videos", 0, "\0\0\x01\xBA"sv},
+        {"Videos", 0, "\0\0\x01\xB3"sv},
+        {"Videos", 4, "ftyp"sv},
+        // Documents (before the generic ZIP entry: OOXML and EPUB are ZIP files)
+        {"Documents", 0, "%PDF-"sv},
+        {"Documents", 0, "%!PS"sv},
+        {"Documents", 0, "{\\rtf"sv},
+        {"Documents", 0, "\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1"sv},
+        {"Documents", 0, "PK\x03\x04"sv, 30, "mimetypeapplication/epub+zip"sv},
+        {"Documents", 0, "PK\x03\x04"sv, 30, "[Content_Types].xml"sv},
+        {"Documents", 0, "PK\x03\x04"sv, 30, "word/"sv},
+        {"Documents", 0, "PK\x03\x04"sv, 30, "xl/"sv},
+        {"Documents", 0, "PK\x03\x04"sv, 30, "ppt/"sv},
+        // Archives
+        {"Archives", 0, "PK\x03\x04"sv},
+        {"Archives", 0, "PK\x05\x06"sv},
+        {"Archives", 0, "Rar!\x1A\x07"sv},
+        {"Archives", 0, "7z\xBC\xAF\x27\x1C"sv},
+        {"Archives", 0, "\x1F\x8B"sv},
+        {"Archives", 0, "BZh"sv},
+        {"Archives", 0, "\xFD" "7zXZ\0"sv},
+        {"Archives", 257, "ustar"sv},
+        // Fonts
+        {"Fonts", 0, "\0\x01\0\0\0"sv},
+        {"Fonts", 0, "OTTO"sv},
+        {"Fonts", 0, "wOFF"sv},
+        {"Fonts", 0, "wOF2"sv},
+        // Disk images and packages
+        {"DiskImages", 0, "KDMV"sv},
+        {"DiskImages", 0, "<<< Oracle VM VirtualBox Disk Image >>>"sv},
+        {"DiskImages", 0, "conectix"sv},
+        {"Packages", 0, "!<arch>\ndebian"sv},
+        {"Packages", 0, "\xED\xAB\xEE\xDB"sv},
+        // Markup
+        {"Code", 0, "<?xml"sv},
+        {"Code", 0, "<!DOCTYPE html"sv},
+        {"Code", 0, "<html"sv},
+        // Executables
+        {nullptr, 0, "\x7F" "ELF"sv},
+        {nullptr, 0, "MZ"sv},
+        {nullptr, 0, "\xCF\xFA\xED\xFE"sv},
+        {nullptr, 0, "\xCE\xFA\xED\xFE"sv},
+        {nullptr, 0, "\xCA\xFE\xBA\xBE"sv},
+        {nullptr, 0, "#!"sv},
+    };
+
+    /**
+     * @brief Read up to `Sniffer::HeadSize` bytes from the start of `file`.
+     *
+     * @return long Bytes read, or -1 when the file cannot be opened or read.
+     */
+    long readHead(const fs::path &file, char *buffer)
+    {
+#ifdef _WIN32
+        HANDLE handle = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+            return -1;
+        DWORD got = 0;
+        BOOL ok = ReadFile(handle, buffer, static_cast<DWORD>(Sniffer::HeadSize), &got, nullptr);
+        CloseHandle(handle);
+        return ok ? static_cast<long>(got) : -1;
+#else
+        // Non-blocking so a file swapped for a FIFO after the scan cannot stall the run
+        int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK);
+        if (fd < 0)
+            return -1;
+        ssize_t got = ::pread(fd, buffer, Sniffer::HeadSize, 0);
+        ::close(fd);
+        return static_cast<long>(got);
+#endif
+    }
+}
+
+Sniffer::Sniffer(const ExtClassifier &classifier)
+{
+    for (const Signature &s : Signatures)
+    {
+        Classification result{classifier.otherCategory(), s.category == nullptr};
+        if (s.category)
+        {
+            result.category = classifier.findCategory(s.category);
+            if (result.category == classifier.otherCategory())
+                continue; // the rules do not define this category
+        }
+
+        Rule rule{s.offset, s.magic, s.offset2, s.magic2, result};
+        if (s.offset == 0)
+            byFirstByte_[static_cast<unsigned char>(s.magic[0])].push_back(rule);
+        else
+            atOffset_.push_back(rule);
+    }
+}
+
+bool Sniffer::matches(const Rule &rule, std::string_view head)
+{
+    if (head.substr(std::min<std::size_t>(rule.offset, head.size()), rule.magic.size()) != rule.magic)
+        return false;
+    return rule.magic2.empty() ||
+           head.substr(std::min<std::size_t>(rule.offset2, head.size()), rule.magic2.size()) == rule.magic2;
+}
+
+bool Sniffer::sniff(std::string_view head, Classification &result) const
+{
+    if (head.empty())
+        return false;
+
+    // Only the rules sharing the first byte are compared, then the few at other offsets
+    for (const Rule &rule : byFirstByte_[static_cast<unsigned char>(head[0])])
+        if (matches(rule, head))
+        {
+            result = rule.result;
+            return true;
+        }
+    for (const Rule &rule : atOffset_)
+        if (matches(rule, head))
+        {
+            result = rule.result;
+            return true;
+        }
+    return false;
+}
+
+std::size_t sniffTypes(FileTable &files, unsigned threads)
+{
+    PhaseTimer timer(Phase::Sniff);
+    const ExtClassifier &classifier = files.classifier();
+
+    // Only unrecognized files are opened
+    std::vector<std::size_t> candidates;
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        const FileRecord &r = files[i];
+        if (r.category != classifier.otherCategory() || (r.flags & FileRecord::Dangerous))
+            continue;
+        if ((r.flags & FileRecord::HasStat) && r.size == 0)
+            continue; // nothing to sniff
+        candidates.push_back(i);
+    }
+    runStats().addItems(Phase::Sniff, candidates.size());
+    if (candidates.empty())
+        return 0;
+
+    const Sniffer sniffer(classifier);
+    std::atomic<std::size_t> recognized{0};
+
+    // Records of a chunk are only touched by the worker that reads them
+    auto sniffRange = [&](std::size_t begin, std::size_t end) {
+        char head[Sniffer::HeadSize];
+        std::size_t found = 0;
+        for (std::size_t c = begin; c < end; ++c)
+        {
+            FileRecord &record = files[candidates[c]];
+            runStats().addCalls(Phase::Sniff);
+            long got = readHead(files.path(candidates[c]), head);
+            if (got < 0)
+            {
+                runStats().addErrors(Phase::Sniff);
+                continue;
+            }
+            Classification result;
+            if (!sniffer.sniff(std::string_view(head, static_cast<std::size_t>(got)), result))
+                continue;
+            record.category = result.category;
+            if (result.dangerous)
+                record.flags |= FileRecord::Dangerous;
+            ++found;
+        }
+        recognized.fetch_add(found, std::memory_order_relaxed);
+    };
+
+    if (threads == 0)
+        threads = ThreadPool::defaultThreads();
+    if (threads <= 1 || candidates.size() < ParallelThreshold)
+    {
+        sniffRange(0, candidates.size());
+        return recognized.load();
+    }
+
+    ThreadPool pool(static_cast<unsigned>(std::min<std::size_t>(threads, (candidates.size() + Chunk - 1) / Chunk)));
+    for (std::size_t begin = 0; begin < candidates.size(); begin += Chunk)
+    {
+        std::size_t end = std::min(begin + Chunk, candidates.size());
+        pool.submit([&, begin, end] { sniffRange(begin, end); });
+    }
+    pool.wait();
+    return recognized.load();
+}
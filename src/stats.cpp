@@ -0,0 +1,137 @@
+/**
+ * @file stats.cpp
+ * @brief Implementation of the run statistics reports.
+ *
+ * @see stats.hpp
+ */
+
+#include "stats.hpp"
+#include "colors.hpp"
+#include "json.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using json = nlohmann::json;
+
+const char *phaseName(Phase phase)
+{
+    switch (phase)
+    {
+    case Phase::Scan:
+        return "scan";
+    case Phase::Classify:
+        return "classify";
+    case Phase::Sniff:
+        return "sniff";
+    case Phase::Metadata:
+        return "metadata";
+    case Phase::Dedupe:
+        return "dedupe";
+    case Phase::Mkdir:
+        return "mkdir";
+    case Phase::Move:
+        return "move";
+    }
+    return "unknown";
+}
+
+RunStats &runStats()
+{
+    static RunStats stats;
+    return stats;
+}
+
+void RunStats::recordMove(const fs::path &source, const fs::path &destination, std::uint64_t nanos)
+{
+    if (!enabled() || nanos <= slowCutoff_.load(std::memory_order_relaxed))
+        return;
+
+    std::lock_guard<std::mutex> lock(slowMutex_);
+    auto pos = std::find_if(slowest_.begin(), slowest_.end(),
+                            [&](const SlowMove &m) { return m.nanos < nanos; });
+    slowest_.insert(pos, SlowMove{source, destination, nanos});
+    if (slowest_.size() > SlowestKept)
+        slowest_.pop_back();
+    if (slowest_.size() == SlowestKept)
+        slowCutoff_.store(slowest_.back().nanos, std::memory_order_relaxed);
+}
+
+PhaseTotals RunStats::totals(Phase phase) const
+{
+    const Counters &c = phases_[static_cast<std::size_t>(phase)];
+    return {c.nanos.load(std::memory_order_relaxed), c.items.load(std::memory_order_relaxed),
+            c.calls.load(std::memory_order_relaxed), c.errors.load(std::memory_order_relaxed)};
+}
+
+std::vector<SlowMove> RunStats::slowest() const
+{
+    std::lock_guard<std::mutex> lock(slowMutex_);
+    return slowest_;
+}
+
+/// Items per second, or 0 for a phase that took no measurable time.
+static double throughput(const PhaseTotals &t)
+{
+    return t.nanos ? t.items * 1e9 / static_cast<double>(t.nanos) : 0.0;
+}
+
+void RunStats::print(std::ostream &out) const
+{
+    out << BOLD << "Statistics" << RESET << "\n"
+        << DIM << std::left << std::setw(10) << "phase" << std::right
+        << std::setw(12) << "ms" << std::setw(12) << "items" << std::setw(14) << "items/s"
+        << std::setw(12) << "calls" << std::setw(10) << "errors" << RESET << "\n";
+
+    for (std::size_t p = 0; p < PhaseCount; ++p)
+    {
+        PhaseTotals t = totals(static_cast<Phase>(p));
+        out << std::left << std::setw(10) << phaseName(static_cast<Phase>(p)) << std::right
+            << std::fixed << std::setprecision(1)
+            << std::setw(12) << t.nanos / 1e6 << std::setw(12) << t.items
+            << std::setprecision(0) << std::setw(14) << throughput(t)
+            << std::setw(12) << t.calls << std::setw(10) << t.errors << "\n";
+    }
+    out << std::defaultfloat << std::setprecision(6);
+
+    std::vector<SlowMove> slow = slowest();
+    if (slow.empty())
+        return;
+    out << DIM << "Slowest moves:" << RESET << "\n";
+    for (const auto &m : slow)
+        out << "  " << std::fixed << std::setprecision(2) << m.nanos / 1e6 << " ms  "
+            << m.source.string() << DIM << " -> " << RESET << m.destination.string() << "\n";
+    out << std::defaultfloat << std::setprecision(6);
+}
+
+bool RunStats::saveJson(const fs::path &file) const
+{
+    json report;
+    json phases = json::object();
+    for (std::size_t p = 0; p < PhaseCount; ++p)
+    {
+        PhaseTotals t = totals(static_cast<Phase>(p));
+        phases[phaseName(static_cast<Phase>(p))] = {
+            {"seconds", t.nanos / 1e9},
+            {"items", t.items},
+            {"itemsPerSecond", throughput(t)},
+            {"calls", t.calls},
+            {"errors", t.errors}};
+    }
+    report["phases"] = phases;
+
+    json slow = json::array();
+    for (const auto &m : slowest())
+        slow.push_back({{"source", m.source.string()},
+                        {"destination", m.destination.string()},
+                        {"seconds", m.nanos / 1e9}});
+    report["slowestMoves"] = slow;
+
+    std::ofstream out(file, std::ios::binary);
+    if (!out.is_open())
+        return false;
+    out << report.dump(2) << "\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,158 @@
+/**
+ * @file threadPool.cpp
+ * @brief Implementation of the work-stealing `ThreadPool`.
+ *
+ * @see threadPool.hpp
+ */
+
+#include "threadPool.hpp"
+
+namespace
+{
+    /// Pool owning the current thread, if it is a worker.
+    thread_local const void *tlsPool = nullptr;
+
+    /// Index of the current thread inside `tlsPool`.
+    thread_local int tlsWorker = -1;
+}
+
+unsigned ThreadPool::defaultThreads()
+{
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+int ThreadPool::currentWorker()
+{
+    return tlsWorker;
+}
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0)
+        threads = defaultThreads();
+
+    queues_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i)
+        queues_.push_back(std::make_unique<Queue>());
+
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i)
+        workers_.emplace_back([this, i] { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        allDone_.wait(lock, [this] { return pending_.load() == 0; });
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+    for (auto &t : workers_)
+        t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    // Tasks spawned by a worker stay local; external submissions round-robin.
+    unsigned target;
+    if (tlsPool == this && tlsWorker >= 0)
+        target = static_cast<unsigned>(tlsWorker);
+    else
+        target = nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+    pending_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+        queued_.fetch_add(1);
+    }
+
+    // Taking the sleep mutex orders this wake-up after any worker that is
+    // about to re-check `queued_` and go to sleep.
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    workAvailable_.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    allDone_.wait(lock, [this] { return pending_.load() == 0; });
+
+    std::lock_guard<std::mutex> errorLock(errorMutex_);
+    if (firstError_)
+    {
+        std::exception_ptr error = firstError_;
+        firstError_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+bool ThreadPool::popTask(unsigned index, std::function<void()> &task)
+{
+    // Own queue first, newest task (depth-first, cache friendly)
+    {
+        Queue &own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest task from another worker (largest remaining subtree)
+    for (size_t offset = 1; offset < queues_.size(); ++offset)
+    {
+        Queue &victim = *queues_[(index + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned index)
+{
+    tlsPool = this;
+    tlsWorker = static_cast<int>(index);
+
+    for (;;)
+    {
+        std::function<void()> task;
+        if (popTask(index, task))
+        {
+            queued_.fetch_sub(1);
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex_);
+                if (!firstError_)
+                    firstError_ = std::current_exception();
+            }
+
+            if (pending_.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex_);
+                allDone_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        workAvailable_.wait(lock, [this] { return stopping_ || queued_.load() > 0; });
+        if (stopping_ && queued_.load() == 0)
+            return;
+    }
+}
@@ -0,0 +1,262 @@
+/**
+ * @file tokenCluster.cpp
+ * @brief Implementation of trigram-based token clustering.
+ *
+ * @see tokenCluster.hpp
+ */
+
+#include "tokenCluster.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+    /// Union-find over token ids, with path halving.
+    class DisjointSets
+    {
+    public:
+        explicit DisjointSets(std::size_t n) : parent_(n) { std::iota(parent_.begin(), parent_.end(), 0); }
+
+        std::size_t find(std::size_t x)
+        {
+            while (parent_[x] != x)
+                x = parent_[x] = parent_[parent_[x]];
+            return x;
+        }
+
+        void unite(std::size_t a, std::size_t b)
+        {
+            a = find(a);
+            b = find(b);
+            if (a != b)
+                parent_[std::max(a, b)] = std::min(a, b);
+        }
+
+    private:
+        std::vector<std::size_t> parent_;
+    };
+
+    /// Sorted, distinct trigrams of `token`, padded with a space on both sides.
+    void trigrams(std::string_view token, std::vector<std::uint32_t> &out)
+    {
+        out.clear();
+        auto at = [&](std::size_t i) -> std::uint32_t {
+            return i == 0 || i > token.size() ? ' ' : static_cast<unsigned char>(token[i - 1]);
+        };
+        for (std::size_t i = 0; i + 3 <= token.size() + 2; ++i)
+            out.push_back((at(i) << 16) | (at(i + 1) << 8) | at(i + 2));
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    /// FNV-1a hash of the digits of `token`, in order; equal for tokens that pass `sameDigits()`.
+    std::uint32_t digitHash(std::string_view token)
+    {
+        std::uint32_t hash = 2166136261u;
+        for (char c : token)
+            if (c >= '0' && c <= '9')
+                hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+        return hash;
+    }
+
+    /// True when both tokens contain the same digits in the same order.
+    bool sameDigits(std::string_view a, std::string_view b)
+    {
+        std::size_t i = 0, j = 0;
+        for (;;)
+        {
+            while (i < a.size() && (a[i] < '0' || a[i] > '9'))
+                ++i;
+            while (j < b.size() && (b[j] < '0' || b[j] > '9'))
+                ++j;
+            if (i == a.size() || j == b.size())
+                return i == a.size() && j == b.size();
+            if (a[i++] != b[j++])
+                return false;
+        }
+    }
+}
+
+std::vector<TokenGroup> clusterTokens(const TokenIndex &index, std::size_t minFiles, std::size_t limit,
+                                      double minSimilarity)
+{
+    const std::size_t n = index.size();
+
+    // Trigram sets of every token, stored flat
+    std::vector<std::uint32_t> grams;
+    std::vector<std::size_t> gramStart(n + 1, 0);
+    std::vector<std::uint32_t> scratch;
+    for (std::size_t id = 0; id < n; ++id)
+    {
+        trigrams(index.token(id), scratch);
+        grams.insert(grams.end(), scratch.begin(), scratch.end());
+        gramStart[id + 1] = grams.size();
+    }
+
+    // Document frequency of every trigram
+    std::unordered_map<std::uint32_t, std::uint32_t> frequency;
+    frequency.reserve(grams.size() / 4);
+    for (std::uint32_t gram : grams)
+        ++frequency[gram];
+
+    // Prefix filter: a token similar to `id` must share one of its |A| - ceil(t|A|) + 1 rarest trigrams.
+    // Postings are also keyed by the token's digits, which similar tokens must have in common.
+    struct Posting
+    {
+        std::uint64_t key; // trigram << 32 | digit hash
+        std::uint32_t id;
+        bool operator<(const Posting &o) const { return key != o.key ? key < o.key : id < o.id; }
+    };
+    std::vector<Posting> postings;
+    std::vector<std::uint64_t> prefix;
+    std::vector<std::size_t> prefixStart(n + 1, 0);
+    for (std::size_t id = 0; id < n; ++id)
+    {
+        scratch.assign(grams.begin() + static_cast<std::ptrdiff_t>(gramStart[id]),
+                       grams.begin() + static_cast<std::ptrdiff_t>(gramStart[id + 1]));
+        std::sort(scratch.begin(), scratch.end(), [&](std::uint32_t a, std::uint32_t b) {
+            std::uint32_t fa = frequency[a], fb = frequency[b];
+            return fa != fb ? fa < fb : a < b;
+        });
+        auto keep = static_cast<std::size_t>(std::ceil(minSimilarity * static_cast<double>(scratch.size()) - 1e-9));
+        std::size_t length = std::min(scratch.size(), scratch.size() - std::min(keep, scratch.size()) + 1);
+        std::uint64_t digits = digitHash(index.token(id));
+        for (std::size_t k = 0; k < length; ++k)
+        {
+            std::uint64_t key = (static_cast<std::uint64_t>(scratch[k]) << 32) | digits;
+            prefix.push_back(key);
+            postings.push_back({key, static_cast<std::uint32_t>(id)});
+        }
+        prefixStart[id + 1] = prefix.size();
+    }
+    std::sort(postings.begin(), postings.end());
+    std::unordered_map<std::uint64_t, std::pair<std::size_t, std::size_t>> ranges;
+    ranges.reserve(postings.size() / 2);
+    for (std::size_t p = 0; p < postings.size();)
+    {
+        std::size_t end = p;
+        while (end < postings.size() && postings[end].key == postings[p].key)
+            ++end;
+        ranges.emplace(postings[p].key, std::make_pair(p, end));
+        p = end;
+    }
+
+    // Verify every candidate pair once with the exact trigram overlap
+    auto overlap = [&](std::size_t a, std::size_t b) {
+        std::size_t i = gramStart[a], j = gramStart[b], count = 0;
+        while (i < gramStart[a + 1] && j < gramStart[b + 1])
+        {
+            if (grams[i] == grams[j])
+            {
+                ++count;
+                ++i;
+                ++j;
+            }
+            else if (grams[i] < grams[j])
+            {
+                ++i;
+            }
+            else
+            {
+                ++j;
+            }
+        }
+        return count;
+    };
+
+    DisjointSets sets(n);
+    std::vector<std::size_t> seenBy(n, static_cast<std::size_t>(-1));
+    for (std::size_t id = 0; id < n; ++id)
+    {
+        std::size_t mine = gramStart[id + 1] - gramStart[id];
+        for (std::size_t k = prefixStart[id]; k < prefixStart[id + 1]; ++k)
+        {
+            auto [begin, end] = ranges.find(prefix[k])->second;
+            if (end - begin > MaxTrigramTokens)
+                continue;
+            for (std::size_t p = begin; p < end; ++p)
+            {
+                std::size_t other = postings[p].id;
+                if (other <= id || seenBy[other] == id)
+                    continue;
+                seenBy[other] = id;
+
+                std::size_t theirs = gramStart[other + 1] - gramStart[other];
+                if (static_cast<double>(std::min(mine, theirs)) < minSimilarity * static_cast<double>(std::max(mine, theirs)))
+                    continue; // lengths too different for the threshold
+                std::size_t shared = overlap(id, other);
+                double similarity = static_cast<double>(shared) / static_cast<double>(mine + theirs - shared);
+                if (similarity >= minSimilarity && sameDigits(index.token(id), index.token(other)))
+                    sets.unite(id, other);
+            }
+        }
+    }
+
+    // Collect the groups; the root is the group's smallest id, so groups come out in token order
+    std::vector<std::size_t> groupOf(n, static_cast<std::size_t>(-1));
+    std::vector<TokenGroup> groups;
+    for (std::size_t id = 0; id < n; ++id)
+    {
+        std::size_t root = sets.find(id);
+        if (groupOf[root] == static_cast<std::size_t>(-1))
+        {
+            groupOf[root] = groups.size();
+            groups.emplace_back();
+        }
+        groups[groupOf[root]].members.push_back(id);
+    }
+
+    // The folder is named after the most frequent member, then the shortest, then the first alphabetically
+    auto better = [&](std::size_t a, std::size_t b) {
+        std::string_view x = index.token(a), y = index.token(b);
+        if (index.count(a) != index.count(b))
+            return index.count(a) > index.count(b);
+        return x.size() != y.size() ? x.size() < y.size() : x < y;
+    };
+
+    std::vector<TokenGroup> result;
+    for (TokenGroup &group : groups)
+    {
+        std::size_t best = group.members.front();
+        for (std::size_t id : group.members)
+            if (better(id, best))
+                best = id;
+        group.name = index.token(best);
+
+        if (group.members.size() == 1)
+        {
+            if (index.files(best).size() < minFiles)
+                continue; // most tokens: skip the copy
+            group.files = index.files(best);
+        }
+        else
+        {
+            for (std::size_t id : group.members)
+                group.files.insert(group.files.end(), index.files(id).begin(), index.files(id).end());
+            std::sort(group.files.begin(), group.files.end());
+            group.files.erase(std::unique(group.files.begin(), group.files.end()), group.files.end());
+        }
+        if (group.files.size() >= minFiles)
+            result.push_back(std::move(group));
+    }
+
+    // Most files first, ties alphabetical; only the top `limit` are ordered
+    auto order = [](const TokenGroup &a, const TokenGroup &b) {
+        return a.files.size() != b.files.size() ? a.files.size() > b.files.size() : a.name < b.name;
+    };
+    if (limit < result.size())
+    {
+        std::partial_sort(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(limit), result.end(),
+                          order);
+        result.resize(limit);
+    }
+    else
+    {
+        std::sort(result.begin(), result.end(), order);
+    }
+    return result;
+}
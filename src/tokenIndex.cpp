@@ -0,0 +1,288 @@
+/**
+ * @file tokenIndex.cpp
+ * @brief Implementation of the name-token counter and inverted index.
+ *
+ * @see tokenIndex.hpp
+ */
+
+#include "tokenIndex.hpp"
+#include "nameKernel.hpp"
+#include "threadPool.hpp"
+
+#include <algorithm>
+#include <memory>
+
+namespace
+{
+    /// Tables smaller than this are counted on the calling thread.
+    constexpr std::size_t ParallelThreshold = 1 << 16;
+
+    std::uint64_t hashToken(std::string_view token)
+    {
+        // FNV-1a: tokens are short, so a byte loop is as fast as anything wider
+        std::uint64_t h = 1469598103934665603ull;
+        for (unsigned char c : token)
+            h = (h ^ c) * 1099511628211ull;
+        return h;
+    }
+
+    /// Range of code points folded to the same ASCII text.
+    struct Fold
+    {
+        char32_t first;
+        char32_t last;
+        const char *ascii; ///< Empty: drop the character.
+    };
+
+    /// Latin-1 Supplement and Latin Extended-A letters, combining marks and punctuation, by code point.
+    constexpr Fold Folds[] = {
+        {0x00A0, 0x00BF, " "}, {0x00C0, 0x00C5, "a"}, {0x00C6, 0x00C6, "ae"}, {0x00C7, 0x00C7, "c"}, {0x00C8, 0x00CB, "e"},
+        {0x00CC, 0x00CF, "i"}, {0x00D0, 0x00D0, "d"},  {0x00D1, 0x00D1, "n"}, {0x00D2, 0x00D6, "o"},
+        {0x00D7, 0x00D7, " "}, {0x00D8, 0x00D8, "o"}, {0x00D9, 0x00DC, "u"},  {0x00DD, 0x00DD, "y"}, {0x00DE, 0x00DE, "th"},
+        {0x00DF, 0x00DF, "ss"}, {0x00E0, 0x00E5, "a"}, {0x00E6, 0x00E6, "ae"}, {0x00E7, 0x00E7, "c"},
+        {0x00E8, 0x00EB, "e"}, {0x00EC, 0x00EF, "i"},  {0x00F0, 0x00F0, "d"}, {0x00F1, 0x00F1, "n"},
+        {0x00F2, 0x00F6, "o"}, {0x00F7, 0x00F7, " "}, {0x00F8, 0x00F8, "o"},  {0x00F9, 0x00FC, "u"}, {0x00FD, 0x00FD, "y"},
+        {0x00FE, 0x00FE, "th"}, {0x00FF, 0x00FF, "y"}, {0x0100, 0x0105, "a"}, {0x0106, 0x010D, "c"},
+        {0x010E, 0x0111, "d"}, {0x0112, 0x011B, "e"},  {0x011C, 0x0123, "g"}, {0x0124, 0x0127, "h"},
+        {0x0128, 0x0131, "i"}, {0x0132, 0x0133, "ij"}, {0x0134, 0x0135, "j"}, {0x0136, 0x0138, "k"},
+        {0x0139, 0x0142, "l"}, {0x0143, 0x014B, "n"},  {0x014C, 0x0151, "o"}, {0x0152, 0x0153, "oe"},
+        {0x0154, 0x0159, "r"}, {0x015A, 0x0161, "s"},  {0x0162, 0x0167, "t"}, {0x0168, 0x0173, "u"},
+        {0x0174, 0x0175, "w"}, {0x0176, 0x0178, "y"},  {0x0179, 0x017E, "z"}, {0x017F, 0x017F, "s"},
+        {0x0300, 0x036F, ""},  {0x2000, 0x206F, " "}, {0x3000, 0x3003, " "},
+    };
+
+    /**
+     * @brief Decode one UTF-8 sequence at `i`.
+     *
+     * @return std::size_t Bytes consumed (malformed input consumes one byte
+     *         and yields 0xFFFD).
+     */
+    std::size_t decodeUtf8(std::string_view text, std::size_t i, char32_t &cp)
+    {
+        auto c = static_cast<unsigned char>(text[i]);
+        std::size_t length = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        if (length == 1 || i + length > text.size())
+        {
+            cp = c < 0x80 ? c : 0xFFFD;
+            return 1;
+        }
+        cp = c & (0x3F >> (length - 1));
+        for (std::size_t k = 1; k < length; ++k)
+        {
+            auto next = static_cast<unsigned char>(text[i + k]);
+            if ((next & 0xC0) != 0x80)
+            {
+                cp = 0xFFFD;
+                return 1;
+            }
+            cp = (cp << 6) | (next & 0x3F);
+        }
+        return length;
+    }
+
+    /// Count the files [begin, end) of a table.
+    void countRange(const FileTable &files, std::size_t begin, std::size_t end,
+                    const std::unordered_set<std::string_view> &ignore, bool fold, TokenIndex &index)
+    {
+        NameBatch batch; // reused for every batch of stems
+        for (std::size_t first = begin; first < end; first += NameBatchSize)
+        {
+            foldStems(files, first, std::min(end, first + NameBatchSize), fold, batch);
+            for (std::size_t k = 0; k < batch.size(); ++k)
+            {
+                auto file = static_cast<std::uint32_t>(first + k);
+                auto emit = [&](std::string_view token) {
+                    if (token.size() >= 4 && ignore.find(token) == ignore.end())
+                        index.add(token, file);
+                };
+                for (std::size_t t = batch.tokenStart[k]; t < batch.tokenStart[k + 1]; ++t)
+                    emit(batch.token(t));
+
+                // Also count the whole stem, unless it was a single token already counted
+                if (batch.split[k])
+                    emit(batch.stem(k));
+            }
+        }
+    }
+}
+
+void foldName(std::string_view name, std::string &out)
+{
+    out.clear();
+    for (std::size_t i = 0; i < name.size();)
+    {
+        auto c = static_cast<unsigned char>(name[i]);
+        if (c < 0x80)
+        {
+            out.push_back(static_cast<char>((c >= 'A' && c <= 'Z') ? c | 0x20 : c));
+            ++i;
+            continue;
+        }
+
+        char32_t cp;
+        std::size_t length = decodeUtf8(name, i, cp);
+        if (cp >= 0xFF01 && cp <= 0xFF5E)
+        {
+            // Fullwidth ASCII (U+FF01..U+FF5E mirrors '!'..'~')
+            auto ascii = static_cast<unsigned char>(cp - 0xFF01 + '!');
+            out.push_back(static_cast<char>((ascii >= 'A' && ascii <= 'Z') ? ascii | 0x20 : ascii));
+        }
+        else
+        {
+            const Fold *match = nullptr;
+            for (const Fold &f : Folds)
+                if (cp >= f.first && cp <= f.last)
+                {
+                    match = &f;
+                    break;
+                }
+            if (match)
+                out.append(match->ascii);
+            else
+                out.append(name.substr(i, length));
+        }
+        i += length;
+    }
+}
+
+std::size_t TokenIndex::find(std::string_view token) const
+{
+    if (slots_.empty())
+        return npos;
+    std::uint64_t hash = hashToken(token);
+    std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        std::uint32_t slot = slots_[i];
+        if (slot == 0)
+            return npos;
+        const Entry &e = entries_[slot - 1];
+        if (e.hash == hash && this->token(slot - 1) == token)
+            return slot - 1;
+    }
+}
+
+void TokenIndex::grow()
+{
+    std::vector<std::uint32_t> slots(slots_.empty() ? 1024 : slots_.size() * 2, 0);
+    std::size_t mask = slots.size() - 1;
+    for (std::size_t id = 0; id < entries_.size(); ++id)
+    {
+        std::size_t i = entries_[id].hash & mask;
+        while (slots[i] != 0)
+            i = (i + 1) & mask;
+        slots[i] = static_cast<std::uint32_t>(id + 1);
+    }
+    slots_ = std::move(slots);
+}
+
+std::size_t TokenIndex::insert(std::string_view token, std::uint64_t hash)
+{
+    // Keep the load factor under one half
+    if ((entries_.size() + 1) * 2 > slots_.size())
+        grow();
+
+    std::size_t mask = slots_.size() - 1;
+    std::size_t i = hash & mask;
+    for (;; i = (i + 1) & mask)
+    {
+        std::uint32_t slot = slots_[i];
+        if (slot == 0)
+            break;
+        const Entry &e = entries_[slot - 1];
+        if (e.hash == hash && this->token(slot - 1) == token)
+            return slot - 1;
+    }
+
+    Entry e{hash, static_cast<std::uint32_t>(arena_.size()), static_cast<std::uint32_t>(token.size()), 0};
+    arena_.append(token);
+    entries_.push_back(e);
+    files_.emplace_back();
+    slots_[i] = static_cast<std::uint32_t>(entries_.size());
+    return entries_.size() - 1;
+}
+
+void TokenIndex::add(std::string_view token, std::uint32_t file)
+{
+    std::size_t id = insert(token, hashToken(token));
+    entries_[id].count++;
+    auto &list = files_[id];
+    if (list.empty() || list.back() != file)
+        list.push_back(file); // each file is listed once per token
+}
+
+void TokenIndex::merge(TokenIndex &&other)
+{
+    for (std::size_t id = 0; id < other.entries_.size(); ++id)
+    {
+        std::size_t mine = insert(other.token(id), other.entries_[id].hash);
+        entries_[mine].count += other.entries_[id].count;
+        auto &list = files_[mine];
+        auto &theirs = other.files_[id];
+        if (list.empty())
+            list = std::move(theirs);
+        else
+            list.insert(list.end(), theirs.begin(), theirs.end());
+    }
+    other = TokenIndex();
+}
+
+TokenIndex buildTokenIndex(const FileTable &files,
+                           const std::unordered_set<std::string> &ignore,
+                           unsigned threads, bool fold)
+{
+    std::unordered_set<std::string_view> ignoreViews(ignore.begin(), ignore.end());
+
+    if (threads == 0)
+        threads = ThreadPool::defaultThreads();
+    if (threads <= 1 || files.size() < ParallelThreshold)
+    {
+        TokenIndex index;
+        countRange(files, 0, files.size(), ignoreViews, fold, index);
+        return index;
+    }
+
+    // Consecutive shards, counted in parallel and merged in order
+    std::size_t shards = std::min<std::size_t>(threads * 4, files.size() / (ParallelThreshold / 4));
+    std::vector<TokenIndex> parts(shards);
+    {
+        ThreadPool pool(threads);
+        for (std::size_t s = 0; s < shards; ++s)
+        {
+            pool.submit([&, s] {
+                countRange(files, files.size() * s / shards, files.size() * (s + 1) / shards, ignoreViews, fold,
+                           parts[s]);
+            });
+        }
+        pool.wait();
+    }
+
+    TokenIndex index = std::move(parts[0]);
+    for (std::size_t s = 1; s < shards; ++s)
+        index.merge(std::move(parts[s]));
+    return index;
+}
+
+std::vector<TokenCount> commonTokens(const TokenIndex &index, int minCount, std::size_t limit)
+{
+    std::vector<TokenCount> common;
+    for (std::size_t id = 0; id < index.size(); ++id)
+        if (index.count(id) >= minCount)
+            common.push_back({index.token(id), index.count(id), id});
+
+    // Most frequent first, ties alphabetical; only the top `limit` are ordered
+    auto order = [](const TokenCount &a, const TokenCount &b) {
+        return a.count != b.count ? a.count > b.count : a.token < b.token;
+    };
+    if (limit < common.size())
+    {
+        std::partial_sort(common.begin(), common.begin() + static_cast<std::ptrdiff_t>(limit), common.end(),
+                          order);
+        common.resize(limit);
+    }
+    else
+    {
+        std::sort(common.begin(), common.end(), order);
+    }
+    return common;
+}
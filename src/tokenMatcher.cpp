@@ -0,0 +1,156 @@
+/**
+ * @file tokenMatcher.cpp
+ * @brief Implementation of the case-folding Aho–Corasick matcher.
+ *
+ * @see tokenMatcher.hpp
+ */
+
+#include "tokenMatcher.hpp"
+#include "json.hpp"
+
+#include <fstream>
+
+namespace
+{
+    unsigned char fold(unsigned char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c | 0x20) : c;
+    }
+}
+
+TokenMatcher::TokenMatcher(const std::vector<std::string> &tokens, MatchPolicy policy) : policy_(policy)
+{
+    lengths_.reserve(tokens.size());
+    for (const auto &token : tokens)
+        lengths_.push_back(static_cast<std::uint32_t>(token.size()));
+
+    // Alphabet: one class per distinct folded byte; class 0 stands for every other byte
+    for (const auto &token : tokens)
+        for (unsigned char c : token)
+        {
+            unsigned char f = fold(c);
+            if (class_[f] == 0)
+            {
+                class_[f] = static_cast<std::uint8_t>(classes_++);
+                if (f >= 'a' && f <= 'z')
+                    class_[f & ~0x20] = class_[f];
+            }
+        }
+    for (const auto &token : tokens)
+        if (!token.empty())
+        {
+            unsigned char f = fold(static_cast<unsigned char>(token[0]));
+            starts_[f] = true;
+            if (f >= 'a' && f <= 'z')
+                starts_[f & ~0x20] = true;
+        }
+
+    // Trie; a zero transition means "no child" while building (the root is never a child)
+    next_.assign(classes_, 0);
+    std::vector<std::uint32_t> output(1, NoMatch);
+    for (std::uint32_t t = 0; t < tokens.size(); ++t)
+    {
+        if (tokens[t].empty())
+            continue;
+        std::uint32_t state = 0;
+        for (unsigned char c : tokens[t])
+        {
+            std::size_t slot = state * classes_ + class_[c];
+            if (next_[slot] == 0)
+            {
+                next_[slot] = static_cast<std::uint32_t>(output.size());
+                output.push_back(NoMatch);
+                next_.resize(next_.size() + classes_, 0);
+            }
+            state = next_[slot];
+        }
+        if (better(t, output[state]))
+            output[state] = t;
+    }
+
+    // Breadth-first: suffix links, best outputs, and the missing transitions (dense DFA)
+    const std::size_t states = output.size();
+    std::vector<std::uint32_t> fail(states, 0);
+    best_.assign(states, NoMatch);
+    std::vector<std::uint32_t> queue;
+    queue.reserve(states);
+    queue.push_back(0);
+    for (std::size_t head = 0; head < queue.size(); ++head)
+    {
+        std::uint32_t s = queue[head];
+        for (std::size_t c = 0; c < classes_; ++c)
+        {
+            std::uint32_t &slot = next_[s * classes_ + c];
+            std::uint32_t fallback = s == 0 ? 0 : next_[fail[s] * classes_ + c];
+            if (slot == 0)
+            {
+                slot = fallback;
+                continue;
+            }
+            std::uint32_t child = slot;
+            fail[child] = fallback;
+            best_[child] = better(output[child], best_[fallback]) ? output[child] : best_[fallback];
+            queue.push_back(child);
+        }
+    }
+}
+
+bool TokenMatcher::better(std::uint32_t candidate, std::uint32_t current) const
+{
+    if (candidate == NoMatch)
+        return false;
+    if (current == NoMatch)
+        return true;
+    if (policy_ == MatchPolicy::Longest && lengths_[candidate] != lengths_[current])
+        return lengths_[candidate] > lengths_[current];
+    return candidate < current;
+}
+
+std::uint32_t TokenMatcher::match(std::string_view text) const
+{
+    std::uint32_t result = NoMatch;
+    std::uint32_t state = 0;
+    const auto *p = reinterpret_cast<const unsigned char *>(text.data());
+    const auto *end = p + text.size();
+    while (p < end)
+    {
+        if (state == 0)
+        {
+            // Prefilter: nothing can start here, skip without touching the table
+            while (p < end && !starts_[*p])
+                ++p;
+            if (p == end)
+                break;
+        }
+        state = next_[state * classes_ + class_[*p++]];
+        std::uint32_t found = best_[state];
+        if (better(found, result))
+        {
+            result = found;
+            if (policy_ == MatchPolicy::First && result == 0)
+                break; // nothing can beat the first token
+        }
+    }
+    return result;
+}
+
+bool loadTokenFile(const fs::path &file, std::vector<std::string> &tokens)
+{
+    std::ifstream in(file);
+    if (!in.is_open())
+        return false;
+    try
+    {
+        nlohmann::json j = nlohmann::json::parse(in);
+        const nlohmann::json &list = j.is_object() ? j.at("tokens") : j;
+        if (!list.is_array())
+            return false;
+        for (const auto &token : list)
+            tokens.push_back(token.get<std::string>());
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
@@ -0,0 +1,181 @@
+/**
+ * @file watcher.cpp
+ * @brief Implementation of the directory change watcher.
+ *
+ * @see watcher.hpp
+ */
+
+#include "watcher.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+#ifdef _WIN32
+
+static_assert(sizeof(OVERLAPPED) <= 64, "overlapped_ storage too small");
+
+DirectoryWatcher::DirectoryWatcher(const fs::path &directory) : directory_(directory), buffer_(1 << 16)
+{
+    HANDLE handle = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+    handle_ = handle;
+    event_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    ok_ = event_ && arm();
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+    if (handle_)
+    {
+        CancelIo(static_cast<HANDLE>(handle_));
+        CloseHandle(static_cast<HANDLE>(handle_));
+    }
+    if (event_)
+        CloseHandle(static_cast<HANDLE>(event_));
+}
+
+/// Queue the next asynchronous read of change records.
+bool DirectoryWatcher::arm()
+{
+    auto *overlapped = reinterpret_cast<OVERLAPPED *>(overlapped_);
+    *overlapped = OVERLAPPED{};
+    overlapped->hEvent = static_cast<HANDLE>(event_);
+    ResetEvent(overlapped->hEvent);
+    return ReadDirectoryChangesW(static_cast<HANDLE>(handle_), buffer_.data(), static_cast<DWORD>(buffer_.size()),
+                                 FALSE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE, nullptr,
+                                 overlapped, nullptr) != 0;
+}
+
+bool DirectoryWatcher::wait(std::vector<std::string> &names, int timeoutMs)
+{
+    if (!ok_)
+        return false;
+    if (WaitForSingleObject(static_cast<HANDLE>(event_), static_cast<DWORD>(timeoutMs)) != WAIT_OBJECT_0)
+        return true;
+
+    DWORD bytes = 0;
+    if (!GetOverlappedResult(static_cast<HANDLE>(handle_), reinterpret_cast<OVERLAPPED *>(overlapped_), &bytes,
+                             FALSE))
+        return ok_ = false;
+
+    if (bytes == 0)
+    {
+        overflow_ = true; // the change buffer overflowed
+    }
+    else
+    {
+        const char *p = buffer_.data();
+        for (;;)
+        {
+            const auto *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(p);
+            if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_RENAMED_NEW_NAME ||
+                info->Action == FILE_ACTION_MODIFIED)
+                names.push_back(fs::path(std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR))).string());
+            if (info->NextEntryOffset == 0)
+                break;
+            p += info->NextEntryOffset;
+        }
+    }
+    return ok_ = arm();
+}
+
+#elif defined(__linux__)
+
+DirectoryWatcher::DirectoryWatcher(const fs::path &directory) : directory_(directory)
+{
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0)
+        return;
+    // Only completed writes and renames: a file is never picked up half-written
+    ok_ = inotify_add_watch(fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR) >= 0;
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+}
+
+bool DirectoryWatcher::wait(std::vector<std::string> &names, int timeoutMs)
+{
+    if (!ok_)
+        return false;
+
+    pollfd pfd{fd_, POLLIN, 0};
+    int ready = ::poll(&pfd, 1, timeoutMs);
+    if (ready < 0)
+        return errno == EINTR;
+    if (ready == 0)
+        return true;
+
+    alignas(inotify_event) char buffer[1 << 16];
+    for (;;)
+    {
+        ssize_t n = ::read(fd_, buffer, sizeof buffer);
+        if (n < 0)
+            return errno == EAGAIN || errno == EINTR;
+        for (ssize_t offset = 0; offset < n;)
+        {
+            const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            if (event->mask & IN_Q_OVERFLOW)
+                overflow_ = true;
+            else if (event->mask & IN_IGNORED)
+                ok_ = false; // the directory itself went away
+            else if (event->len > 0 && !(event->mask & IN_ISDIR))
+                names.emplace_back(event->name);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+        if (!ok_)
+            return false;
+    }
+}
+
+#else
+
+DirectoryWatcher::DirectoryWatcher(const fs::path &directory) : directory_(directory)
+{
+    std::error_code ec;
+    lastWrite_ = fs::last_write_time(directory, ec);
+    ok_ = !ec;
+}
+
+DirectoryWatcher::~DirectoryWatcher() = default;
+
+bool DirectoryWatcher::wait(std::vector<std::string> &, int timeoutMs)
+{
+    if (!ok_)
+        return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+
+    std::error_code ec;
+    fs::file_time_type now = fs::last_write_time(directory_, ec);
+    if (ec)
+        return ok_ = false;
+    if (now != lastWrite_)
+    {
+        lastWrite_ = now;
+        overflow_ = true; // no per-file events here: rescan
+    }
+    return true;
+}
+
+#endif
+
+bool DirectoryWatcher::takeOverflow()
+{
+    bool overflow = overflow_;
+    overflow_ = false;
+    return overflow;
+}